@@ -1,12 +1,62 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <array>
 #include <limits>
 #include <fstream>
 #include <string.h>
 #include <stdexcept>
 #include <chrono>
 #include <ctime>
+#include <memory>
+#include <sstream>
+#include <cstdint>
+#include <string_view>
+#include <variant>
+#include <charconv>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <unordered_set>
+#include <unordered_map>
+#include <map>
+#include <regex>
+#include <atomic>
+#include <exception>
+#include <type_traits>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <iomanip>
+#include <cmath>
+#include <cstdio>
+#include <cerrno>
+#include <cctype>
+
+// Nucleele SIMD pentru CalculusStep sunt compilate doar pe x86 cu GCC/Clang (alegerea se face la rulare)
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define FLOW_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -14,641 +64,11319 @@ using namespace std;
 string getCurrentDateTime() {
     auto now = chrono::system_clock::now();
     time_t currentTime = chrono::system_clock::to_time_t(now);
+    tm local;
+#ifdef _WIN32
+    localtime_s(&local, &currentTime);
+#else
+    localtime_r(&currentTime, &local);  // localtime folosește un buffer static, iar serverul creează flow-uri în paralel
+#endif
     char buffer[80];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&currentTime));
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
     return buffer;
 }
 
-// Clasa abstractă pentru un pas în flow (abstract class Step)
-class Step {
-    public:
-        virtual void getStepInfo() = 0;
-        virtual string getStepName() = 0;
-        virtual void writeToFile(ofstream &file) const = 0;
-        virtual ~Step() {}
+// Tipurile de pași, în ordinea din meniul de creare. Valoarea numerică este
+// scrisă în catalogul binar, deci ordinea nu trebuie schimbată.
+enum class StepKind : uint8_t {
+    Title,
+    Text,
+    TextInput,
+    NumberInput,
+    Calculus,
+    TextFileInput,
+    CSVFileInput,
+    Output,
+    Display,
+    End
 };
 
-// Pasul de sfârșit (EndStep) - derivat din clasa abstractă Step
-class EndStep : public Step {
-public:
-    string getStepName() override {
-        return "End Step";
-    }
+const size_t stepKindCount = 10;
+
+// Datele fixe ale unui tip de pas. Textele sunt literali, deci string_view-urile nu alocă și
+// rămân valide pe toată durata programului.
+struct StepTypeInfo {
+    StepKind kind;
+    string_view keyword;      // Numele scurt, folosit în modul batch, la --mix și în căutarea flow-urilor
+    string_view name;         // Numele afișat (Step::getStepName)
+    string_view description;  // Afișată în meniul de creare
+};
+
+// Registrul tipurilor de pași, în ordinea StepKind. Construirea pașilor (din câmpurile unei linii
+// batch sau din formatul binar) este în stepFactories, generat din StepValue.
+constexpr StepTypeInfo stepTypeTable[] = {
+    {StepKind::Title, "Title", "Title step", "un titlu si un subtitlu"},
+    {StepKind::Text, "Text", "Text step", "un titlu si un text"},
+    {StepKind::TextInput, "TextInput", "Text input step", "cere un text, cu descrierea lui"},
+    {StepKind::NumberInput, "NumberInput", "Number input step", "cere un numar, cu descrierea lui"},
+    {StepKind::Calculus, "Calculus", "Calculus step", "o operatie sau o expresie peste valori, pasi, o coloana CSV sau un fisier text"},
+    {StepKind::TextFileInput, "TextFileInput", "Text File Input Step", "un fisier .txt, analizat: linii, cuvinte, potriviri"},
+    {StepKind::CSVFileInput, "CSVFileInput", "CSV File Input Step", "un fisier .csv, incarcat ca tabel"},
+    {StepKind::Output, "Output", "Output Step", "un fisier text cu informatii din pasii anteriori sau dintr-un sablon"},
+    {StepKind::Display, "Display", "Display Step", "afiseaza continutul unui pas text sau CSV anterior"},
+    {StepKind::End, "End", "End Step", "sfarsitul flow-ului"},
+};
 
-    void getStepInfo() override {
-        cout << "Sfarsitul flow-ului." << endl;
+constexpr bool stepTypeTableMatchesKinds() {
+    for (size_t k = 0; k < stepKindCount; ++k) {
+        if (static_cast<size_t>(stepTypeTable[k].kind) != k) {
+            return false;
+        }
     }
+    return true;
+}
+
+static_assert(sizeof(stepTypeTable) / sizeof(stepTypeTable[0]) == stepKindCount, "stepTypeTable trebuie sa contina toate tipurile din StepKind");
+static_assert(stepTypeTableMatchesKinds(), "Ordinea din stepTypeTable trebuie sa fie aceeasi cu StepKind");
 
-    void writeToFile(ofstream &file) const {
-        file << "EndStep" << endl;
+constexpr const StepTypeInfo &stepTypeInfo(StepKind kind) {
+    return stepTypeTable[static_cast<size_t>(kind)];
+}
+
+// Numele afișat pentru fiecare tip de pas (același cu Step::getStepName)
+constexpr string_view stepKindName(StepKind kind) {
+    return stepTypeInfo(kind).name;
+}
+
+// Numele scurt al tipului de pas, folosit în modul batch, la --mix și în căutarea flow-urilor
+constexpr string_view stepKindKeyword(StepKind kind) {
+    return stepTypeInfo(kind).keyword;
+}
+
+// Returnează false dacă numele nu este al unui tip de pas
+bool parseStepKindKeyword(string_view keyword, StepKind &kind) {
+    for (const StepTypeInfo &type : stepTypeTable) {
+        if (keyword == type.keyword) {
+            kind = type.kind;
+            return true;
+        }
     }
-};
+    return false;
+}
 
-class TextFileInputStep : public Step {
+// Scrie valori binare (little-endian, ca pe platformele suportate) la finalul unui buffer
+class BinaryWriter {
 private:
-    string fileName;
-    string description;
+    string &buffer;
 
 public:
-    TextFileInputStep(const string &fileName) : fileName(fileName) {}
+    explicit BinaryWriter(string &out) : buffer(out) {}
 
-    string getStepName() override {
-        return "Text File Input Step";
+    template <typename T>
+    void write(T value) {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
     }
 
-    void specifyDescription() {
-        cout << "Introduceti descrierea pentru pasul '" << fileName << "': ";
-        cin.ignore();  // Ignorăm orice caracter rămas în buffer
-        getline(cin, description);
+    void writeString(const string &text) {
+        write<uint32_t>(static_cast<uint32_t>(text.size()));
+        buffer.append(text);
     }
+};
+
+// Citește valorile scrise de BinaryWriter; aruncă excepție dacă datele sunt trunchiate
+class BinaryReader {
+private:
+    const char *position;
+    const char *end;
+
+public:
+    BinaryReader(const char *data, size_t size) : position(data), end(data + size) {}
 
-    void getStepInfo() override {
-        cout << "Fisier: " << fileName << endl;
-        cout << "Descriere: " << description << endl;
+    template <typename T>
+    T read() {
+        T value;
+        memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
     }
 
-    const string &getFileName() const {
-        return fileName;
+    string_view readView(size_t size) {
+        return string_view(take(size), size);
     }
 
-    const string &getDescription() const {
-        return description;
+    string readString() {
+        uint32_t size = read<uint32_t>();
+        return string(readView(size));
     }
 
-    void createFile() const {
-    ofstream file(fileName + ".txt");
-    if (file.is_open()) {
-        file << description << endl;
-        file.close();
-        cout << "Fisier creat cu succes!" << endl;
-    } else {
-        // Am adăugat un bloc try-catch pentru a gestiona excepția în caz de eroare la crearea fișierului
-        try {
-            throw runtime_error("Eroare la crearea fisierului!");
-        } catch (const exception &e) {
-            cerr << e.what() << endl;
+    const char *take(size_t size) {
+        if (static_cast<size_t>(end - position) < size) {
+            throw runtime_error("Date binare trunchiate.");
         }
+        const char *data = position;
+        position += size;
+        return data;
     }
-}
+};
 
-    void writeToFile(ofstream &file) const {
-        file << "TextFileInputStep" << endl;
-        file << "Fisier: " << fileName << ".txt" << endl;
-        file << "Descriere: " << description << endl;
-    }
+// Destinația textului formatat de TextWriter. TextWriter predă textul în blocuri de câțiva KB,
+// deci apelul virtual nu apare la fiecare câmp.
+class OutputSink {
+public:
+    virtual void write(const char *data, size_t size) = 0;
+    virtual ~OutputSink() {}
 };
 
-class CSVFileInputStep : public Step {
+// Adaugă textul la finalul unui string (rapoartele, predate apoi lui AsyncFileWriter)
+class StringSink final : public OutputSink {
 private:
-    string fileName;
-    string description;
+    string &buffer;
 
 public:
-    CSVFileInputStep(const string &fileName) : fileName(fileName) {}
+    explicit StringSink(string &out) : buffer(out) {}
 
-    string getStepName() override {
-        return "CSV File Input Step";
+    void write(const char *data, size_t size) override {
+        buffer.append(data, size);
     }
+};
 
-    void specifyDescription() {
-        cout << "Introduceti descrierea pentru pasul '" << fileName << "': ";
-        cin.ignore();  // Ignorăm orice caracter rămas în buffer
-        getline(cin, description);
-    }
+// Scrie într-un ostream existent (consola, bufferul unui flow rulat în paralel)
+class StreamSink final : public OutputSink {
+private:
+    ostream &out;
+
+public:
+    explicit StreamSink(ostream &out) : out(out) {}
 
-    void getStepInfo() override {
-        cout << "Fisier: " << fileName << endl;
-        cout << "Descriere: " << description << endl;
+    void write(const char *data, size_t size) override {
+        out.write(data, static_cast<streamsize>(size));
     }
+};
 
-    const string &getFileName() const {
-        return fileName;
+// Un fișier creat de sink, cu un buffer mare: datele ajung pe disc în blocuri de 1 MB
+class FileSink final : public OutputSink {
+private:
+    static constexpr size_t bufferSize = 1 << 20;
+    FILE *file;
+    bool failed;
+
+public:
+    explicit FileSink(const string &path) : file(fopen(path.c_str(), "wb")), failed(file == nullptr) {
+        if (file != nullptr) {
+            setvbuf(file, nullptr, _IOFBF, bufferSize);
+        }
     }
 
-    const string &getDescription() const {
-        return description;
+    ~FileSink() {
+        close();
     }
 
-    void createFile() const {
-        ofstream file(fileName + ".csv");
-        if (file.is_open()) {
-            file << "Descriere: " << description << endl;
-            file.close();
-            cout << "Fisier CSV creat cu succes!" << endl;
-        } else {
-            cout << "Eroare la crearea fisierului CSV!" << endl;
+    FileSink(const FileSink &) = delete;
+    FileSink &operator=(const FileSink &) = delete;
+
+    void write(const char *data, size_t size) override {
+        if (file != nullptr && fwrite(data, 1, size, file) != size) {
+            failed = true;
         }
     }
 
-    void writeToFile(ofstream &file) const {
-        file << "TextFileInputStep" << endl;
-        file << "Fisier: " << fileName << ".csv" << endl;
-        file << "Descriere: " << description << endl;
+    // Închide fișierul; returnează false dacă deschiderea sau o scriere a eșuat
+    bool close() {
+        if (file != nullptr) {
+            failed = fclose(file) != 0 || failed;
+            file = nullptr;
+        }
+        return !failed;
     }
 };
 
-class OutputStep : public Step {
+// O zonă de memorie de dimensiune fixă (un buffer sau o mapare a unui fișier). Textul care nu mai
+// încape este ignorat, iar overflowed() devine true.
+class MemorySink final : public OutputSink {
 private:
-    string fileName;
-    size_t stepNumber;
-    string title;
+    char *data;
+    size_t capacity;
+    size_t used = 0;
+    bool overflow = false;
 
 public:
-    OutputStep(const string &fileName, size_t stepNumber, const string &title)
-        : fileName(fileName), stepNumber(stepNumber), title(title) {}
-
-    string getStepName() override {
-        return "Output Step";
-    }
-
-    void specifyInfo() {
-        cout << "Introduceti numele fisierului pentru Output Step: ";
-        cin >> fileName;
-
-        cout << "Introduceti numarul step-ului din flow pentru care doriti informatiile: ";
-        cin >> stepNumber;
+    MemorySink(char *data, size_t capacity) : data(data), capacity(capacity) {}
 
-        cout << "Introduceti titlul pentru prima linie din fisier: ";
-        cin.ignore();
-        getline(cin, title);
+    void write(const char *text, size_t size) override {
+        size_t copied = std::min(size, capacity - used);
+        memcpy(data + used, text, copied);
+        used += copied;
+        overflow = overflow || copied < size;
     }
 
-    const string &getFileName() const {
-        return fileName;
+    size_t size() const {
+        return used;
     }
 
-    void getStepInfo() override {
-        cout << "Fisier: " << fileName << endl;
-        cout << "Numar step: " << stepNumber << endl;
-        cout << "Titlu: " << title << endl;
+    bool overflowed() const {
+        return overflow;
     }
+};
 
-    void createFile(const vector<Step *> &steps) const {
-        if (stepNumber >= 1 && stepNumber <= steps.size()) {
-            ofstream file(fileName + ".txt");
-            if (file.is_open()) {
-                file << title << endl;
-
-                // Obține informațiile pentru step-ul specificat
-                steps[stepNumber - 1]->writeToFile(file);
+// Formatează text într-un OutputSink, ca un ostream fără locale și fără flush pe linie: numerele
+// sunt scrise cu to_chars, direct într-un buffer propriu, care este predat sink-ului când se umple,
+// la flush() și la distrugere. Numerele reale sunt scrise ca de ostream (6 cifre semnificative);
+// exact() scrie cea mai scurtă formă din care se citește înapoi aceeași valoare.
+class TextWriter {
+private:
+    static constexpr size_t bufferSize = 16384;
+    static constexpr size_t maxNumberSize = 32;
+    OutputSink &sink;
+    size_t used = 0;
+    char buffer[bufferSize];
 
-                file.close();
-                cout << "Fisier text creat cu succes!" << endl;
-            } else {
-                cout << "Eroare la crearea fisierului text!" << endl;
-            }
-        } else {
-            cout << "Numarul step-ului specificat nu exista in flow!" << endl;
+    char *reserve(size_t size) {
+        if (bufferSize - used < size) {
+            flush();
         }
+        return buffer + used;
     }
 
-    void writeToFile(ofstream &file) const {
-        file << "OutputStep" << endl;
-        file << "Filename: " << fileName << ".txt" << endl;
-        file << "StepNumber: " << stepNumber << endl;
-        file << "Titlu: " << title << endl;
+    template <typename T>
+    TextWriter &writeReal(T value, bool shortest) {
+        char *start = reserve(maxNumberSize);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        to_chars_result result = shortest ? to_chars(start, start + maxNumberSize, value)
+                                          : to_chars(start, start + maxNumberSize, value, chars_format::general, 6);
+        used = static_cast<size_t>(result.ptr - buffer);
+#else
+        int digits = !shortest ? 6 : is_same<T, float>::value ? 9 : 17;
+        used += static_cast<size_t>(snprintf(start, maxNumberSize, "%.*g", digits, static_cast<double>(value)));
+#endif
+        return *this;
     }
-};
-
-class NumberInputStep : public Step {
-private:
-    string description;
-    bool hasUserInput;  // Indică dacă input-ul a fost deja introdus
-    float number_input;  // Input-ul specific pasului, setat ulterior
 
 public:
-    NumberInputStep(const string &d)
-    {
-        this->description = d;
-        this->hasUserInput = false;
+    explicit TextWriter(OutputSink &sink) : sink(sink) {}
+
+    ~TextWriter() {
+        flush();
     }
 
-    string getStepName() override {
-        return "Number input step";
+    TextWriter(const TextWriter &) = delete;
+    TextWriter &operator=(const TextWriter &) = delete;
+
+    void flush() {
+        if (used > 0) {
+            sink.write(buffer, used);
+            used = 0;
+        }
     }
 
-    // Introduce descrierea pasului
-    void inputDescription() {
-        cout << "Introduceti descrierea: ";
-        cin.ignore();  // Ignorăm orice caracter rămas în buffer
-        getline(cin, description);
+    TextWriter &operator<<(string_view text) {
+        if (text.size() > bufferSize - used) {
+            flush();
+            if (text.size() >= bufferSize) {
+                sink.write(text.data(), text.size());
+                return *this;
+            }
+        }
+        memcpy(buffer + used, text.data(), text.size());
+        used += text.size();
+        return *this;
     }
 
-    // Specifică input-ul pasului
-    void specifyInput() {
-        if (!hasUserInput) {
-            cout << "Introduceti input-ul pentru pasul '" << description << "': ";
-            cin >> number_input;
-            hasUserInput = true;
+    TextWriter &operator<<(char c) {
+        if (used == bufferSize) {
+            flush();
         }
+        buffer[used++] = c;
+        return *this;
     }
 
-    float getNumberInput() const {
-        return number_input;
+    template <typename T, enable_if_t<is_integral<T>::value && !is_same<T, bool>::value && !is_same<T, char>::value, int> = 0>
+    TextWriter &operator<<(T value) {
+        char *start = reserve(maxNumberSize);
+        used = static_cast<size_t>(to_chars(start, start + maxNumberSize, value).ptr - buffer);
+        return *this;
     }
 
-    void getStepInfo() override {
-        cout << "Descriere: " << description << endl;
-        if (hasUserInput) {
-            cout << "Input :" << number_input << endl;
-        }
+    TextWriter &operator<<(float value) {
+        return writeReal(value, false);
     }
 
-    void writeToFile(ofstream &file) const {
-        file << "NumberInputStep" << endl;
-        file << "Descriere: " << description << endl;
-        if (hasUserInput) {
-            file << "Input: " << number_input << endl;
-        }
+    TextWriter &operator<<(double value) {
+        return writeReal(value, false);
+    }
+
+    template <typename T>
+    TextWriter &exact(T value) {
+        static_assert(is_floating_point<T>::value, "exact() este pentru numere reale");
+        return writeReal(value, true);
     }
 };
 
-class CalculusStep : public Step {
-private:
-    int steps;
-    string operation;
-    vector<float> inputs;
+// Mărește un contor atomic. Un contor cu un singur scriitor (shard-ul unui fir) este actualizat
+// prin load + store, fără instrucțiuni cu lock; celelalte folosesc fetch_add.
+template <bool SingleWriter>
+void increaseCounter(atomic<uint64_t> &counter, uint64_t value) {
+    if constexpr (SingleWriter) {
+        counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+    } else {
+        counter.fetch_add(value, memory_order_relaxed);
+    }
+}
 
+// Histogramă de latențe pe puteri de 2, în nanosecunde: bucket-ul b numără duratele din
+// [2^b, 2^(b+1)). Actualizarea este o singură incrementare, fără blocare și fără alocări.
+template <bool SingleWriter>
+class LatencyHistogram {
 public:
-    CalculusStep(int s) : steps(s) {}
+    static constexpr size_t bucketCount = 40;  // Ultimul bucket cuprinde și duratele mai mari
 
-    float addition() const {
-        float result = 0;
-        for (float value : inputs) {
-            result += value;
-        }
-        return result;
+    void record(uint64_t nanoseconds) {
+        increaseCounter<SingleWriter>(buckets[bucketOf(nanoseconds)], 1);
     }
 
-    float subtraction() const {
-        if (inputs.size() >= 2) {
-            float result = inputs[0];
-            for (size_t i = 1; i < inputs.size(); ++i) {
-                result -= inputs[i];
-            }
-            return result;
-        } else {
-            cout << "Operatia de scadere necesita cel putin doua valori." << endl;
-            return 0;
+    void addTo(uint64_t *counts) const {
+        for (size_t b = 0; b < bucketCount; ++b) {
+            counts[b] += buckets[b].load(memory_order_relaxed);
         }
     }
 
-    float multiplication() const {
-        float result = 1;
-        for (float value : inputs) {
-            result *= value;
+    // Limita superioară (ns) a bucket-ului în care cade percentila q (0..1); 0 fără valori
+    static uint64_t percentile(const uint64_t *counts, double q) {
+        uint64_t total = 0;
+        for (size_t b = 0; b < bucketCount; ++b) {
+            total += counts[b];
         }
-        return result;
-    }
-
-    float division() const {
-        if (inputs.size() >= 2) {
-            float result = inputs[0];
-            for (size_t i = 1; i < inputs.size(); ++i) {
-                if (inputs[i] != 0) {
-                    result /= inputs[i];
-                } else {
-                    cout << "Impartirea la 0 nu este permisa." << endl;
-                    return 0;
-                }
-            }
-            return result;
-        } else {
-            cout << "Operatia de impartire necesita cel putin doua valori." << endl;
+        if (total == 0) {
             return 0;
         }
-    }
-
-    float min() const {
-        if (!inputs.empty()) {
-            float result = inputs[0];
-            for (size_t i = 1; i < inputs.size(); ++i) {
-                result = std::min(result, inputs[i]);
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(q * static_cast<double>(total))));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < bucketCount; ++b) {
+            seen += counts[b];
+            if (seen >= rank) {
+                return uint64_t(1) << (b + 1);
             }
-            return result;
-        } else {
-            cout << "Operatia de minim necesita cel putin o valoare." << endl;
-            return 0;
         }
+        return uint64_t(1) << bucketCount;
     }
 
-    float max() const {
-        if (!inputs.empty()) {
-            float result = inputs[0];
-            for (size_t i = 1; i < inputs.size(); ++i) {
-                result = std::max(result, inputs[i]);
-            }
-            return result;
-        } else {
-            cout << "Operatia de maxim necesita cel putin o valoare." << endl;
-            return 0;
+private:
+    atomic<uint64_t> buckets[bucketCount] = {};
+
+    static size_t bucketOf(uint64_t nanoseconds) {
+#if defined(__GNUC__) || defined(__clang__)
+        size_t bucket = nanoseconds > 1 ? static_cast<size_t>(63 - __builtin_clzll(nanoseconds)) : 0;
+#else
+        size_t bucket = 0;
+        while (nanoseconds > 1) {
+            nanoseconds >>= 1;
+            ++bucket;
         }
+#endif
+        return std::min(bucket, bucketCount - 1);
     }
+};
 
-    float performCalculation() const {
-        if (operation == "+") {
-            return addition();
-        } else if (operation == "-") {
-            return subtraction();
-        } else if (operation == "*") {
-            return multiplication();
-        } else if (operation == "/") {
-            return division();
-        } else if (operation == "min") {
-            return min();
-        } else if (operation == "max") {
-            return max();
-        } else {
-            cout << "Operatie necunoscuta." << endl;
-            return 0;
+// Contoarele unei categorii de evenimente (un tip de pas, o operație cu fișiere sau un flow)
+template <bool SingleWriter>
+struct BasicEventCounters {
+    atomic<uint64_t> events{0};
+    atomic<uint64_t> errors{0};
+    atomic<uint64_t> skips{0};
+    atomic<uint64_t> nanoseconds{0};
+    atomic<uint64_t> bytesRead{0};
+    atomic<uint64_t> bytesWritten{0};
+    LatencyHistogram<SingleWriter> latency;
+
+    void record(uint64_t elapsed, bool failed = false) {
+        increaseCounter<SingleWriter>(events, 1);
+        increaseCounter<SingleWriter>(nanoseconds, elapsed);
+        if (failed) {
+            increaseCounter<SingleWriter>(errors, 1);
         }
+        latency.record(elapsed);
     }
 
-    void specifyOperation() {
-        cout << "Introduceti operatia pentru pasul 'Calculul' (+, -, *, /, min, max): ";
-        cin >> operation;
+    void skip() {
+        increaseCounter<SingleWriter>(skips, 1);
     }
 
-    void specifyInput() {
-        cout << "Introduceti valorile pentru pasul 'Calculul':" << endl;
-        for (int i = 0; i < steps; ++i) {
-            float inputValue;
-            cout << "Valoare pentru pasul " << (i + 1) << ": ";
-            cin >> inputValue;
-            inputs.push_back(inputValue);
-        }
+    void addBytesRead(uint64_t bytes) {
+        increaseCounter<SingleWriter>(bytesRead, bytes);
     }
 
-    const vector<float>& getInputs() const {
-        return inputs;
+    void addBytesWritten(uint64_t bytes) {
+        increaseCounter<SingleWriter>(bytesWritten, bytes);
     }
+};
 
-    void getStepInfo() override {
-        cout << "Operatie: " << operation << endl;
-        cout << "Valori introduse:";
-        for (const float &value : inputs) {
-            cout << " " << value;
-        }
-        cout << endl;
+using EventCounters = BasicEventCounters<true>;         // În shard-ul unui fir
+using SharedEventCounters = BasicEventCounters<false>;  // Actualizate din mai multe fire (rulările unui flow)
+
+// Valorile adunate ale unor EventCounters, pentru raportare
+struct CounterTotals {
+    uint64_t events = 0;
+    uint64_t errors = 0;
+    uint64_t skips = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t latency[LatencyHistogram<true>::bucketCount] = {};
+
+    template <bool SingleWriter>
+    void add(const BasicEventCounters<SingleWriter> &counters) {
+        events += counters.events.load(memory_order_relaxed);
+        errors += counters.errors.load(memory_order_relaxed);
+        skips += counters.skips.load(memory_order_relaxed);
+        nanoseconds += counters.nanoseconds.load(memory_order_relaxed);
+        bytesRead += counters.bytesRead.load(memory_order_relaxed);
+        bytesWritten += counters.bytesWritten.load(memory_order_relaxed);
+        counters.latency.addTo(latency);
     }
 
-    string getStepName() override {
-    return "Calculus step";
+    uint64_t percentile(double q) const {
+        return LatencyHistogram<true>::percentile(latency, q);
     }
+};
 
-    void writeToFile(ofstream &file) const {
-        file << "CalculusStep" << endl;
-        file << "Operatie: " << operation << endl;
-        file << "Valori introduse:";
-        for (const float &value : inputs) {
-            file << " " << value;
+// Timpul petrecut de un flow în pasul de pe o anumită poziție
+struct StepTiming {
+    atomic<uint64_t> runs{0};
+    atomic<uint64_t> errors{0};
+    atomic<uint64_t> nanoseconds{0};
+
+    void record(uint64_t elapsed, bool failed) {
+        runs.fetch_add(1, memory_order_relaxed);
+        nanoseconds.fetch_add(elapsed, memory_order_relaxed);
+        if (failed) {
+            errors.fetch_add(1, memory_order_relaxed);
         }
-        file << endl;
     }
 };
 
-// Clasa principală pentru manipularea flow-urilor
-class Flow {
+// Statisticile unui flow, după nume: rulările complete și timpul fiecărui pas. Tabloul de pași
+// este obținut o dată pe rulare; dacă flow-ul crește, tabloul este înlocuit, iar valorile sunt copiate.
+class FlowCounters {
+public:
+    SharedEventCounters runs;
+
+    shared_ptr<StepTiming[]> stepTimings(size_t count) {
+        lock_guard<mutex> lock(stepsMutex);
+        if (count > stepCount) {
+            shared_ptr<StepTiming[]> grown(new StepTiming[count]);
+            for (size_t i = 0; i < stepCount; ++i) {
+                grown[i].runs.store(steps[i].runs.load(memory_order_relaxed), memory_order_relaxed);
+                grown[i].errors.store(steps[i].errors.load(memory_order_relaxed), memory_order_relaxed);
+                grown[i].nanoseconds.store(steps[i].nanoseconds.load(memory_order_relaxed), memory_order_relaxed);
+            }
+            steps = move(grown);
+            stepCount = count;
+        }
+        return steps;
+    }
+
+    // Tabloul curent și lungimea lui, pentru raportare
+    pair<shared_ptr<StepTiming[]>, size_t> snapshot() const {
+        lock_guard<mutex> lock(stepsMutex);
+        return {steps, stepCount};
+    }
+
 private:
-    string name;
-    vector<Step *> steps;
-    vector<string> stepNames;
-    vector<float> number_Inputs;
-    vector<float> inputs;
-    bool hasEndStep;
+    mutable mutex stepsMutex;
+    shared_ptr<StepTiming[]> steps;
+    size_t stepCount = 0;
+};
 
-public: 
-    Flow(const string &n) : name(n) {
-        hasEndStep = false;
+// Operațiile măsurate în afara execuției pașilor
+enum class AnalyticsOperation : uint8_t {
+    FileCreation,        // Rapoarte Output și fișiere create de pașii de intrare
+    FileWrite,           // Scrierea efectivă pe firele AsyncFileWriter
+    CsvLoad,             // Maparea și indexarea unui fișier CSV
+    CalculusEvaluation,  // Citirea valorilor și calculul unui pas Calculus
+    Display,             // Afișarea conținutului unui fișier
+    TextAnalysis         // Maparea și analiza unui fișier text
+};
+
+const size_t analyticsOperationCount = 6;
+
+const char *analyticsOperationName(AnalyticsOperation operation) {
+    switch (operation) {
+        case AnalyticsOperation::FileCreation: return "file_creation";
+        case AnalyticsOperation::FileWrite: return "file_write";
+        case AnalyticsOperation::CsvLoad: return "csv_load";
+        case AnalyticsOperation::CalculusEvaluation: return "calculus_evaluation";
+        case AnalyticsOperation::Display: return "display";
+        case AnalyticsOperation::TextAnalysis: return "text_analysis";
     }
+    return "unknown";
+}
 
-    string getFlowName() const {
-        return name;
+// Identificatorii flow-urilor, unici în proces. Numele unui flow conține data creării, deci nu poate
+// identifica flow-ul în contoare; id-ul rămâne același cât timp flow-ul există.
+atomic<uint64_t> nextFlowId{1};
+
+// Rezervă `count` id-uri consecutive și îl returnează pe primul
+uint64_t reserveFlowIds(uint64_t count) {
+    return nextFlowId.fetch_add(count, memory_order_relaxed);
+}
+
+// Instrumentarea aplicației: execuția și afișarea pașilor pe tipuri, operațiile cu fișiere și
+// rulările fiecărui flow. Evenimentele actualizează doar contoare atomice, fără alocări. Contoarele
+// globale sunt împărțite pe fire: fiecare fir primește la primul eveniment propriul shard, în care
+// doar el scrie, iar raportarea adună shard-urile. Astfel un eveniment nu folosește instrucțiuni
+// cu lock și firele pool-ului nu își invalidează reciproc cache-ul. Un flow își găsește contoarele
+// după id o dată pe rulare, într-un tabel împărțit pe mai multe mutex-uri. Contoarele unui flow
+// șters sunt eliminate, iar fiecare parte a tabelului păstrează cel mult flowsPerStripe flow-uri:
+// la depășire pleacă flow-ul cu id-ul cel mai mic, adică cel creat cel mai demult.
+class FlowAnalytics {
+public:
+    static constexpr size_t stripeCount = 16;
+    static constexpr size_t flowsPerStripe = 256;
+
+    // Contoarele firului curent
+    EventCounters &stepExecution(StepKind kind) {
+        return localShard().executions[static_cast<size_t>(kind)];
     }
 
-    const vector<Step *> &getSteps() const {
-        return steps;
+    EventCounters &stepInfo(StepKind kind) {
+        return localShard().infos[static_cast<size_t>(kind)];
     }
 
-    void addStep(Step *newStep) {
-    if (hasEndStep && dynamic_cast<EndStep *>(newStep)) {
-        cout << "Un flow poate avea doar un End Step. Nu se poate adauga End Step suplimentar." << endl;
-        delete newStep; // Eliberăm memoria alocată pentru EndStep
-        return;
+    EventCounters &operation(AnalyticsOperation operation) {
+        return localShard().operations[static_cast<size_t>(operation)];
     }
 
-    if (NumberInputStep *numberInputStep = dynamic_cast<NumberInputStep *>(newStep)) {
-        number_Inputs.push_back(numberInputStep->getNumberInput());
-    } else if (CalculusStep *calculusStep = dynamic_cast<CalculusStep *>(newStep)) {
-        for (float value : calculusStep->getInputs()) {
-            inputs.push_back(value);
+    // Contoarele flow-ului cu id-ul dat, create la prima rulare; numele este cel raportat
+    shared_ptr<FlowCounters> flow(uint64_t id, const string &name) {
+        FlowStripe &stripe = flowStripes[id % stripeCount];
+        lock_guard<mutex> lock(stripe.flowsMutex);
+        auto found = stripe.flows.find(id);
+        if (found == stripe.flows.end()) {
+            if (stripe.flows.size() >= flowsPerStripe) {
+                stripe.flows.erase(stripe.flows.begin());
+            }
+            found = stripe.flows.emplace(id, FlowEntry{name, make_shared<FlowCounters>()}).first;
+        } else if (found->second.name != name) {
+            found->second.name = name;
         }
-    } else if (dynamic_cast<EndStep *>(newStep)) {
-        hasEndStep = true;
+        return found->second.counters;
     }
 
-    steps.push_back(newStep);
-    stepNames.push_back(newStep->getStepName());
-}
+    // Elimină contoarele unui flow șters; rulările în curs își păstrează contoarele până la final
+    void removeFlow(uint64_t id) {
+        FlowStripe &stripe = flowStripes[id % stripeCount];
+        lock_guard<mutex> lock(stripe.flowsMutex);
+        stripe.flows.erase(id);
+    }
 
-    const vector<float> &getNumberInputs() const {
-        return number_Inputs;
+    CounterTotals stepExecutionTotals(StepKind kind) const {
+        return sum([kind](const Shard &shard) -> const EventCounters & { return shard.executions[static_cast<size_t>(kind)]; });
     }
 
-    void displayFlowInfo() const {
-        cout << "Nume Flow: " << name << " | ";
-        for (const string &stepName : stepNames) {
-            cout << stepName << " | ";
-        }
-        cout << endl;
+    CounterTotals stepInfoTotals(StepKind kind) const {
+        return sum([kind](const Shard &shard) -> const EventCounters & { return shard.infos[static_cast<size_t>(kind)]; });
     }
 
-    void runFlow() const {
-        for (size_t i = 0; i < steps.size(); ++i) {
-            cout << "Step " << (i + 1) << " of Flow '" << name << "':" << endl;
-            steps[i]->getStepInfo();
-            cout << endl;
-        }
+    CounterTotals operationTotals(AnalyticsOperation operation) const {
+        return sum([operation](const Shard &shard) -> const EventCounters & { return shard.operations[static_cast<size_t>(operation)]; });
     }
 
-    ~Flow() {
-        for (Step *step : steps) {
-            delete step;
+    // Tabel pentru consolă: tipurile de pași, operațiile și flow-urile rulate
+    void writeReport(ostream &out) const {
+        out << left << setw(34) << "Categorie" << right << setw(10) << "Evenimente" << setw(8) << "Erori" << setw(8) << "Sarite"
+            << setw(12) << "Total ms" << setw(10) << "p50 us" << setw(10) << "p99 us" << setw(12) << "Cititi" << setw(12) << "Scrisi" << endl;
+        auto row = [&out](string_view label, const CounterTotals &totals) {
+            if (totals.events == 0 && totals.skips == 0) {
+                return;
+            }
+            out << left << setw(34) << label << right << setw(10) << totals.events << setw(8) << totals.errors << setw(8) << totals.skips
+                << fixed << setprecision(3) << setw(12) << totals.nanoseconds / 1e6 << setprecision(1)
+                << setw(10) << totals.percentile(0.5) / 1e3 << setw(10) << totals.percentile(0.99) / 1e3
+                << defaultfloat << setprecision(6) << setw(12) << totals.bytesRead << setw(12) << totals.bytesWritten << endl;
+        };
+        for (size_t kind = 0; kind < stepKindCount; ++kind) {
+            row("executie " + string(stepKindName(static_cast<StepKind>(kind))), stepExecutionTotals(static_cast<StepKind>(kind)));
+        }
+        for (size_t kind = 0; kind < stepKindCount; ++kind) {
+            row("info " + string(stepKindName(static_cast<StepKind>(kind))), stepInfoTotals(static_cast<StepKind>(kind)));
+        }
+        for (size_t operation = 0; operation < analyticsOperationCount; ++operation) {
+            row(analyticsOperationName(static_cast<AnalyticsOperation>(operation)), operationTotals(static_cast<AnalyticsOperation>(operation)));
+        }
+        for (const auto &entry : sortedFlows()) {
+            row("flow " + entry.first, totalsOf(entry.second->runs));
+            auto steps = entry.second->snapshot();
+            for (size_t i = 0; i < steps.second; ++i) {
+                const StepTiming &timing = steps.first[i];
+                if (timing.runs.load(memory_order_relaxed) > 0) {
+                    out << "  pasul " << left << setw(26) << (i + 1) << right << setw(10) << timing.runs.load(memory_order_relaxed)
+                        << setw(8) << timing.errors.load(memory_order_relaxed) << setw(8) << "" << fixed << setprecision(3)
+                        << setw(12) << timing.nanoseconds.load(memory_order_relaxed) / 1e6 << defaultfloat << setprecision(6) << endl;
+                }
+            }
         }
     }
-};
 
-class TitleStep: public Step
-{
-    private:
-        string title, subtitle;
-    public:
-        TitleStep(const string &t, const string &s)
-        {
-            this->title = t;
-            this->subtitle = s;
+    void writeJson(ostream &out) const {
+        out << "{\n  \"steps\": [";
+        for (size_t kind = 0; kind < stepKindCount; ++kind) {
+            out << (kind == 0 ? "\n" : ",\n") << "    {\"kind\": ";
+            writeJsonString(out, stepKindName(static_cast<StepKind>(kind)));
+            out << ", \"execution\": ";
+            writeJsonTotals(out, stepExecutionTotals(static_cast<StepKind>(kind)));
+            out << ", \"info\": ";
+            writeJsonTotals(out, stepInfoTotals(static_cast<StepKind>(kind)));
+            out << "}";
         }
-        string getStepName() override
-        {
-            return "Title step";
+        out << "\n  ],\n  \"operations\": [";
+        for (size_t operation = 0; operation < analyticsOperationCount; ++operation) {
+            out << (operation == 0 ? "\n" : ",\n") << "    {\"name\": ";
+            writeJsonString(out, analyticsOperationName(static_cast<AnalyticsOperation>(operation)));
+            out << ", \"counters\": ";
+            writeJsonTotals(out, operationTotals(static_cast<AnalyticsOperation>(operation)));
+            out << "}";
         }
-        void getStepInfo() override
-        {
-            cout << "Titlu: " << title << endl;
-            cout << "Subtitlu: " << subtitle << endl;
+        out << "\n  ],\n  \"flows\": [";
+        bool first = true;
+        for (const auto &entry : sortedFlows()) {
+            out << (first ? "\n" : ",\n") << "    {\"name\": ";
+            first = false;
+            writeJsonString(out, entry.first);
+            out << ", \"runs\": ";
+            writeJsonTotals(out, totalsOf(entry.second->runs));
+            out << ", \"steps\": [";
+            auto steps = entry.second->snapshot();
+            for (size_t i = 0; i < steps.second; ++i) {
+                const StepTiming &timing = steps.first[i];
+                out << (i == 0 ? "" : ", ") << "{\"step\": " << (i + 1) << ", \"runs\": " << timing.runs.load(memory_order_relaxed)
+                    << ", \"errors\": " << timing.errors.load(memory_order_relaxed)
+                    << ", \"total_ns\": " << timing.nanoseconds.load(memory_order_relaxed) << "}";
+            }
+            out << "]}";
         }
+        out << "\n  ]\n}\n";
+    }
 
-        void writeToFile(ofstream &file) const
-        {
-            file << "TitleStep" << endl;
-            file << "Title: " << title << endl;
-            file << "Subtitle: " << subtitle << endl;
+    // Un rând pe categorie; pașii flow-urilor au categoria flow_step și numărul pasului
+    void writeCsv(ostream &out) const {
+        out << "category,name,step,events,errors,skips,total_ns,p50_ns,p99_ns,bytes_read,bytes_written\n";
+        auto row = [&out](const char *category, string_view name, const CounterTotals &totals) {
+            out << category << ',';
+            writeCsvField(out, name);
+            out << ",," << totals.events << ',' << totals.errors << ',' << totals.skips << ',' << totals.nanoseconds << ','
+                << totals.percentile(0.5) << ',' << totals.percentile(0.99) << ',' << totals.bytesRead << ',' << totals.bytesWritten << '\n';
+        };
+        for (size_t kind = 0; kind < stepKindCount; ++kind) {
+            row("step_execution", stepKindName(static_cast<StepKind>(kind)), stepExecutionTotals(static_cast<StepKind>(kind)));
+            row("step_info", stepKindName(static_cast<StepKind>(kind)), stepInfoTotals(static_cast<StepKind>(kind)));
         }
+        for (size_t operation = 0; operation < analyticsOperationCount; ++operation) {
+            row("operation", analyticsOperationName(static_cast<AnalyticsOperation>(operation)), operationTotals(static_cast<AnalyticsOperation>(operation)));
+        }
+        for (const auto &entry : sortedFlows()) {
+            row("flow", entry.first, totalsOf(entry.second->runs));
+            auto steps = entry.second->snapshot();
+            for (size_t i = 0; i < steps.second; ++i) {
+                const StepTiming &timing = steps.first[i];
+                out << "flow_step,";
+                writeCsvField(out, entry.first);
+                out << ',' << (i + 1) << ',' << timing.runs.load(memory_order_relaxed) << ','
+                    << timing.errors.load(memory_order_relaxed) << ",0," << timing.nanoseconds.load(memory_order_relaxed) << ",,,,\n";
+            }
+        }
+    }
+
+    // Exportă în fișierul dat: CSV dacă numele se termină în ".csv", altfel JSON
+    bool exportTo(const string &path) const {
+        ofstream file(path, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+            writeCsv(file);
+        } else {
+            writeJson(file);
+        }
+        return static_cast<bool>(file);
+    }
+
+private:
+    struct alignas(64) Shard {
+        EventCounters executions[stepKindCount];
+        EventCounters infos[stepKindCount];
+        EventCounters operations[analyticsOperationCount];
+    };
+
+    struct FlowEntry {
+        string name;
+        shared_ptr<FlowCounters> counters;
+    };
+
+    struct FlowStripe {
+        mutable mutex flowsMutex;
+        map<uint64_t, FlowEntry> flows;  // Ordonat după id, pentru eliminarea celui mai vechi flow
+    };
+
+    mutable mutex shardsMutex;
+    vector<unique_ptr<Shard>> shards;  // Rămân după oprirea firelor, cu valorile lor
+    FlowStripe flowStripes[stripeCount];
+
+    // Shard-ul firului curent, creat la primul eveniment al firului. Există o singură instanță
+    // FlowAnalytics (flowAnalytics()), deci pointerul poate fi păstrat per fir.
+    Shard &localShard() {
+        thread_local Shard *shard = nullptr;
+        if (shard == nullptr) {
+            lock_guard<mutex> lock(shardsMutex);
+            shards.push_back(make_unique<Shard>());
+            shard = shards.back().get();
+        }
+        return *shard;
+    }
+
+    template <typename Select>
+    CounterTotals sum(Select &&select) const {
+        CounterTotals totals;
+        lock_guard<mutex> lock(shardsMutex);
+        for (const unique_ptr<Shard> &shard : shards) {
+            totals.add(select(*shard));
+        }
+        return totals;
+    }
+
+    static CounterTotals totalsOf(const SharedEventCounters &counters) {
+        CounterTotals totals;
+        totals.add(counters);
+        return totals;
+    }
+
+    vector<pair<string, shared_ptr<FlowCounters>>> sortedFlows() const {
+        vector<pair<string, shared_ptr<FlowCounters>>> sorted;
+        for (const FlowStripe &stripe : flowStripes) {
+            lock_guard<mutex> lock(stripe.flowsMutex);
+            for (const auto &entry : stripe.flows) {
+                sorted.emplace_back(entry.second.name, entry.second.counters);
+            }
+        }
+        sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        return sorted;
+    }
+
+    static void writeJsonTotals(ostream &out, const CounterTotals &totals) {
+        out << "{\"events\": " << totals.events << ", \"errors\": " << totals.errors << ", \"skips\": " << totals.skips
+            << ", \"total_ns\": " << totals.nanoseconds << ", \"p50_ns\": " << totals.percentile(0.5)
+            << ", \"p99_ns\": " << totals.percentile(0.99) << ", \"bytes_read\": " << totals.bytesRead
+            << ", \"bytes_written\": " << totals.bytesWritten << "}";
+    }
+
+    static void writeJsonString(ostream &out, string_view text) {
+        out << '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+                out << escaped;
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    static void writeCsvField(ostream &out, string_view text) {
+        if (text.find_first_of(",\"\n\r") == string_view::npos) {
+            out << text;
+            return;
+        }
+        out << '"';
+        for (char c : text) {
+            if (c == '"') {
+                out << '"';
+            }
+            out << c;
+        }
+        out << '"';
+    }
 };
 
-class TextStep: public Step
-{
-    private:
-        string title, copy;
+// Instanța nu este distrusă niciodată: firele care se opresc în timpul distrugerii obiectelor
+// statice (de exemplu cel al AsyncFileWriter) pot înregistra încă evenimente
+FlowAnalytics &flowAnalytics() {
+    static FlowAnalytics *analytics = new FlowAnalytics();
+    return *analytics;
+}
+
+// Nanosecundele trecute de la `since`
+uint64_t elapsedNanoseconds(chrono::steady_clock::time_point since) {
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - since).count());
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Măsoară durata blocului în care este declarat și o înregistrează la ieșire
+template <bool SingleWriter>
+class ScopedTimer {
+public:
+    explicit ScopedTimer(BasicEventCounters<SingleWriter> &counters) : counters(counters), start(chrono::steady_clock::now()) {}
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    void fail() {
+        failed = true;
+    }
+
+    ~ScopedTimer() {
+        counters.record(elapsedNanoseconds(start), failed);
+    }
+
+private:
+    BasicEventCounters<SingleWriter> &counters;
+    chrono::steady_clock::time_point start;
+    bool failed = false;
+};
+
+// Starea unei scrieri puse în coada AsyncFileWriter
+enum class FileStatus : uint8_t {
+    Pending,
+    Written,
+    Failed
+};
+
+// Scrierea unui fișier cerută de un pas; goală dacă pasul nu a cerut nicio scriere
+struct FileCompletion {
+    shared_ptr<atomic<FileStatus>> status;
+
+    bool pending() const {
+        return status && status->load(memory_order_acquire) == FileStatus::Pending;
+    }
+};
+
+// Scrie fișiere pe fire de execuție separate, ca flow-urile să poată continua cât timp fișierele
+// sunt create. Fiecare fișier este atribuit unui fir după cale, deci scrierile aceluiași fișier
+// rămân în ordine. Un fir preia dintr-o dată tot lotul adunat în coada lui și semnalează
+// terminarea lotului o singură dată; fiecare scriere are un FileCompletion, pe care pasul care a
+// cerut-o îl poate aștepta înainte de a citi fișierul. Bufferele scrise sunt păstrate și
+// refolosite pentru scrierile următoare.
+class AsyncFileWriter {
+private:
+    struct Job {
+        string path;
+        string data;
+        shared_ptr<atomic<FileStatus>> status;
+    };
+
+    struct Worker {
+        vector<Job> jobs;
+        bool stopping = false;
+        mutex jobsMutex;
+        condition_variable jobAvailable;
+        thread runner;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    vector<string> freeBuffers;
+    size_t pending = 0;  // Fișiere puse în coadă și încă nescrise complet
+    mutex stateMutex;    // Pentru `pending` și `freeBuffers`
+    condition_variable completed;
+
+    static bool writeFile(const Job &job) {
+        FILE *file = fopen(job.path.c_str(), "wb");
+        bool written = file != nullptr && fwrite(job.data.data(), 1, job.data.size(), file) == job.data.size();
+        if (file != nullptr && fclose(file) != 0) {
+            written = false;
+        }
+        return written;
+    }
+
+    void workerLoop(Worker &worker) {
+        vector<Job> batch;
+        while (true) {
+            {
+                unique_lock<mutex> lock(worker.jobsMutex);
+                worker.jobAvailable.wait(lock, [&worker] { return worker.stopping || !worker.jobs.empty(); });
+                if (worker.jobs.empty()) {
+                    return;
+                }
+                batch.swap(worker.jobs);
+            }
+
+            EventCounters &counters = flowAnalytics().operation(AnalyticsOperation::FileWrite);
+            for (const Job &job : batch) {
+                auto start = chrono::steady_clock::now();
+                bool written = writeFile(job);
+                counters.record(elapsedNanoseconds(start), !written);
+                if (!written) {
+                    cerr << "Eroare la scrierea fisierului " << job.path << "!" << endl;
+                } else {
+                    counters.addBytesWritten(job.data.size());
+                }
+                job.status->store(written ? FileStatus::Written : FileStatus::Failed, memory_order_release);
+            }
+
+            {
+                lock_guard<mutex> lock(stateMutex);
+                for (Job &job : batch) {
+                    if (freeBuffers.size() >= 4) {
+                        break;
+                    }
+                    if (job.data.capacity() >= 4096) {
+                        job.data.clear();
+                        freeBuffers.push_back(move(job.data));
+                    }
+                }
+                pending -= batch.size();
+            }
+            completed.notify_all();
+            batch.clear();
+        }
+    }
+
+public:
+    explicit AsyncFileWriter(size_t threads = std::min<size_t>(4, std::max(1u, thread::hardware_concurrency()))) {
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+            workers.push_back(make_unique<Worker>());
+        }
+        for (unique_ptr<Worker> &worker : workers) {
+            Worker *current = worker.get();
+            worker->runner = thread([this, current] { workerLoop(*current); });
+        }
+    }
+
+    AsyncFileWriter(const AsyncFileWriter &) = delete;
+    AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+    // Fișierele rămase în coadă sunt scrise înainte de oprirea firelor
+    ~AsyncFileWriter() {
+        for (unique_ptr<Worker> &worker : workers) {
+            {
+                lock_guard<mutex> lock(worker->jobsMutex);
+                worker->stopping = true;
+            }
+            worker->jobAvailable.notify_all();
+        }
+        for (unique_ptr<Worker> &worker : workers) {
+            worker->runner.join();
+        }
+    }
+
+    // Un buffer gol, refolosit de la o scriere anterioară dacă există unul
+    string acquireBuffer() {
+        lock_guard<mutex> lock(stateMutex);
+        if (freeBuffers.empty()) {
+            return string();
+        }
+        string buffer = move(freeBuffers.back());
+        freeBuffers.pop_back();
+        return buffer;
+    }
+
+    FileCompletion submit(const string &path, string data) {
+        FileCompletion completion{make_shared<atomic<FileStatus>>(FileStatus::Pending)};
+        {
+            lock_guard<mutex> lock(stateMutex);
+            pending++;
+        }
+        Worker &worker = *workers[hash<string>()(path) % workers.size()];
+        {
+            lock_guard<mutex> lock(worker.jobsMutex);
+            worker.jobs.push_back({path, move(data), completion.status});
+        }
+        worker.jobAvailable.notify_one();
+        return completion;
+    }
+
+    // Așteaptă o scriere anume; returnează false dacă fișierul nu a putut fi scris
+    bool wait(const FileCompletion &completion) {
+        if (!completion.status) {
+            return true;
+        }
+        if (completion.pending()) {
+            unique_lock<mutex> lock(stateMutex);
+            completed.wait(lock, [&completion] { return !completion.pending(); });
+        }
+        return completion.status->load(memory_order_acquire) == FileStatus::Written;
+    }
+
+    // Așteaptă până când toate fișierele din coadă au fost scrise
+    void flush() {
+        unique_lock<mutex> lock(stateMutex);
+        completed.wait(lock, [this] { return pending == 0; });
+    }
+
+    size_t threadCount() const {
+        return workers.size();
+    }
+};
+
+AsyncFileWriter &fileWriter() {
+    static AsyncFileWriter writer;
+    return writer;
+}
+
+// Câmpurile mari sau rar folosite ale unui pas, ținute în afara pasului ca StepValue să rămână mic
+// (StepStore mută pașii la fiecare realocare). Zona este alocată la prima modificare; până atunci
+// get() întoarce un T construit implicit. Copierea copiază valoarea, deci pasul rămâne un tip valoare.
+template <typename T>
+class StepExtra {
+private:
+    unique_ptr<T> value;
+
+public:
+    StepExtra() = default;
+    StepExtra(const StepExtra &other) : value(other.value ? make_unique<T>(*other.value) : nullptr) {}
+    StepExtra(StepExtra &&) noexcept = default;
+
+    StepExtra &operator=(const StepExtra &other) {
+        if (this != &other) {
+            value = other.value ? make_unique<T>(*other.value) : nullptr;
+        }
+        return *this;
+    }
+
+    StepExtra &operator=(StepExtra &&) noexcept = default;
+
+    const T &get() const {
+        static const T empty;
+        return value ? *value : empty;
+    }
+
+    const T *operator->() const {
+        return &get();
+    }
+
+    T &edit() {
+        if (!value) {
+            value = make_unique<T>();
+        }
+        return *value;
+    }
+};
+
+// Clasa abstractă pentru un pas în flow (abstract class Step)
+class Step {
     public:
-        TextStep(const string &t, const string &c)
+        virtual void getStepInfo(ostream &out) const = 0;
+        // Numele din registrul tipurilor de pași; nu alocă
+        string_view getStepName() const {
+            return stepKindName(getKind());
+        }
+        virtual StepKind getKind() const = 0;
+        virtual void writeToFile(TextWriter &file) const = 0;
+        // Scrie câmpurile pasului în format binar (tipul este scris separat, de apelant)
+        virtual void writeBinary(BinaryWriter &out) const = 0;
+        // Scrie câmpurile pasului în formatul modului batch, pe o linie, fără tipul pasului (scris
+        // de apelant); buildStep() reconstruiește pasul din ele
+        virtual void writeDefinition(TextWriter &out) const = 0;
+        virtual ~Step() {}
+};
+
+// Pasul de sfârșit (EndStep) - derivat din clasa abstractă Step
+class EndStep final : public Step {
+public:
+    void getStepInfo(ostream &out) const override {
+        out << "Sfarsitul flow-ului." << endl;
+    }
+
+    StepKind getKind() const override {
+        return StepKind::End;
+    }
+
+    void writeToFile(TextWriter &file) const {
+        file << "EndStep" << '\n';
+    }
+
+    void writeBinary(BinaryWriter &) const override {}
+
+    void writeDefinition(TextWriter &) const override {}
+};
+
+// Rezultatele analizei unui fișier text (analyzeText)
+struct TextStatistics {
+    uint64_t lines = 0;          // Inclusiv o ultimă linie fără '\n'
+    uint64_t words = 0;          // Secvențe fără spații albe, ca la wc -w
+    uint64_t bytes = 0;
+    uint64_t matchingLines = 0;  // Liniile care conțin modelul căutat
+    uint64_t uniqueWords = 0;
+    vector<pair<string, uint64_t>> topWords;  // Cele mai frecvente cuvinte, descrescător
+
+    // Valoarea cu numele dat, pentru CalculusStep: lines, words, bytes, matches, uniquewords
+    bool metric(string_view name, double &value) const {
+        const pair<const char *, uint64_t> metrics[] = {
+            {"lines", lines}, {"words", words}, {"bytes", bytes}, {"matches", matchingLines}, {"uniquewords", uniqueWords}};
+        for (const auto &entry : metrics) {
+            if (name == entry.first) {
+                value = static_cast<double>(entry.second);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void writeTopWords(ostream &out) const {
+        for (size_t i = 0; i < topWords.size(); ++i) {
+            out << (i > 0 ? ", " : "") << topWords[i].first << " (" << topWords[i].second << ")";
+        }
+    }
+};
+
+class TextFileInputStep final : public Step {
+private:
+    string fileName;
+    string description;
+
+    struct Extra {
+        string pattern;                              // Modelul numărat la analiză; gol pentru niciunul
+        shared_ptr<const TextStatistics> statistics; // Rezultatele analizei, după analyze()
+        FileCompletion created;                      // Scrierea cerută de createFile()
+    };
+    mutable StepExtra<Extra> extra;
+
+public:
+    TextFileInputStep(const string &fileName) : fileName(fileName) {}
+
+    void specifyDescription() {
+        cout << "Introduceti descrierea pentru pasul '" << fileName << "': ";
+        cin.ignore();  // Ignorăm orice caracter rămas în buffer
+        getline(cin, description);
+    }
+
+    // Setează descrierea fără prompt (folosit de modul batch)
+    void setDescription(const string &d) {
+        description = d;
+    }
+
+    void specifyPattern() {
+        cout << "Introduceti textul sau expresia regulata cautata in fisier (gol pentru niciuna): ";
+        getline(cin, extra.edit().pattern);
+    }
+
+    // Modelul ale cărui linii sunt numărate la analiză (folosit de modul batch)
+    void setPattern(const string &p) {
+        extra.edit().pattern = p;
+    }
+
+    void getStepInfo(ostream &out) const override {
+        out << "Fisier: " << fileName << endl;
+        out << "Descriere: " << description << endl;
+        if (extra->statistics) {
+            out << "Linii: " << extra->statistics->lines << ", cuvinte: " << extra->statistics->words << ", octeti: " << extra->statistics->bytes << endl;
+            if (!extra->pattern.empty()) {
+                out << "Linii cu '" << extra->pattern << "': " << extra->statistics->matchingLines << endl;
+            }
+            out << "Cuvinte frecvente: ";
+            extra->statistics->writeTopWords(out);
+            out << endl;
+        }
+    }
+
+    const string &getFileName() const {
+        return fileName;
+    }
+
+    const string &getDescription() const {
+        return description;
+    }
+
+    const string &getPattern() const {
+        return extra->pattern;
+    }
+
+    // nullptr dacă fișierul nu a fost analizat
+    const TextStatistics *getStatistics() const {
+        return extra->statistics.get();
+    }
+
+    const shared_ptr<const TextStatistics> &getSharedStatistics() const {
+        return extra->statistics;
+    }
+
+    // Mapează fișierul <fileName>.txt și îl analizează în paralel; rezultatele rămân accesibile
+    // prin getStatistics(). Definită după ThreadPool.
+    bool analyze(ostream &out = cout);
+
+    // Un fișier text existent este folosit ca sursă de date și nu este suprascris. Fișierul nou este
+    // scris pe firele AsyncFileWriter; erorile de scriere sunt raportate pe cerr.
+    void createFile(ostream &out = cout) const {
+        EventCounters &counters = flowAnalytics().operation(AnalyticsOperation::FileCreation);
+        if (ifstream(fileName + ".txt").is_open()) {
+            counters.skip();
+            out << "Fisierul text exista deja si va fi folosit ca sursa de date." << endl;
+            return;
+        }
+        ScopedTimer timer(counters);
+        string content = description + '\n';
+        counters.addBytesWritten(content.size());
+        extra.edit().created = fileWriter().submit(fileName + ".txt", move(content));
+        out << "Fisier creat cu succes!" << endl;
+    }
+
+    // Așteaptă fișierul cerut de createFile(); false dacă nu a putut fi scris
+    bool waitForFile() const {
+        return fileWriter().wait(extra->created);
+    }
+
+    StepKind getKind() const override {
+        return StepKind::TextFileInput;
+    }
+
+    void writeToFile(TextWriter &file) const {
+        file << "TextFileInputStep" << '\n';
+        file << "Fisier: " << fileName << ".txt" << '\n';
+        file << "Descriere: " << description << '\n';
+        if (extra->statistics) {
+            file << "Linii: " << extra->statistics->lines << '\n';
+            file << "Cuvinte: " << extra->statistics->words << '\n';
+            file << "Octeti: " << extra->statistics->bytes << '\n';
+            if (!extra->pattern.empty()) {
+                file << "Linii cu '" << extra->pattern << "': " << extra->statistics->matchingLines << '\n';
+            }
+        }
+    }
+
+    void writeBinary(BinaryWriter &out) const override {
+        out.writeString(fileName);
+        out.writeString(description);
+        out.writeString(extra->pattern);
+    }
+
+    void writeDefinition(TextWriter &out) const override {
+        out << fileName << " | " << description;
+        if (!extra->pattern.empty()) {
+            out << " | " << extra->pattern;
+        }
+    }
+};
+
+// Fișier mapat în memorie, doar pentru citire
+class MappedFile {
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Returnează false dacă fișierul nu există sau nu poate fi mapat
+    bool open(const string &path) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            close();
+            return false;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (size > 0) {
+            mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            data = mappingHandle ? static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            if (!data) {
+                close();
+                return false;
+            }
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size > 0) {
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                size = 0;
+                return false;
+            }
+            data = static_cast<const char *>(mapping);
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data) {
+            UnmapViewOfFile(data);
+        }
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+        }
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (data) {
+            munmap(const_cast<char *>(data), size);
+        }
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const char *getData() const {
+        return data;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+// Set fix de fire de execuție cu work stealing: fiecare fir are coada lui de sarcini, din care
+// ia cea mai nouă sarcină (LIFO, datele ei sunt încă în cache); un fir fără sarcini fură cea mai
+// veche sarcină din coada altui fir. Sarcinile trimise din afara pool-ului sunt distribuite
+// circular între cozi.
+class ThreadPool {
+private:
+    struct WorkerQueue {
+        mutex tasksMutex;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    vector<thread> workers;
+    atomic<size_t> queuedTasks{0};
+    atomic<size_t> nextQueue{0};
+    mutex sleepMutex;
+    condition_variable tasksAvailable;
+    bool stopping = false;
+
+    // Pool-ul și coada firului curent, dacă acesta este un fir de lucru
+    inline static thread_local ThreadPool *currentPool = nullptr;
+    inline static thread_local size_t currentQueue = 0;
+
+    // Ia o sarcină din coada proprie sau, dacă aceasta este goală, fură din celelalte cozi
+    bool popTask(size_t own, function<void()> &task) {
+        if (own < queues.size()) {
+            WorkerQueue &queue = *queues[own];
+            lock_guard<mutex> lock(queue.tasksMutex);
+            if (!queue.tasks.empty()) {
+                task = move(queue.tasks.back());
+                queue.tasks.pop_back();
+                queuedTasks--;
+                return true;
+            }
+        }
+        for (size_t i = 1; i <= queues.size(); ++i) {
+            WorkerQueue &queue = *queues[(own + i) % queues.size()];
+            lock_guard<mutex> lock(queue.tasksMutex);
+            if (!queue.tasks.empty()) {
+                task = move(queue.tasks.front());
+                queue.tasks.pop_front();
+                queuedTasks--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index) {
+        currentPool = this;
+        currentQueue = index;
+        function<void()> task;
+        while (true) {
+            if (popTask(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            unique_lock<mutex> lock(sleepMutex);
+            tasksAvailable.wait(lock, [this] { return stopping || queuedTasks > 0; });
+            if (stopping && queuedTasks == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t threadCount) {
+        threadCount = std::max<size_t>(threadCount, 1);
+        for (size_t i = 0; i < threadCount; ++i) {
+            queues.push_back(make_unique<WorkerQueue>());
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Sarcinile rămase în cozi sunt rulate înainte de oprirea firelor
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        tasksAvailable.notify_all();
+        for (thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    void submit(function<void()> task) {
+        size_t index = currentPool == this ? currentQueue : nextQueue++ % queues.size();
+        {
+            // Contorul este mărit înaintea inserării, sub sleepMutex, ca un fir care tocmai
+            // adoarme să nu rateze notificarea
+            lock_guard<mutex> lock(sleepMutex);
+            queuedTasks++;
+        }
+        {
+            lock_guard<mutex> lock(queues[index]->tasksMutex);
+            queues[index]->tasks.push_back(move(task));
+        }
+        tasksAvailable.notify_one();
+    }
+
+    // Rulează o sarcină din cozi pe firul curent; returnează false dacă nu există sarcini
+    bool runPendingTask() {
+        function<void()> task;
+        if (!popTask(currentPool == this ? currentQueue : queues.size(), task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    // Rulează task(i) pentru fiecare i din [0, count) și așteaptă terminarea tuturor.
+    // Firul apelant rulează și el sarcini cât așteaptă, deci apelul poate fi făcut și din interiorul
+    // unei sarcini. Prima excepție aruncată de o sarcină este transmisă apelantului.
+    template <typename Task>
+    void parallelFor(size_t count, Task &&task) {
+        size_t remaining = count;
+        mutex doneMutex;
+        condition_variable done;
+        exception_ptr error;
+
+        auto run = [&](size_t i) {
+            exception_ptr taskError;
+            try {
+                task(i);
+            } catch (...) {
+                taskError = current_exception();
+            }
+            lock_guard<mutex> lock(doneMutex);
+            if (taskError && !error) {
+                error = taskError;
+            }
+            if (--remaining == 0) {
+                done.notify_all();
+            }
+        };
+
+        for (size_t i = 1; i < count; ++i) {
+            submit([&run, i] { run(i); });
+        }
+        if (count > 0) {
+            run(0);
+        }
+        while (true) {
+            {
+                lock_guard<mutex> lock(doneMutex);
+                if (remaining == 0) {
+                    break;
+                }
+            }
+            if (!runPendingTask()) {
+                unique_lock<mutex> lock(doneMutex);
+                done.wait_for(lock, chrono::milliseconds(1), [&] { return remaining == 0; });
+            }
+        }
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+};
+
+// Numărul de fire al pool-ului comun (--workers); 0 înseamnă câte un fir pentru fiecare nucleu.
+// Trebuie setat înainte de prima folosire a pool-ului.
+size_t sharedThreadPoolWorkers = 0;
+
+// Pool-ul comun pentru procesarea paralelă a fișierelor și rularea flow-urilor
+ThreadPool &sharedThreadPool() {
+    static ThreadPool pool(sharedThreadPoolWorkers > 0 ? sharedThreadPoolWorkers : std::max(1u, thread::hardware_concurrency()));
+    return pool;
+}
+
+// Convertește un câmp text într-un număr (întreg sau real), fără alocări; returnează false dacă
+// textul nu este numeric
+template <typename T>
+bool parseNumber(string_view text, T &value) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    if (text.empty()) {
+        return false;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    from_chars_result result = from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == errc() && result.ptr == text.data() + text.size();
+#else
+    if constexpr (is_integral<T>::value) {
+        from_chars_result result = from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == errc() && result.ptr == text.data() + text.size();
+    } else {
+        char buffer[64];
+        if (text.size() >= sizeof(buffer)) {
+            return false;
+        }
+        memcpy(buffer, text.data(), text.size());
+        buffer[text.size()] = '\0';
+        char *end = nullptr;
+        value = static_cast<T>(strtod(buffer, &end));
+        return end == buffer + text.size();
+    }
+#endif
+}
+
+// Ca parseNumber, dar aruncă runtime_error dacă textul nu este numeric
+template <typename T>
+T requireNumber(string_view text) {
+    T value;
+    if (!parseNumber(text, value)) {
+        throw runtime_error("Numar invalid: '" + string(text) + "'");
+    }
+    return value;
+}
+
+// Scoate din `text` următorul cuvânt (separat prin spații sau tab-uri); returnează gol la final
+string_view nextToken(string_view &text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == string_view::npos) {
+        text = string_view();
+        return string_view();
+    }
+    size_t end = text.find_first_of(" \t", start);
+    string_view token = text.substr(start, end == string_view::npos ? string_view::npos : end - start);
+    text = end == string_view::npos ? string_view() : text.substr(end);
+    return token;
+}
+
+// Găsește începutul fiecărui rând dintr-un CSV. Un '\n' aflat între ghilimele face parte din câmp
+// și nu termină rândul; `inQuotes` păstrează starea între apeluri.
+void scalarIndexCsvRows(const char *data, size_t begin, size_t end, bool &inQuotes, vector<uint64_t> &rowStarts) {
+    for (size_t i = begin; i < end; ++i) {
+        if (data[i] == '"') {
+            inQuotes = !inQuotes;
+        } else if (data[i] == '\n' && !inQuotes) {
+            rowStarts.push_back(i + 1);
+        }
+    }
+}
+
+#ifdef FLOW_X86_SIMD
+// Variantele SIMD compară 16 (SSE2) sau 32 (AVX2) de octeți deodată cu '\n' și '"' și
+// tratează individual doar pozițiile găsite; blocurile fără ghilimele sunt procesate direct din mască.
+__attribute__((target("sse2"))) void sse2IndexCsvRows(const char *data, size_t begin, size_t end, bool &inQuotes, vector<uint64_t> &rowStarts) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i quote = _mm_set1_epi8('"');
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        unsigned newlines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+        unsigned quotes = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, quote)));
+        if (quotes == 0) {
+            if (!inQuotes) {
+                for (; newlines != 0; newlines &= newlines - 1) {
+                    rowStarts.push_back(i + static_cast<size_t>(__builtin_ctz(newlines)) + 1);
+                }
+            }
+            continue;
+        }
+        for (unsigned special = newlines | quotes; special != 0; special &= special - 1) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(special));
+            if ((quotes >> bit) & 1) {
+                inQuotes = !inQuotes;
+            } else if (!inQuotes) {
+                rowStarts.push_back(i + bit + 1);
+            }
+        }
+    }
+    scalarIndexCsvRows(data, i, end, inQuotes, rowStarts);
+}
+
+__attribute__((target("avx2"))) void avx2IndexCsvRows(const char *data, size_t begin, size_t end, bool &inQuotes, vector<uint64_t> &rowStarts) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i quote = _mm256_set1_epi8('"');
+    size_t i = begin;
+    for (; i + 32 <= end; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        unsigned newlines = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+        unsigned quotes = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, quote)));
+        if (quotes == 0) {
+            if (!inQuotes) {
+                for (; newlines != 0; newlines &= newlines - 1) {
+                    rowStarts.push_back(i + static_cast<size_t>(__builtin_ctz(newlines)) + 1);
+                }
+            }
+            continue;
+        }
+        for (unsigned special = newlines | quotes; special != 0; special &= special - 1) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(special));
+            if ((quotes >> bit) & 1) {
+                inQuotes = !inQuotes;
+            } else if (!inQuotes) {
+                rowStarts.push_back(i + bit + 1);
+            }
+        }
+    }
+    scalarIndexCsvRows(data, i, end, inQuotes, rowStarts);
+}
+#endif
+
+// Indexează rândurile din [begin, end) cu cea mai rapidă variantă suportată de procesor
+void indexCsvRows(const char *data, size_t begin, size_t end, bool &inQuotes, vector<uint64_t> &rowStarts) {
+#ifdef FLOW_X86_SIMD
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    static const bool hasSse2 = __builtin_cpu_supports("sse2");
+    if (hasAvx2) {
+        avx2IndexCsvRows(data, begin, end, inQuotes, rowStarts);
+        return;
+    }
+    if (hasSse2) {
+        sse2IndexCsvRows(data, begin, end, inQuotes, rowStarts);
+        return;
+    }
+#endif
+    scalarIndexCsvRows(data, begin, end, inQuotes, rowStarts);
+}
+
+// Parcurge câmpurile unui rând CSV și apelează callback(coloana, câmp) până când acesta returnează false.
+// Câmpurile sunt vederi în rândul original: la cele între ghilimele se omit ghilimelele exterioare,
+// iar ghilimelele dublate din interior rămân așa cum apar în fișier.
+template <typename Callback>
+void forEachCsvField(string_view row, char delimiter, Callback &&callback) {
+    size_t position = 0;
+    for (size_t column = 0;; ++column) {
+        string_view field;
+        size_t next;
+        if (position < row.size() && row[position] == '"') {
+            size_t end = position + 1;
+            while (end < row.size()) {
+                if (row[end] == '"') {
+                    if (end + 1 < row.size() && row[end + 1] == '"') {
+                        end += 2;
+                        continue;
+                    }
+                    break;
+                }
+                end++;
+            }
+            field = row.substr(position + 1, end - position - 1);
+            next = row.find(delimiter, end);
+        } else {
+            next = row.find(delimiter, position);
+            field = row.substr(position, next == string_view::npos ? string_view::npos : next - position);
+        }
+        if (!callback(column, field) || next == string_view::npos) {
+            return;
+        }
+        position = next + 1;
+    }
+}
+
+// Rezultatele parțiale ale unei agregări pe o coloană CSV. Bucățile de rânduri sunt agregate
+// separat și combinate apoi în ordinea rândurilor, deci prima valoare (folosită de '-' și '/')
+// este aceeași ca la o parcurgere secvențială.
+struct ColumnAggregate {
+    size_t count = 0;
+    size_t skipped = 0;
+    double first = 0;
+    double sumRest = 0;      // Suma valorilor de după prima
+    double productRest = 1;  // Produsul valorilor de după prima
+    size_t zerosRest = 0;    // Numărul de valori egale cu 0 de după prima
+    double minimum = numeric_limits<double>::infinity();
+    double maximum = -numeric_limits<double>::infinity();
+
+    void add(double value) {
+        if (count == 0) {
+            first = value;
+        } else {
+            sumRest += value;
+            productRest *= value;
+            zerosRest += value == 0;
+        }
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+        count++;
+    }
+
+    // Adaugă rezultatele unei bucăți care urmează după cea curentă
+    void merge(const ColumnAggregate &next) {
+        skipped += next.skipped;
+        if (next.count == 0) {
+            return;
+        }
+        if (count == 0) {
+            size_t skippedSoFar = skipped;
+            *this = next;
+            skipped = skippedSoFar;
+            return;
+        }
+        sumRest += next.first + next.sumRest;
+        productRest *= next.first * next.productRest;
+        zerosRest += next.zerosRest + (next.first == 0);
+        minimum = std::min(minimum, next.minimum);
+        maximum = std::max(maximum, next.maximum);
+        count += next.count;
+    }
+
+    double sum() const {
+        return count > 0 ? first + sumRest : 0;
+    }
+};
+
+// Tabel CSV peste un fișier mapat în memorie. La deschidere se face o singură trecere prin fișier
+// care reține doar începutul fiecărui rând; câmpurile sunt returnate ca string_view în mapare,
+// fără copiere și fără alocări pentru fiecare câmp.
+class CsvTable {
+private:
+    MappedFile file;
+    vector<uint64_t> rowStarts;  // Începutul fiecărui rând din fișier, inclusiv antetul
+    vector<string_view> columnNames;
+    char delimiter = ',';
+    size_t firstDataRow = 0;
+
+    // Indexează rândurile în paralel. Fiecare bucată este scanată presupunând că nu începe între
+    // ghilimele; după ce se cunoaște paritatea ghilimelelor din bucățile anterioare, doar bucățile
+    // care încep de fapt între ghilimele sunt scanate din nou.
+    void indexRows(const char *data, size_t size) {
+        const size_t minimumChunk = 4 << 20;
+        ThreadPool &pool = sharedThreadPool();
+        size_t chunkCount = std::min(pool.size() * 4, size / minimumChunk + 1);
+        if (chunkCount <= 1) {
+            bool inQuotes = false;
+            indexCsvRows(data, 0, size, inQuotes, rowStarts);
+            return;
+        }
+
+        auto chunkBegin = [&](size_t chunk) {
+            return chunk == chunkCount ? size : size / chunkCount * chunk;
+        };
+        vector<vector<uint64_t>> chunkRows(chunkCount);
+        vector<char> oddQuotes(chunkCount);
+        pool.parallelFor(chunkCount, [&](size_t chunk) {
+            bool inQuotes = false;
+            indexCsvRows(data, chunkBegin(chunk), chunkBegin(chunk + 1), inQuotes, chunkRows[chunk]);
+            oddQuotes[chunk] = inQuotes;
+        });
+
+        bool startsInQuotes = false;
+        size_t total = 0;
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            if (startsInQuotes) {
+                bool inQuotes = true;
+                chunkRows[chunk].clear();
+                indexCsvRows(data, chunkBegin(chunk), chunkBegin(chunk + 1), inQuotes, chunkRows[chunk]);
+            }
+            startsInQuotes = startsInQuotes != (oddQuotes[chunk] != 0);
+            total += chunkRows[chunk].size();
+        }
+        rowStarts.reserve(rowStarts.size() + total);
+        for (const vector<uint64_t> &rows : chunkRows) {
+            rowStarts.insert(rowStarts.end(), rows.begin(), rows.end());
+        }
+    }
+
+public:
+    CsvTable() {}
+    CsvTable(const CsvTable &) = delete;
+    CsvTable &operator=(const CsvTable &) = delete;
+
+    // Prima linie este tratată ca antet. Separatorul este ',' sau ';' (ales după antet).
+    bool open(const string &path, bool hasHeader = true) {
+        rowStarts.clear();
+        columnNames.clear();
+        if (!file.open(path)) {
+            return false;
+        }
+
+        const char *data = file.getData();
+        size_t size = file.getSize();
+        if (size > 0) {
+            rowStarts.push_back(0);
+            indexRows(data, size);
+            if (rowStarts.back() == size) {
+                rowStarts.pop_back();
+            }
+        }
+
+        firstDataRow = 0;
+        if (!rowStarts.empty()) {
+            string_view header = rawRow(0);
+            delimiter = header.find(',') == string_view::npos && header.find(';') != string_view::npos ? ';' : ',';
+            if (hasHeader) {
+                forEachCsvField(header, delimiter, [&](size_t, string_view name) {
+                    columnNames.push_back(name);
+                    return true;
+                });
+                firstDataRow = 1;
+            }
+        }
+        return true;
+    }
+
+    // Rândul cu indexul dat din fișier (0 este antetul), fără terminatorul de linie
+    string_view rawRow(size_t index) const {
+        size_t begin = static_cast<size_t>(rowStarts[index]);
+        size_t end = index + 1 < rowStarts.size() ? static_cast<size_t>(rowStarts[index + 1]) - 1 : file.getSize();
+        if (index + 1 == rowStarts.size() && end > begin && file.getData()[end - 1] == '\n') {
+            end--;  // Ultimul rând, urmat de un '\n' final
+        }
+        if (end > begin && file.getData()[end - 1] == '\r') {
+            end--;
+        }
+        return string_view(file.getData() + begin, end - begin);
+    }
+
+    // Rândul de date cu indexul dat (fără antet)
+    string_view row(size_t index) const {
+        return rawRow(firstDataRow + index);
+    }
+
+    size_t rowCount() const {
+        return rowStarts.size() - firstDataRow;
+    }
+
+    size_t columnCount() const {
+        return columnNames.size();
+    }
+
+    size_t byteSize() const {
+        return file.getSize();
+    }
+
+    char getDelimiter() const {
+        return delimiter;
+    }
+
+    const vector<string_view> &getColumnNames() const {
+        return columnNames;
+    }
+
+    // Indexul coloanei cu numele dat sau cu numărul dat (de la 1); -1 dacă nu există
+    long findColumn(string_view name) const {
+        for (size_t i = 0; i < columnNames.size(); ++i) {
+            if (columnNames[i] == name) {
+                return static_cast<long>(i);
+            }
+        }
+        double number;
+        if (parseNumber(name, number) && number >= 1 && number == static_cast<double>(static_cast<size_t>(number))) {
+            return static_cast<long>(number) - 1;
+        }
+        return -1;
+    }
+
+    // Câmpul de pe rândul și coloana date (gol dacă rândul are mai puține coloane)
+    string_view field(size_t rowIndex, size_t column) const {
+        string_view result;
+        forEachCsvField(row(rowIndex), delimiter, [&](size_t current, string_view value) {
+            if (current == column) {
+                result = value;
+                return false;
+            }
+            return true;
+        });
+        return result;
+    }
+
+    // Apelează callback(rând, valoare) pentru fiecare valoare numerică din coloană, pe rândurile [firstRow, lastRow).
+    // Câmpurile care nu sunt numerice sunt sărite; returnează numărul de câmpuri sărite.
+    template <typename Callback>
+    size_t forEachNumber(size_t column, size_t firstRow, size_t lastRow, Callback &&callback) const {
+        size_t skipped = 0;
+        for (size_t rowIndex = firstRow; rowIndex < lastRow; ++rowIndex) {
+            double value;
+            if (parseNumber(field(rowIndex, column), value)) {
+                callback(rowIndex, value);
+            } else {
+                skipped++;
+            }
+        }
+        return skipped;
+    }
+
+    // Agregă valorile numerice ale unei coloane în paralel, pe bucăți de rânduri
+    ColumnAggregate aggregateColumn(size_t column, ThreadPool &pool) const {
+        size_t rows = rowCount();
+        size_t chunkCount = std::min(pool.size() * 4, rows / 4096 + 1);
+        vector<ColumnAggregate> partials(chunkCount);
+        pool.parallelFor(chunkCount, [&](size_t chunk) {
+            ColumnAggregate partial;
+            partial.skipped = forEachNumber(column, rows * chunk / chunkCount, rows * (chunk + 1) / chunkCount,
+                                            [&](size_t, double value) { partial.add(value); });
+            partials[chunk] = partial;
+        });
+
+        ColumnAggregate result;
+        for (const ColumnAggregate &partial : partials) {
+            result.merge(partial);
+        }
+        return result;
+    }
+};
+
+// Tabel de frecvențe cu adresare deschisă pentru analyzeText: cuvintele sunt string_view în
+// fișierul mapat, iar hash-ul fiecărui cuvânt este calculat o singură dată și păstrat
+class WordCounts {
+private:
+    struct Entry {
+        const char *text = nullptr;  // nullptr pentru o poziție liberă
+        uint32_t length = 0;
+        uint64_t hash = 0;
+        uint64_t count = 0;
+    };
+
+    vector<Entry> entries;
+    size_t used = 0;
+
+    void grow() {
+        vector<Entry> previous(std::max<size_t>(entries.size() * 2, 1024));
+        previous.swap(entries);
+        used = 0;
+        for (const Entry &entry : previous) {
+            if (entry.text != nullptr) {
+                add(string_view(entry.text, entry.length), entry.hash, entry.count);
+            }
+        }
+    }
+
+public:
+    // FNV-1a pe 64 de biți
+    static uint64_t hashOf(string_view word) {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : word) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void add(string_view word, uint64_t hash, uint64_t count = 1) {
+        if ((used + 1) * 2 > entries.size()) {
+            grow();
+        }
+        size_t mask = entries.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            Entry &entry = entries[i];
+            if (entry.text == nullptr) {
+                entry = {word.data(), static_cast<uint32_t>(word.size()), hash, count};
+                used++;
+                return;
+            }
+            if (entry.hash == hash && entry.length == word.size() && memcmp(entry.text, word.data(), word.size()) == 0) {
+                entry.count += count;
+                return;
+            }
+        }
+    }
+
+    size_t size() const {
+        return used;
+    }
+
+    template <typename Function>
+    void forEach(Function &&function) const {
+        for (const Entry &entry : entries) {
+            if (entry.text != nullptr) {
+                function(string_view(entry.text, entry.length), entry.hash, entry.count);
+            }
+        }
+    }
+};
+
+// Analizează textul în paralel, pe bucăți care încep la început de linie: linii, cuvinte, octeți,
+// liniile care conțin `pattern` și frecvența cuvintelor. Un model fără metacaractere este căutat
+// ca text simplu, altfel ca expresie regulată ECMAScript (aruncă regex_error dacă este invalid).
+// Frecvențele sunt numărate pe bucăți în tabele WordCounts împărțite după hash-ul cuvântului;
+// fiecare parte este apoi combinată separat, tot în paralel.
+TextStatistics analyzeText(const char *data, size_t size, const string &pattern, ThreadPool &pool, size_t topCount = 10) {
+    struct Partial {
+        uint64_t lines = 0;
+        uint64_t words = 0;
+        uint64_t matchingLines = 0;
+        vector<WordCounts> shards;
+    };
+
+    bool literal = pattern.find_first_of(".^$|()[]{}*+?\\") == string::npos;
+    regex expression;
+    if (!pattern.empty() && !literal) {
+        expression.assign(pattern, regex::ECMAScript | regex::optimize);
+    }
+
+    // Limitele bucăților sunt mutate după următorul '\n', ca nicio linie să nu fie împărțită
+    size_t chunkCount = std::min(pool.size() * 4, size / (1 << 20) + 1);
+    vector<size_t> bounds(chunkCount + 1, size);
+    bounds[0] = 0;
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+        size_t bound = std::max(bounds[chunk - 1], size * chunk / chunkCount);
+        const void *newline = bound < size ? memchr(data + bound, '\n', size - bound) : nullptr;
+        bounds[chunk] = newline ? static_cast<size_t>(static_cast<const char *>(newline) - data) + 1 : size;
+    }
+
+    const size_t shardCount = pool.size();
+    vector<Partial> partials(chunkCount);
+    pool.parallelFor(chunkCount, [&](size_t chunk) {
+        Partial &partial = partials[chunk];
+        partial.shards.resize(shardCount);
+        const char *position = data + bounds[chunk];
+        const char *end = data + bounds[chunk + 1];
+        while (position < end) {
+            const char *lineEnd = static_cast<const char *>(memchr(position, '\n', static_cast<size_t>(end - position)));
+            if (lineEnd == nullptr) {
+                lineEnd = end;
+            }
+            partial.lines++;
+            for (const char *cursor = position; cursor < lineEnd;) {
+                while (cursor < lineEnd && (*cursor == ' ' || (*cursor >= '\t' && *cursor <= '\r'))) {
+                    cursor++;
+                }
+                const char *word = cursor;
+                while (cursor < lineEnd && !(*cursor == ' ' || (*cursor >= '\t' && *cursor <= '\r'))) {
+                    cursor++;
+                }
+                if (cursor > word) {
+                    string_view text(word, static_cast<size_t>(cursor - word));
+                    uint64_t hash = WordCounts::hashOf(text);
+                    partial.words++;
+                    partial.shards[(hash >> 40) % shardCount].add(text, hash);
+                }
+            }
+            if (!pattern.empty()) {
+                bool found = literal ? string_view(position, static_cast<size_t>(lineEnd - position)).find(pattern) != string_view::npos
+                                     : regex_search(position, lineEnd, expression);
+                partial.matchingLines += found;
+            }
+            position = lineEnd + 1;
+        }
+    });
+
+    // Fiecare parte a tabelului de frecvențe este combinată separat și păstrează primele cuvinte
+    vector<vector<pair<string_view, uint64_t>>> shardTops(shardCount);
+    vector<uint64_t> shardUnique(shardCount);
+    auto moreFrequent = [](const pair<string_view, uint64_t> &left, const pair<string_view, uint64_t> &right) {
+        return left.second != right.second ? left.second > right.second : left.first < right.first;
+    };
+    pool.parallelFor(shardCount, [&](size_t shard) {
+        WordCounts merged = move(partials[0].shards[shard]);
+        for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+            partials[chunk].shards[shard].forEach([&merged](string_view word, uint64_t hash, uint64_t count) { merged.add(word, hash, count); });
+            partials[chunk].shards[shard] = WordCounts();
+        }
+        shardUnique[shard] = merged.size();
+        vector<pair<string_view, uint64_t>> &top = shardTops[shard];
+        top.reserve(merged.size());
+        merged.forEach([&top](string_view word, uint64_t, uint64_t count) { top.emplace_back(word, count); });
+        size_t kept = std::min(topCount, top.size());
+        partial_sort(top.begin(), top.begin() + static_cast<ptrdiff_t>(kept), top.end(), moreFrequent);
+        top.resize(kept);
+    });
+
+    TextStatistics statistics;
+    statistics.bytes = size;
+    vector<pair<string_view, uint64_t>> top;
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        statistics.lines += partials[chunk].lines;
+        statistics.words += partials[chunk].words;
+        statistics.matchingLines += partials[chunk].matchingLines;
+    }
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        statistics.uniqueWords += shardUnique[shard];
+        top.insert(top.end(), shardTops[shard].begin(), shardTops[shard].end());
+    }
+    sort(top.begin(), top.end(), moreFrequent);
+    for (size_t i = 0; i < std::min(topCount, top.size()); ++i) {
+        statistics.topWords.emplace_back(string(top[i].first), top[i].second);
+    }
+    return statistics;
+}
+
+bool TextFileInputStep::analyze(ostream &out) {
+    EventCounters &counters = flowAnalytics().operation(AnalyticsOperation::TextAnalysis);
+    ScopedTimer timer(counters);
+    waitForFile();
+    Extra &data = extra.edit();
+    MappedFile file;
+    if (!file.open(fileName + ".txt")) {
+        timer.fail();
+        out << "Eroare la citirea fisierului text!" << endl;
+        return false;
+    }
+    try {
+        data.statistics = make_shared<const TextStatistics>(analyzeText(file.getData(), file.getSize(), data.pattern, sharedThreadPool()));
+    } catch (const regex_error &) {
+        timer.fail();
+        out << "Expresia regulata '" << data.pattern << "' este invalida." << endl;
+        return false;
+    }
+    counters.addBytesRead(file.getSize());
+    out << "Fisier text analizat: " << data.statistics->lines << " linii, " << data.statistics->words << " cuvinte, "
+        << data.statistics->bytes << " octeti";
+    if (!data.pattern.empty()) {
+        out << ", " << data.statistics->matchingLines << " linii cu '" << data.pattern << "'";
+    }
+    out << "." << endl;
+    return true;
+}
+
+class CSVFileInputStep final : public Step {
+private:
+    string fileName;
+    string description;
+
+    struct Extra {
+        shared_ptr<const CsvTable> table;  // Datele fișierului, după loadTable()
+        FileCompletion created;            // Scrierea cerută de createFile()
+    };
+    mutable StepExtra<Extra> extra;
+
+public:
+    CSVFileInputStep(const string &fileName) : fileName(fileName) {}
+
+    void specifyDescription() {
+        cout << "Introduceti descrierea pentru pasul '" << fileName << "': ";
+        cin.ignore();  // Ignorăm orice caracter rămas în buffer
+        getline(cin, description);
+    }
+
+    // Setează descrierea fără prompt (folosit de modul batch)
+    void setDescription(const string &d) {
+        description = d;
+    }
+
+    void getStepInfo(ostream &out) const override {
+        out << "Fisier: " << fileName << endl;
+        out << "Descriere: " << description << endl;
+        if (extra->table) {
+            out << "Randuri: " << extra->table->rowCount() << endl;
+            out << "Coloane:";
+            for (string_view column : extra->table->getColumnNames()) {
+                out << " " << column;
+            }
+            out << endl;
+        }
+    }
+
+    const string &getFileName() const {
+        return fileName;
+    }
+
+    const string &getDescription() const {
+        return description;
+    }
+
+    // Mapează și indexează fișierul <fileName>.csv; datele rămân accesibile prin getTable()
+    bool loadTable(ostream &out = cout) {
+        EventCounters &counters = flowAnalytics().operation(AnalyticsOperation::CsvLoad);
+        ScopedTimer timer(counters);
+        shared_ptr<CsvTable> loaded = make_shared<CsvTable>();
+        waitForFile();
+        if (!loaded->open(fileName + ".csv")) {
+            timer.fail();
+            out << "Eroare la citirea fisierului CSV!" << endl;
+            return false;
+        }
+        counters.addBytesRead(loaded->byteSize());
+        extra.edit().table = loaded;
+        out << "Fisier CSV incarcat: " << loaded->rowCount() << " randuri, " << loaded->columnCount() << " coloane." << endl;
+        return true;
+    }
+
+    // nullptr dacă fișierul nu a fost încărcat
+    const CsvTable *getTable() const {
+        return extra->table.get();
+    }
+
+    const shared_ptr<const CsvTable> &getSharedTable() const {
+        return extra->table;
+    }
+
+    // Un fișier CSV existent este folosit ca sursă de date și nu este suprascris. Fișierul nou este
+    // scris pe firele AsyncFileWriter; erorile de scriere sunt raportate pe cerr.
+    void createFile(ostream &out = cout) const {
+        EventCounters &counters = flowAnalytics().operation(AnalyticsOperation::FileCreation);
+        if (ifstream(fileName + ".csv").is_open()) {
+            counters.skip();
+            out << "Fisierul CSV exista deja si va fi folosit ca sursa de date." << endl;
+            return;
+        }
+        ScopedTimer timer(counters);
+        string content = "Descriere: " + description + '\n';
+        counters.addBytesWritten(content.size());
+        extra.edit().created = fileWriter().submit(fileName + ".csv", move(content));
+        out << "Fisier CSV creat cu succes!" << endl;
+    }
+
+    // Așteaptă fișierul cerut de createFile(); false dacă nu a putut fi scris
+    bool waitForFile() const {
+        return fileWriter().wait(extra->created);
+    }
+
+    StepKind getKind() const override {
+        return StepKind::CSVFileInput;
+    }
+
+    void writeToFile(TextWriter &file) const {
+        file << "TextFileInputStep" << '\n';
+        file << "Fisier: " << fileName << ".csv" << '\n';
+        file << "Descriere: " << description << '\n';
+    }
+
+    void writeBinary(BinaryWriter &out) const override {
+        out.writeString(fileName);
+        out.writeString(description);
+    }
+
+    void writeDefinition(TextWriter &out) const override {
+        out << fileName << " | " << description;
+    }
+};
+
+class StepStore;
+
+// Câmpurile unui pas care pot fi folosite într-un șablon de raport
+enum class ReportField : uint8_t {
+    Title,        // TitleStep, TextStep, OutputStep
+    Subtitle,     // TitleStep
+    Text,         // TextStep
+    Description,  // TextInputStep, NumberInputStep, TextFileInputStep, CSVFileInputStep
+    Input,        // TextInputStep, NumberInputStep
+    Operation,    // CalculusStep
+    Result,       // CalculusStep
+    Values,       // CalculusStep
+    File,         // TextFileInputStep, CSVFileInputStep, OutputStep
+    Content,      // Conținutul fișierului unui TextFileInputStep, CSVFileInputStep sau OutputStep
+    Rows,         // CSVFileInputStep încărcat
+    Lines,        // TextFileInputStep analizat
+    Words,        // TextFileInputStep analizat
+    Bytes,        // TextFileInputStep analizat
+    Matches,      // TextFileInputStep analizat: liniile care conțin modelul
+    TopWords,     // TextFileInputStep analizat: cele mai frecvente cuvinte
+    Info          // Textul scris de writeToFile, pentru orice pas
+};
+
+const char *reportFieldName(ReportField field) {
+    static const char *const names[] = {"title", "subtitle", "text", "description", "input", "operation",
+                                        "result", "values", "file", "content", "rows", "lines",
+                                        "words", "bytes", "matches", "topwords", "info"};
+    return names[static_cast<size_t>(field)];
+}
+
+// Șablon de raport compilat o singură dată: textul este împărțit în fragmente literale și
+// referințe {{stepN.camp}} către pașii anteriori ai flow-ului, de exemplu:
+//   Total vanzari: {{step4.result}} ({{step4.operation}} pe {{step2.rows}} randuri)
+//   Erori in log: {{step3.matches}} din {{step3.lines}} linii
+class ReportTemplate {
+private:
+    struct Segment {
+        size_t offset;   // Fragment literal din source (pentru step == 0)
+        size_t length;
+        size_t step;     // Numărul pasului referit, de la 1; 0 pentru text literal
+        ReportField field;
+    };
+
+    string source;
+    vector<Segment> segments;
+    size_t literalBytes = 0;
+
+    // Adaugă câmpul unui pas în buffer; returnează false dacă pasul nu are câmpul cerut. Mesajele
+    // unui calcul făcut acum (un rezultat necalculat încă) sunt scrise în `out`.
+    static bool appendField(string &buffer, const StepStore &steps, size_t position, ReportField field, ostream &out);
+
+public:
+    // Aruncă runtime_error cu linia placeholder-ului invalid
+    explicit ReportTemplate(string text) : source(move(text)) {
+        size_t position = 0;
+        while (position < source.size()) {
+            size_t open = source.find("{{", position);
+            size_t literalEnd = open == string::npos ? source.size() : open;
+            if (literalEnd > position) {
+                segments.push_back({position, literalEnd - position, 0, ReportField::Info});
+                literalBytes += literalEnd - position;
+            }
+            if (open == string::npos) {
+                break;
+            }
+
+            size_t line = static_cast<size_t>(std::count(source.begin(), source.begin() + open, '\n')) + 1;
+            size_t close = source.find("}}", open + 2);
+            if (close == string::npos) {
+                throw runtime_error("Sablon invalid la linia " + to_string(line) + ": lipseste '}}'.");
+            }
+            string_view placeholder(source.data() + open + 2, close - open - 2);
+            size_t dot = placeholder.find('.');
+            size_t step = 0;
+            bool validStep = placeholder.substr(0, 4) == "step" && dot != string_view::npos &&
+                             from_chars(placeholder.data() + 4, placeholder.data() + dot, step).ptr == placeholder.data() + dot &&
+                             step > 0;
+            if (!validStep) {
+                throw runtime_error("Sablon invalid la linia " + to_string(line) + ": '" + string(placeholder) +
+                                    "' trebuie sa fie de forma stepN.camp.");
+            }
+            string_view fieldName = placeholder.substr(dot + 1);
+            size_t field = 0;
+            while (field <= static_cast<size_t>(ReportField::Info) && fieldName != reportFieldName(static_cast<ReportField>(field))) {
+                field++;
+            }
+            if (field > static_cast<size_t>(ReportField::Info)) {
+                throw runtime_error("Sablon invalid la linia " + to_string(line) + ": campul '" + string(fieldName) + "' nu exista.");
+            }
+            segments.push_back({0, 0, step, static_cast<ReportField>(field)});
+            position = close + 2;
+        }
+    }
+
+    // Citește și compilează șablonul din fișier
+    static shared_ptr<const ReportTemplate> load(const string &path) {
+        ifstream file(path, ios::binary);
+        if (!file.is_open()) {
+            throw runtime_error("Sablonul " + path + " nu poate fi deschis.");
+        }
+        ostringstream text;
+        text << file.rdbuf();
+        return make_shared<const ReportTemplate>(text.str());
+    }
+
+    // Numerele pașilor referiți de șablon (de la 1), sortate și fără duplicate
+    vector<size_t> referencedSteps() const {
+        vector<size_t> referenced;
+        for (const Segment &segment : segments) {
+            if (segment.step != 0) {
+                referenced.push_back(segment.step);
+            }
+        }
+        sort(referenced.begin(), referenced.end());
+        referenced.erase(unique(referenced.begin(), referenced.end()), referenced.end());
+        return referenced;
+    }
+
+    size_t placeholderCount() const {
+        return segments.size() - count_if(segments.begin(), segments.end(), [](const Segment &s) { return s.step == 0; });
+    }
+
+    // Adaugă raportul în buffer; referințele care nu pot fi rezolvate sunt lăsate goale și
+    // descrise în `problems`. Definită după StepStore.
+    void render(const StepStore &steps, string &buffer, vector<string> &problems, ostream &out) const;
+};
+
+class OutputStep final : public Step {
+private:
+    string fileName;
+    size_t stepNumber;
+    string title;
+
+    struct Extra {
+        string templateFile;                        // Șablonul raportului; gol pentru un singur step
+        shared_ptr<const ReportTemplate> report;    // Șablonul compilat, dacă a fost deja încărcat
+        FileCompletion created;                     // Scrierea cerută de createFile()
+    };
+    mutable StepExtra<Extra> extra;
+
+public:
+    OutputStep(const string &fileName, size_t stepNumber, const string &title, const string &templateFile = "")
+        : fileName(fileName), stepNumber(stepNumber), title(title) {
+        if (!templateFile.empty()) {
+            extra.edit().templateFile = templateFile;
+        }
+    }
+
+    void specifyInfo() {
+        cout << "Introduceti numele fisierului pentru Output Step: ";
+        cin >> fileName;
+
+        cout << "Introduceti numarul step-ului din flow pentru care doriti informatiile: ";
+        cin >> stepNumber;
+
+        cout << "Introduceti titlul pentru prima linie din fisier: ";
+        cin.ignore();
+        getline(cin, title);
+    }
+
+    const string &getFileName() const {
+        return fileName;
+    }
+
+    const string &getTitle() const {
+        return title;
+    }
+
+    // Încarcă și compilează șablonul de raport; erorile sunt scrise în `out` și șablonul nu este folosit
+    bool setTemplateFile(const string &path, ostream &out = cout) {
+        shared_ptr<const ReportTemplate> compiled;
+        try {
+            compiled = ReportTemplate::load(path);
+        } catch (const exception &e) {
+            out << e.what() << endl;
+            return false;
+        }
+        Extra &data = extra.edit();
+        data.report = move(compiled);
+        data.templateFile = path;
+        stepNumber = 0;
+        return true;
+    }
+
+    const string &getTemplateFile() const {
+        return extra->templateFile;
+    }
+
+    size_t getStepNumber() const {
+        return stepNumber;
+    }
+
+    // Șablonul compilat; nullptr dacă nu a fost încă încărcat (de exemplu, pentru un flow din catalog)
+    const shared_ptr<const ReportTemplate> &getReport() const {
+        return extra->report;
+    }
+
+    void getStepInfo(ostream &out) const override {
+        out << "Fisier: " << fileName << endl;
+        if (extra->templateFile.empty()) {
+            out << "Numar step: " << stepNumber << endl;
+        } else {
+            out << "Sablon: " << extra->templateFile << endl;
+        }
+        out << "Titlu: " << title << endl;
+    }
+
+    // Definită după StepStore; returnează false dacă raportul nu a putut fi generat sau scris
+    bool createFile(const StepStore &steps, ostream &out = cout) const;
+
+    // Așteaptă raportul cerut de createFile(); false dacă nu a putut fi scris
+    bool waitForFile() const {
+        return fileWriter().wait(extra->created);
+    }
+
+    StepKind getKind() const override {
+        return StepKind::Output;
+    }
+
+    void writeToFile(TextWriter &file) const {
+        file << "OutputStep" << '\n';
+        file << "Filename: " << fileName << ".txt" << '\n';
+        if (extra->templateFile.empty()) {
+            file << "StepNumber: " << stepNumber << '\n';
+        } else {
+            file << "Sablon: " << extra->templateFile << '\n';
+        }
+        file << "Titlu: " << title << '\n';
+    }
+
+    void writeBinary(BinaryWriter &out) const override {
+        out.writeString(fileName);
+        out.write<uint64_t>(stepNumber);
+        out.writeString(title);
+        out.writeString(extra->templateFile);
+    }
+
+    void writeDefinition(TextWriter &out) const override {
+        out << fileName << " | ";
+        if (extra->templateFile.empty()) {
+            out << stepNumber;
+        } else {
+            out << "template " << extra->templateFile;
+        }
+        out << " | " << title;
+    }
+};
+
+class NumberInputStep final : public Step {
+private:
+    string description;
+    bool hasUserInput;  // Indică dacă input-ul a fost deja introdus
+    float number_input;  // Input-ul specific pasului, setat ulterior
+
+public:
+    NumberInputStep(const string &d)
+    {
+        this->description = d;
+        this->hasUserInput = false;
+        this->number_input = 0;
+    }
+
+    // Introduce descrierea pasului
+    void inputDescription() {
+        cout << "Introduceti descrierea: ";
+        cin.ignore();  // Ignorăm orice caracter rămas în buffer
+        getline(cin, description);
+    }
+
+    // Specifică input-ul pasului
+    void specifyInput() {
+        if (!hasUserInput) {
+            cout << "Introduceti input-ul pentru pasul '" << description << "': ";
+            cin >> number_input;
+            hasUserInput = true;
+        }
+    }
+
+    // Setează input-ul fără prompt (folosit de modul batch)
+    void setInput(float value) {
+        number_input = value;
+        hasUserInput = true;
+    }
+
+    const string &getDescription() const {
+        return description;
+    }
+
+    float getNumberInput() const {
+        return number_input;
+    }
+
+    void getStepInfo(ostream &out) const override {
+        out << "Descriere: " << description << endl;
+        if (hasUserInput) {
+            out << "Input :" << number_input << endl;
+        }
+    }
+
+    StepKind getKind() const override {
+        return StepKind::NumberInput;
+    }
+
+    void writeToFile(TextWriter &file) const {
+        file << "NumberInputStep" << '\n';
+        file << "Descriere: " << description << '\n';
+        if (hasUserInput) {
+            file << "Input: " << number_input << '\n';
+        }
+    }
+
+    void writeBinary(BinaryWriter &out) const override {
+        out.writeString(description);
+        out.write<uint8_t>(hasUserInput);
+        out.write<float>(number_input);
+    }
+
+    void writeDefinition(TextWriter &out) const override {
+        out << description;
+        if (hasUserInput) {
+            out << " | ";
+            out.exact(number_input);
+        }
+    }
+};
+
+// Modul de acumulare pentru operațiile de tip sumă și produs din CalculusStep.
+// Float păstrează comportamentul inițial; Double acumulează în dublă precizie;
+// Kahan folosește sumare compensată în float (pentru produs se folosește acumularea în double).
+enum class AccumulationMode : uint8_t {
+    Float,
+    Double,
+    Kahan
+};
+
+const char *accumulationModeName(AccumulationMode mode) {
+    switch (mode) {
+        case AccumulationMode::Float: return "float";
+        case AccumulationMode::Double: return "double";
+        case AccumulationMode::Kahan: return "kahan";
+    }
+    return "float";
+}
+
+AccumulationMode parseAccumulationMode(string_view name) {
+    if (name == "float") {
+        return AccumulationMode::Float;
+    } else if (name == "double") {
+        return AccumulationMode::Double;
+    } else if (name == "kahan") {
+        return AccumulationMode::Kahan;
+    }
+    throw runtime_error("Mod de acumulare necunoscut: " + string(name) + " (float, double, kahan)");
+}
+
+// Operațiile CalculusStep. Textul operației este tradus o singură dată, la setOperation();
+// orice text care nu este o operație cu nume este compilat ca expresie (CalculusExpression).
+enum class CalculusOperation : uint8_t {
+    Unknown,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Min,
+    Max,
+    Count,
+    Mean,
+    Expression
+};
+
+CalculusOperation parseCalculusOperation(const string &name) {
+    static const pair<const char *, CalculusOperation> names[] = {
+        {"+", CalculusOperation::Add}, {"-", CalculusOperation::Subtract}, {"*", CalculusOperation::Multiply},
+        {"/", CalculusOperation::Divide}, {"min", CalculusOperation::Min}, {"max", CalculusOperation::Max},
+        {"count", CalculusOperation::Count}, {"mean", CalculusOperation::Mean}};
+    for (const auto &entry : names) {
+        if (name == entry.first) {
+            return entry.second;
+        }
+    }
+    return CalculusOperation::Unknown;
+}
+
+// Nucleele de reducere folosite de CalculusStep. Există o variantă scalară și, pe x86 cu GCC/Clang,
+// variante SSE2 și AVX2; varianta folosită este aleasă o singură dată, la rulare, după procesor.
+// Funcțiile pentru minim și maxim presupun cel puțin o valoare.
+struct CalculusKernels {
+    const char *name;
+    float (*sumFloat)(const float *values, size_t count);
+    double (*sumDouble)(const float *values, size_t count);
+    float (*sumKahan)(const float *values, size_t count);
+    float (*productFloat)(const float *values, size_t count);
+    double (*productDouble)(const float *values, size_t count);
+    float (*minimum)(const float *values, size_t count);
+    float (*maximum)(const float *values, size_t count);
+    bool (*containsZero)(const float *values, size_t count);
+};
+
+// Adaugă o valoare la o sumă compensată (Kahan)
+inline void kahanAdd(float &sum, float &compensation, float value) {
+    float corrected = value - compensation;
+    float total = sum + corrected;
+    compensation = (total - sum) - corrected;
+    sum = total;
+}
+
+float scalarSumFloat(const float *values, size_t count) {
+    float result = 0;
+    for (size_t i = 0; i < count; ++i) {
+        result += values[i];
+    }
+    return result;
+}
+
+double scalarSumDouble(const float *values, size_t count) {
+    double result = 0;
+    for (size_t i = 0; i < count; ++i) {
+        result += values[i];
+    }
+    return result;
+}
+
+float scalarSumKahan(const float *values, size_t count) {
+    float sum = 0, compensation = 0;
+    for (size_t i = 0; i < count; ++i) {
+        kahanAdd(sum, compensation, values[i]);
+    }
+    return sum;
+}
+
+float scalarProductFloat(const float *values, size_t count) {
+    float result = 1;
+    for (size_t i = 0; i < count; ++i) {
+        result *= values[i];
+    }
+    return result;
+}
+
+double scalarProductDouble(const float *values, size_t count) {
+    double result = 1;
+    for (size_t i = 0; i < count; ++i) {
+        result *= values[i];
+    }
+    return result;
+}
+
+float scalarMinimum(const float *values, size_t count) {
+    float result = values[0];
+    for (size_t i = 1; i < count; ++i) {
+        result = std::min(result, values[i]);
+    }
+    return result;
+}
+
+float scalarMaximum(const float *values, size_t count) {
+    float result = values[0];
+    for (size_t i = 1; i < count; ++i) {
+        result = std::max(result, values[i]);
+    }
+    return result;
+}
+
+bool scalarContainsZero(const float *values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (values[i] == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const CalculusKernels scalarCalculusKernels = {
+    "scalar", scalarSumFloat, scalarSumDouble, scalarSumKahan, scalarProductFloat,
+    scalarProductDouble, scalarMinimum, scalarMaximum, scalarContainsZero
+};
+
+#ifdef FLOW_X86_SIMD
+// Variantele SSE2: 4 valori float pe registru, două acumulatoare pentru a ascunde latența adunării
+
+__attribute__((target("sse2"))) float sse2SumFloat(const float *values, size_t count) {
+    __m128 first = _mm_setzero_ps(), second = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        first = _mm_add_ps(first, _mm_loadu_ps(values + i));
+        second = _mm_add_ps(second, _mm_loadu_ps(values + i + 4));
+    }
+    for (; i + 4 <= count; i += 4) {
+        first = _mm_add_ps(first, _mm_loadu_ps(values + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(first, second));
+    float result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < count; ++i) {
+        result += values[i];
+    }
+    return result;
+}
+
+__attribute__((target("sse2"))) double sse2SumDouble(const float *values, size_t count) {
+    __m128d first = _mm_setzero_pd(), second = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 block = _mm_loadu_ps(values + i);
+        first = _mm_add_pd(first, _mm_cvtps_pd(block));
+        second = _mm_add_pd(second, _mm_cvtps_pd(_mm_movehl_ps(block, block)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(first, second));
+    double result = lanes[0] + lanes[1];
+    for (; i < count; ++i) {
+        result += values[i];
+    }
+    return result;
+}
+
+__attribute__((target("sse2"))) float sse2SumKahan(const float *values, size_t count) {
+    __m128 sum = _mm_setzero_ps(), compensation = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 corrected = _mm_sub_ps(_mm_loadu_ps(values + i), compensation);
+        __m128 total = _mm_add_ps(sum, corrected);
+        compensation = _mm_sub_ps(_mm_sub_ps(total, sum), corrected);
+        sum = total;
+    }
+    float sums[4], compensations[4];
+    _mm_storeu_ps(sums, sum);
+    _mm_storeu_ps(compensations, compensation);
+    float result = 0, resultCompensation = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+        kahanAdd(result, resultCompensation, sums[lane]);
+        kahanAdd(result, resultCompensation, -compensations[lane]);
+    }
+    for (; i < count; ++i) {
+        kahanAdd(result, resultCompensation, values[i]);
+    }
+    return result;
+}
+
+__attribute__((target("sse2"))) float sse2ProductFloat(const float *values, size_t count) {
+    __m128 first = _mm_set1_ps(1), second = _mm_set1_ps(1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        first = _mm_mul_ps(first, _mm_loadu_ps(values + i));
+        second = _mm_mul_ps(second, _mm_loadu_ps(values + i + 4));
+    }
+    for (; i + 4 <= count; i += 4) {
+        first = _mm_mul_ps(first, _mm_loadu_ps(values + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_mul_ps(first, second));
+    float result = (lanes[0] * lanes[1]) * (lanes[2] * lanes[3]);
+    for (; i < count; ++i) {
+        result *= values[i];
+    }
+    return result;
+}
+
+__attribute__((target("sse2"))) double sse2ProductDouble(const float *values, size_t count) {
+    __m128d first = _mm_set1_pd(1), second = _mm_set1_pd(1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 block = _mm_loadu_ps(values + i);
+        first = _mm_mul_pd(first, _mm_cvtps_pd(block));
+        second = _mm_mul_pd(second, _mm_cvtps_pd(_mm_movehl_ps(block, block)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_mul_pd(first, second));
+    double result = lanes[0] * lanes[1];
+    for (; i < count; ++i) {
+        result *= values[i];
+    }
+    return result;
+}
+
+__attribute__((target("sse2"))) float sse2Minimum(const float *values, size_t count) {
+    if (count < 4) {
+        return scalarMinimum(values, count);
+    }
+    __m128 result = _mm_loadu_ps(values);
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        result = _mm_min_ps(result, _mm_loadu_ps(values + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, result);
+    float minimum = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    for (; i < count; ++i) {
+        minimum = std::min(minimum, values[i]);
+    }
+    return minimum;
+}
+
+__attribute__((target("sse2"))) float sse2Maximum(const float *values, size_t count) {
+    if (count < 4) {
+        return scalarMaximum(values, count);
+    }
+    __m128 result = _mm_loadu_ps(values);
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        result = _mm_max_ps(result, _mm_loadu_ps(values + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, result);
+    float maximum = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < count; ++i) {
+        maximum = std::max(maximum, values[i]);
+    }
+    return maximum;
+}
+
+__attribute__((target("sse2"))) bool sse2ContainsZero(const float *values, size_t count) {
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        if (_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values + i), zero)) != 0) {
+            return true;
+        }
+    }
+    return scalarContainsZero(values + i, count - i);
+}
+
+const CalculusKernels sse2CalculusKernels = {
+    "sse2", sse2SumFloat, sse2SumDouble, sse2SumKahan, sse2ProductFloat,
+    sse2ProductDouble, sse2Minimum, sse2Maximum, sse2ContainsZero
+};
+
+// Variantele AVX2: 8 valori float pe registru
+
+__attribute__((target("avx2"))) float avx2SumFloat(const float *values, size_t count) {
+    __m256 first = _mm256_setzero_ps(), second = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        first = _mm256_add_ps(first, _mm256_loadu_ps(values + i));
+        second = _mm256_add_ps(second, _mm256_loadu_ps(values + i + 8));
+    }
+    for (; i + 8 <= count; i += 8) {
+        first = _mm256_add_ps(first, _mm256_loadu_ps(values + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(first, second));
+    float result = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    for (; i < count; ++i) {
+        result += values[i];
+    }
+    return result;
+}
+
+__attribute__((target("avx2"))) double avx2SumDouble(const float *values, size_t count) {
+    __m256d first = _mm256_setzero_pd(), second = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 block = _mm256_loadu_ps(values + i);
+        first = _mm256_add_pd(first, _mm256_cvtps_pd(_mm256_castps256_ps128(block)));
+        second = _mm256_add_pd(second, _mm256_cvtps_pd(_mm256_extractf128_ps(block, 1)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(first, second));
+    double result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < count; ++i) {
+        result += values[i];
+    }
+    return result;
+}
+
+__attribute__((target("avx2"))) float avx2SumKahan(const float *values, size_t count) {
+    __m256 sum = _mm256_setzero_ps(), compensation = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 corrected = _mm256_sub_ps(_mm256_loadu_ps(values + i), compensation);
+        __m256 total = _mm256_add_ps(sum, corrected);
+        compensation = _mm256_sub_ps(_mm256_sub_ps(total, sum), corrected);
+        sum = total;
+    }
+    float sums[8], compensations[8];
+    _mm256_storeu_ps(sums, sum);
+    _mm256_storeu_ps(compensations, compensation);
+    float result = 0, resultCompensation = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+        kahanAdd(result, resultCompensation, sums[lane]);
+        kahanAdd(result, resultCompensation, -compensations[lane]);
+    }
+    for (; i < count; ++i) {
+        kahanAdd(result, resultCompensation, values[i]);
+    }
+    return result;
+}
+
+__attribute__((target("avx2"))) float avx2ProductFloat(const float *values, size_t count) {
+    __m256 first = _mm256_set1_ps(1), second = _mm256_set1_ps(1);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        first = _mm256_mul_ps(first, _mm256_loadu_ps(values + i));
+        second = _mm256_mul_ps(second, _mm256_loadu_ps(values + i + 8));
+    }
+    for (; i + 8 <= count; i += 8) {
+        first = _mm256_mul_ps(first, _mm256_loadu_ps(values + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_mul_ps(first, second));
+    float result = ((lanes[0] * lanes[1]) * (lanes[2] * lanes[3])) * ((lanes[4] * lanes[5]) * (lanes[6] * lanes[7]));
+    for (; i < count; ++i) {
+        result *= values[i];
+    }
+    return result;
+}
+
+__attribute__((target("avx2"))) double avx2ProductDouble(const float *values, size_t count) {
+    __m256d first = _mm256_set1_pd(1), second = _mm256_set1_pd(1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 block = _mm256_loadu_ps(values + i);
+        first = _mm256_mul_pd(first, _mm256_cvtps_pd(_mm256_castps256_ps128(block)));
+        second = _mm256_mul_pd(second, _mm256_cvtps_pd(_mm256_extractf128_ps(block, 1)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_mul_pd(first, second));
+    double result = (lanes[0] * lanes[1]) * (lanes[2] * lanes[3]);
+    for (; i < count; ++i) {
+        result *= values[i];
+    }
+    return result;
+}
+
+__attribute__((target("avx2"))) float avx2Minimum(const float *values, size_t count) {
+    if (count < 8) {
+        return scalarMinimum(values, count);
+    }
+    __m256 result = _mm256_loadu_ps(values);
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8) {
+        result = _mm256_min_ps(result, _mm256_loadu_ps(values + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, result);
+    float minimum = scalarMinimum(lanes, 8);
+    for (; i < count; ++i) {
+        minimum = std::min(minimum, values[i]);
+    }
+    return minimum;
+}
+
+__attribute__((target("avx2"))) float avx2Maximum(const float *values, size_t count) {
+    if (count < 8) {
+        return scalarMaximum(values, count);
+    }
+    __m256 result = _mm256_loadu_ps(values);
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8) {
+        result = _mm256_max_ps(result, _mm256_loadu_ps(values + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, result);
+    float maximum = scalarMaximum(lanes, 8);
+    for (; i < count; ++i) {
+        maximum = std::max(maximum, values[i]);
+    }
+    return maximum;
+}
+
+__attribute__((target("avx2"))) bool avx2ContainsZero(const float *values, size_t count) {
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), zero, _CMP_EQ_OQ)) != 0) {
+            return true;
+        }
+    }
+    return scalarContainsZero(values + i, count - i);
+}
+
+const CalculusKernels avx2CalculusKernels = {
+    "avx2", avx2SumFloat, avx2SumDouble, avx2SumKahan, avx2ProductFloat,
+    avx2ProductDouble, avx2Minimum, avx2Maximum, avx2ContainsZero
+};
+#endif
+
+// Toate variantele de nuclee suportate de procesorul curent, de la cea scalară la cea mai rapidă
+vector<const CalculusKernels *> availableCalculusKernels() {
+    vector<const CalculusKernels *> kernels = {&scalarCalculusKernels};
+#ifdef FLOW_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.push_back(&sse2CalculusKernels);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back(&avx2CalculusKernels);
+    }
+#endif
+    return kernels;
+}
+
+// Varianta folosită de CalculusStep (aleasă la primul apel)
+const CalculusKernels &calculusKernels() {
+    static const CalculusKernels *kernels = availableCalculusKernels().back();
+    return *kernels;
+}
+
+// Expresie aritmetică pentru CalculusStep, de exemplu "(step3 + step5) / max(step7, 1)":
+// operatorii + - * /, minus unar, paranteze, constante, funcțiile min, max și abs și referințe
+// stepN la alți pași. Textul este analizat o singură dată într-un program în notație postfixată;
+// evaluarea lucrează pe o stivă de dimensiune cunoscută la compilare, fără șiruri și fără alocări.
+// O împărțire la 0 dă 0 și este semnalată apelantului, ca la operația "/".
+class CalculusExpression {
+public:
+    enum class OpCode : uint8_t {
+        Constant,  // operand = indicele în constants
+        Load,      // operand = indicele referinței (slotul de intrare)
+        Negate,
+        Abs,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Min,
+        Max
+    };
+
+    struct Instruction {
+        OpCode code;
+        uint32_t operand;
+    };
+
+    static constexpr size_t maxDepth = 64;     // Adâncimea maximă a stivei de evaluare
+    static constexpr size_t batchBlock = 256;  // Rândurile evaluate împreună de evaluateBatch()
+
+    // Compilează textul; aruncă runtime_error cu poziția primei erori
+    static CalculusExpression compile(const string &text) {
+        CalculusExpression expression;
+        Parser parser{text, expression};
+        parser.parseSum();
+        parser.skipSpaces();
+        if (parser.position != text.size()) {
+            parser.fail("operator asteptat");
+        }
+        return expression;
+    }
+
+    bool empty() const {
+        return program.empty();
+    }
+
+    // Numerele pașilor referiți, câte un slot pentru fiecare, în ordinea primei apariții
+    const vector<size_t> &references() const {
+        return stepReferences;
+    }
+
+    const vector<Instruction> &instructions() const {
+        return program;
+    }
+
+    // Evaluează expresia; values[i] este valoarea pasului references()[i]
+    float evaluate(const float *values, bool &divisionByZero) const {
+        return static_cast<float>(evaluateWith([values](size_t i) -> double { return values[i]; }, divisionByZero));
+    }
+
+    // Evaluează expresia în double; load(i) dă valoarea pasului references()[i]
+    template <typename Load>
+    double evaluateWith(Load &&load, bool &divisionByZero) const {
+        double stack[maxDepth];
+        stack[0] = 0;  // Rezultatul unui program gol
+        size_t top = 0;
+        for (const Instruction &instruction : program) {
+            switch (instruction.code) {
+                case OpCode::Constant:
+                    stack[top++] = constants[instruction.operand];
+                    break;
+                case OpCode::Load:
+                    stack[top++] = load(instruction.operand);
+                    break;
+                case OpCode::Negate:
+                    stack[top - 1] = -stack[top - 1];
+                    break;
+                case OpCode::Abs:
+                    stack[top - 1] = fabs(stack[top - 1]);
+                    break;
+                default:
+                    --top;
+                    stack[top - 1] = applyBinary(instruction.code, stack[top - 1], stack[top], divisionByZero);
+                    break;
+            }
+        }
+        return stack[0];
+    }
+
+    // Evaluează expresia pentru `rows` rânduri: columns[i][r] este valoarea referinței i pe rândul r.
+    // Fiecare instrucțiune este aplicată pe blocuri de batchBlock rânduri, deci bucla interioară
+    // nu depinde de program. Returnează numărul de împărțiri la 0 întâlnite (rezultatul lor este 0).
+    size_t evaluateBatch(const float *const *columns, size_t rows, float *results) const {
+        vector<double> stack(stackDepth * batchBlock);
+        size_t divisionsByZero = 0;
+        for (size_t begin = 0; begin < rows; begin += batchBlock) {
+            size_t count = std::min(batchBlock, rows - begin);
+            size_t top = 0;
+            for (const Instruction &instruction : program) {
+                double *slot = stack.data() + top * batchBlock;
+                switch (instruction.code) {
+                    case OpCode::Constant:
+                        fill(slot, slot + count, constants[instruction.operand]);
+                        ++top;
+                        break;
+                    case OpCode::Load: {
+                        const float *column = columns[instruction.operand] + begin;
+                        for (size_t r = 0; r < count; ++r) {
+                            slot[r] = column[r];
+                        }
+                        ++top;
+                        break;
+                    }
+                    case OpCode::Negate:
+                        slot -= batchBlock;
+                        for (size_t r = 0; r < count; ++r) {
+                            slot[r] = -slot[r];
+                        }
+                        break;
+                    case OpCode::Abs:
+                        slot -= batchBlock;
+                        for (size_t r = 0; r < count; ++r) {
+                            slot[r] = fabs(slot[r]);
+                        }
+                        break;
+                    default:
+                        --top;
+                        divisionsByZero += applyBinaryBlock(instruction.code, slot - 2 * batchBlock, slot - batchBlock, count);
+                        break;
+                }
+            }
+            for (size_t r = 0; r < count; ++r) {
+                results[begin + r] = static_cast<float>(stack[r]);
+            }
+        }
+        return divisionsByZero;
+    }
+
+private:
+    vector<Instruction> program;
+    vector<double> constants;
+    vector<size_t> stepReferences;
+    size_t stackDepth = 0;  // Adâncimea maximă atinsă de stivă la evaluare
+
+    static double applyBinary(OpCode code, double left, double right, bool &divisionByZero) {
+        switch (code) {
+            case OpCode::Add: return left + right;
+            case OpCode::Subtract: return left - right;
+            case OpCode::Multiply: return left * right;
+            case OpCode::Divide:
+                if (right == 0) {
+                    divisionByZero = true;
+                    return 0;
+                }
+                return left / right;
+            case OpCode::Min: return right < left ? right : left;
+            case OpCode::Max: return right > left ? right : left;
+            default: return 0;
+        }
+    }
+
+    static size_t applyBinaryBlock(OpCode code, double *left, const double *right, size_t count) {
+        size_t divisionsByZero = 0;
+        switch (code) {
+            case OpCode::Add:
+                for (size_t r = 0; r < count; ++r) left[r] += right[r];
+                break;
+            case OpCode::Subtract:
+                for (size_t r = 0; r < count; ++r) left[r] -= right[r];
+                break;
+            case OpCode::Multiply:
+                for (size_t r = 0; r < count; ++r) left[r] *= right[r];
+                break;
+            case OpCode::Divide:
+                for (size_t r = 0; r < count; ++r) {
+                    bool zero = right[r] == 0;
+                    divisionsByZero += zero;
+                    left[r] = zero ? 0 : left[r] / right[r];
+                }
+                break;
+            case OpCode::Min:
+                for (size_t r = 0; r < count; ++r) left[r] = right[r] < left[r] ? right[r] : left[r];
+                break;
+            case OpCode::Max:
+                for (size_t r = 0; r < count; ++r) left[r] = right[r] > left[r] ? right[r] : left[r];
+                break;
+            default:
+                break;
+        }
+        return divisionsByZero;
+    }
+
+    // Analizor recursiv descendent; emite instrucțiunile direct în expresie și urmărește
+    // adâncimea stivei, ca evaluarea să nu aibă nevoie de verificări
+    struct Parser {
+        const string &text;
+        CalculusExpression &expression;
+        size_t position = 0;
+        size_t depth = 0;    // Adâncimea curentă a stivei de evaluare
+        size_t nesting = 0;  // Subexpresiile deschise, limitate pentru a nu epuiza stiva analizorului
+
+        [[noreturn]] void fail(const string &message) const {
+            throw runtime_error("Expresie invalida la pozitia " + to_string(position + 1) + ": " + message);
+        }
+
+        void skipSpaces() {
+            while (position < text.size() && isspace(static_cast<unsigned char>(text[position]))) {
+                ++position;
+            }
+        }
+
+        bool accept(char c) {
+            skipSpaces();
+            if (position < text.size() && text[position] == c) {
+                ++position;
+                return true;
+            }
+            return false;
+        }
+
+        void emit(OpCode code, uint32_t operand = 0) {
+            if (code == OpCode::Constant || code == OpCode::Load) {
+                if (++depth > maxDepth) {
+                    fail("expresia este prea adanca");
+                }
+                expression.stackDepth = std::max(expression.stackDepth, depth);
+            } else if (code != OpCode::Negate && code != OpCode::Abs) {
+                --depth;
+            }
+            expression.program.push_back({code, operand});
+        }
+
+        void enter() {
+            if (++nesting > 256) {
+                fail("expresia este prea imbricata");
+            }
+        }
+
+        void parseSum() {
+            enter();
+            parseProduct();
+            while (true) {
+                if (accept('+')) {
+                    parseProduct();
+                    emit(OpCode::Add);
+                } else if (accept('-')) {
+                    parseProduct();
+                    emit(OpCode::Subtract);
+                } else {
+                    break;
+                }
+            }
+            --nesting;
+        }
+
+        void parseProduct() {
+            parseUnary();
+            while (true) {
+                if (accept('*')) {
+                    parseUnary();
+                    emit(OpCode::Multiply);
+                } else if (accept('/')) {
+                    parseUnary();
+                    emit(OpCode::Divide);
+                } else {
+                    return;
+                }
+            }
+        }
+
+        void parseUnary() {
+            if (accept('-')) {
+                enter();
+                parseUnary();
+                --nesting;
+                emit(OpCode::Negate);
+            } else if (accept('+')) {
+                enter();
+                parseUnary();
+                --nesting;
+            } else {
+                parsePrimary();
+            }
+        }
+
+        void parsePrimary() {
+            skipSpaces();
+            if (position >= text.size()) {
+                fail("operand asteptat");
+            }
+            if (accept('(')) {
+                parseSum();
+                if (!accept(')')) {
+                    fail("')' asteptat");
+                }
+                return;
+            }
+            char c = text[position];
+            if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                parseConstant();
+            } else if (isalpha(static_cast<unsigned char>(c))) {
+                parseName();
+            } else {
+                fail(string("caracter neasteptat '") + c + "'");
+            }
+        }
+
+        void parseConstant() {
+            size_t start = position;
+            while (position < text.size() && (isdigit(static_cast<unsigned char>(text[position])) || text[position] == '.')) {
+                ++position;
+            }
+            if (position < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+                size_t exponent = position + 1;
+                if (exponent < text.size() && (text[exponent] == '+' || text[exponent] == '-')) {
+                    ++exponent;
+                }
+                if (exponent < text.size() && isdigit(static_cast<unsigned char>(text[exponent]))) {
+                    position = exponent;
+                    while (position < text.size() && isdigit(static_cast<unsigned char>(text[position]))) {
+                        ++position;
+                    }
+                }
+            }
+            double value;
+            if (!parseNumber(string_view(text).substr(start, position - start), value)) {
+                position = start;
+                fail("numar invalid");
+            }
+            expression.constants.push_back(value);
+            emit(OpCode::Constant, static_cast<uint32_t>(expression.constants.size() - 1));
+        }
+
+        void parseName() {
+            size_t start = position;
+            while (position < text.size() && isalnum(static_cast<unsigned char>(text[position]))) {
+                ++position;
+            }
+            string_view name = string_view(text).substr(start, position - start);
+            if (name.size() > 4 && name.substr(0, 4) == "step") {
+                size_t stepNumber = 0;
+                from_chars_result result = from_chars(name.data() + 4, name.data() + name.size(), stepNumber);
+                if (result.ec != errc() || result.ptr != name.data() + name.size() || stepNumber == 0) {
+                    position = start;
+                    fail("referinta invalida '" + string(name) + "'");
+                }
+                vector<size_t> &references = expression.stepReferences;
+                size_t slot = find(references.begin(), references.end(), stepNumber) - references.begin();
+                if (slot == references.size()) {
+                    references.push_back(stepNumber);
+                }
+                emit(OpCode::Load, static_cast<uint32_t>(slot));
+                return;
+            }
+            OpCode code;
+            if (name == "min") {
+                code = OpCode::Min;
+            } else if (name == "max") {
+                code = OpCode::Max;
+            } else if (name == "abs") {
+                code = OpCode::Abs;
+            } else {
+                position = start;
+                fail("nume necunoscut '" + string(name) + "' (stepN, min, max, abs)");
+            }
+            if (!accept('(')) {
+                fail("'(' asteptat dupa " + string(name));
+            }
+            parseSum();
+            if (code == OpCode::Abs) {
+                emit(OpCode::Abs);
+            } else {
+                // min și max primesc oricâte argumente, reduse de la stânga la dreapta
+                while (accept(',')) {
+                    parseSum();
+                    emit(code);
+                }
+            }
+            if (!accept(')')) {
+                fail("')' asteptat");
+            }
+        }
+    };
+};
+
+class CalculusStep final : public Step {
+private:
+    int steps;
+    CalculusOperation operationKind = CalculusOperation::Unknown;  // Tradusă din `operation` la setare
+    vector<float> inputs;
+    AccumulationMode accumulation;
+    size_t sourceStep = 0;           // Pasul CSV sau text din care se citesc valorile; 0 = valorile din inputs
+    vector<size_t> inputSteps;       // Pașii NumberInput sau Calculus din care se iau valorile
+
+    struct Extra {
+        string operation;
+        CalculusExpression expression;   // Programul compilat, dacă operația este o expresie
+        string operationError;           // De ce textul operației nu a putut fi compilat
+        string sourceColumn;             // Coloana CSV sau valoarea analizei unui fișier text (TextStatistics::metric)
+        ColumnAggregate columnValues;    // Agregatele coloanei, după calculateFromSteps()
+        bool hasColumnValues = false;
+    };
+    StepExtra<Extra> extra;
+
+    // Suma valorilor, în modul de acumulare ales
+    double sumValues(const float *values, size_t count) const {
+        const CalculusKernels &kernels = calculusKernels();
+        switch (accumulation) {
+            case AccumulationMode::Double:
+                return kernels.sumDouble(values, count);
+            case AccumulationMode::Kahan:
+                return kernels.sumKahan(values, count);
+            default:
+                return kernels.sumFloat(values, count);
+        }
+    }
+
+    // Produsul valorilor; modurile Double și Kahan acumulează în double
+    double productValues(const float *values, size_t count) const {
+        const CalculusKernels &kernels = calculusKernels();
+        if (accumulation == AccumulationMode::Float) {
+            return kernels.productFloat(values, count);
+        }
+        return kernels.productDouble(values, count);
+    }
+
+    // Scăderea și împărțirea sunt calculate ca inputs[0] - sumă și inputs[0] / produs. Suma
+    // termenilor scăzuți și produsul împărțitorilor sunt acumulate mereu în double: în float ar
+    // pierde precizia (1e8 - 1e8 - 1 - 1) sau ar depăși domeniul (1e30 / 1e20 / 1e20) acolo unde
+    // evaluarea de la stânga la dreapta nu o face.
+    static double subtrahendSum(const float *values, size_t count) {
+        return calculusKernels().sumDouble(values, count);
+    }
+
+    static double divisorProduct(const float *values, size_t count) {
+        return calculusKernels().productDouble(values, count);
+    }
+
+public:
+    CalculusStep(int s) : steps(s), accumulation(AccumulationMode::Float) {}
+
+    float addition() const {
+        return static_cast<float>(sumValues(inputs.data(), inputs.size()));
+    }
+
+    float subtraction(ostream &out = cout) const {
+        if (inputs.size() >= 2) {
+            return static_cast<float>(inputs[0] - subtrahendSum(inputs.data() + 1, inputs.size() - 1));
+        } else {
+            out << "Operatia de scadere necesita cel putin doua valori." << endl;
+            return 0;
+        }
+    }
+
+    float multiplication() const {
+        return static_cast<float>(productValues(inputs.data(), inputs.size()));
+    }
+
+    float division(ostream &out = cout) const {
+        if (inputs.size() >= 2) {
+            if (calculusKernels().containsZero(inputs.data() + 1, inputs.size() - 1)) {
+                out << "Impartirea la 0 nu este permisa." << endl;
+                return 0;
+            }
+            return static_cast<float>(inputs[0] / divisorProduct(inputs.data() + 1, inputs.size() - 1));
+        } else {
+            out << "Operatia de impartire necesita cel putin doua valori." << endl;
+            return 0;
+        }
+    }
+
+    float min(ostream &out = cout) const {
+        if (!inputs.empty()) {
+            return calculusKernels().minimum(inputs.data(), inputs.size());
+        } else {
+            out << "Operatia de minim necesita cel putin o valoare." << endl;
+            return 0;
+        }
+    }
+
+    float max(ostream &out = cout) const {
+        if (!inputs.empty()) {
+            return calculusKernels().maximum(inputs.data(), inputs.size());
+        } else {
+            out << "Operatia de maxim necesita cel putin o valoare." << endl;
+            return 0;
+        }
+    }
+
+    float count() const {
+        return static_cast<float>(inputs.size());
+    }
+
+    float mean(ostream &out = cout) const {
+        if (!inputs.empty()) {
+            return static_cast<float>(sumValues(inputs.data(), inputs.size()) / inputs.size());
+        } else {
+            out << "Operatia de medie necesita cel putin o valoare." << endl;
+            return 0;
+        }
+    }
+
+    // Rezultatul operației pe agregatele coloanei CSV; acumularea se face mereu în double
+    float columnCalculation(ostream &out = cout) const {
+        const ColumnAggregate &values = extra->columnValues;
+        if (operationKind == CalculusOperation::Count) {
+            return static_cast<float>(values.count);
+        } else if (operationKind == CalculusOperation::Unknown || operationKind == CalculusOperation::Expression) {
+            out << "Operatie necunoscuta pentru o coloana CSV." << endl;
+            return 0;
+        } else if (values.count == 0) {
+            out << "Coloana '" << extra->sourceColumn << "' nu contine valori numerice." << endl;
+            return 0;
+        }
+        switch (operationKind) {
+            case CalculusOperation::Add:
+                return static_cast<float>(values.sum());
+            case CalculusOperation::Subtract:
+                if (values.count < 2) {
+                    out << "Operatia de scadere necesita cel putin doua valori." << endl;
+                    return 0;
+                }
+                return static_cast<float>(values.first - values.sumRest);
+            case CalculusOperation::Multiply:
+                return static_cast<float>(values.first * values.productRest);
+            case CalculusOperation::Divide:
+                if (values.count < 2) {
+                    out << "Operatia de impartire necesita cel putin doua valori." << endl;
+                    return 0;
+                }
+                if (values.zerosRest > 0) {
+                    out << "Impartirea la 0 nu este permisa." << endl;
+                    return 0;
+                }
+                return static_cast<float>(values.first / values.productRest);
+            case CalculusOperation::Min:
+                return static_cast<float>(values.minimum);
+            case CalculusOperation::Max:
+                return static_cast<float>(values.maximum);
+            default:
+                return static_cast<float>(values.sum() / values.count);
+        }
+    }
+
+    // Rezultatul expresiei pe valorile pașilor referiți (inputs[i] este valoarea referinței i)
+    float evaluateExpression(ostream &out = cout) const {
+        if (inputs.size() != extra->expression.references().size()) {
+            out << "Valorile pasilor din expresie nu au fost calculate." << endl;
+            return 0;
+        }
+        bool divisionByZero = false;
+        float result = extra->expression.evaluate(inputs.data(), divisionByZero);
+        if (divisionByZero) {
+            out << "Impartirea la 0 nu este permisa." << endl;
+            return 0;
+        }
+        return result;
+    }
+
+    // Rezultatul operației pe `count` valori citite direct din sloturile altor pași: value(i) dă
+    // valoarea i ca double (pentru o expresie, valoarea referinței i). Sumele sunt acumulate în
+    // double, cu compensare în modul Kahan; modul Float privește doar valorile introduse în pas.
+    template <typename Value>
+    double calculateValues(size_t count, Value &&value, ostream &out) const {
+        auto sum = [&](size_t first) {
+            double total = 0;
+            double compensation = 0;
+            for (size_t i = first; i < count; ++i) {
+                if (accumulation == AccumulationMode::Kahan) {
+                    double term = value(i) - compensation;
+                    double next = total + term;
+                    compensation = (next - total) - term;
+                    total = next;
+                } else {
+                    total += value(i);
+                }
+            }
+            return total;
+        };
+        auto product = [&](size_t first) {
+            double total = 1;
+            for (size_t i = first; i < count; ++i) {
+                total *= value(i);
+            }
+            return total;
+        };
+        switch (operationKind) {
+            case CalculusOperation::Add:
+                return sum(0);
+            case CalculusOperation::Subtract:
+                if (count < 2) {
+                    out << "Operatia de scadere necesita cel putin doua valori." << endl;
+                    return 0;
+                }
+                return value(0) - sum(1);
+            case CalculusOperation::Multiply:
+                return product(0);
+            case CalculusOperation::Divide:
+                if (count < 2) {
+                    out << "Operatia de impartire necesita cel putin doua valori." << endl;
+                    return 0;
+                }
+                for (size_t i = 1; i < count; ++i) {
+                    if (value(i) == 0) {
+                        out << "Impartirea la 0 nu este permisa." << endl;
+                        return 0;
+                    }
+                }
+                return value(0) / product(1);
+            case CalculusOperation::Min:
+            case CalculusOperation::Max: {
+                bool isMin = operationKind == CalculusOperation::Min;
+                if (count == 0) {
+                    out << "Operatia de " << (isMin ? "minim" : "maxim") << " necesita cel putin o valoare." << endl;
+                    return 0;
+                }
+                double result = value(0);
+                for (size_t i = 1; i < count; ++i) {
+                    result = isMin ? std::min(result, value(i)) : std::max(result, value(i));
+                }
+                return result;
+            }
+            case CalculusOperation::Count:
+                return static_cast<double>(count);
+            case CalculusOperation::Mean:
+                if (count == 0) {
+                    out << "Operatia de medie necesita cel putin o valoare." << endl;
+                    return 0;
+                }
+                return sum(0) / count;
+            case CalculusOperation::Expression: {
+                bool divisionByZero = false;
+                double result = extra->expression.evaluateWith(value, divisionByZero);
+                if (divisionByZero) {
+                    out << "Impartirea la 0 nu este permisa." << endl;
+                    return 0;
+                }
+                return result;
+            }
+            default:
+                out << (extra->operationError.empty() ? "Operatie necunoscuta." : extra->operationError) << endl;
+                return 0;
+        }
+    }
+
+    float performCalculation(ostream &out = cout) const {
+        if (sourceStep != 0) {
+            if (!extra->hasColumnValues) {
+                out << "Valorile din coloana '" << extra->sourceColumn << "' nu au fost calculate." << endl;
+                return 0;
+            }
+            return columnCalculation(out);
+        }
+        switch (operationKind) {
+            case CalculusOperation::Add: return addition();
+            case CalculusOperation::Subtract: return subtraction(out);
+            case CalculusOperation::Multiply: return multiplication();
+            case CalculusOperation::Divide: return division(out);
+            case CalculusOperation::Min: return min(out);
+            case CalculusOperation::Max: return max(out);
+            case CalculusOperation::Count: return count();
+            case CalculusOperation::Mean: return mean(out);
+            case CalculusOperation::Expression: return evaluateExpression(out);
+            default:
+                out << (extra->operationError.empty() ? "Operatie necunoscuta." : extra->operationError) << endl;
+                return 0;
+        }
+    }
+
+    void specifyOperation() {
+        cout << "Introduceti operatia pentru pasul 'Calculul' (+, -, *, /, min, max, count, mean): ";
+        string op;
+        cin >> op;
+        setOperation(op);
+    }
+
+    // Citește o expresie pe o linie, ex. (step1 + step2) / max(step3, 1); returnează false și
+    // afișează eroarea dacă expresia nu poate fi compilată
+    bool specifyExpression() {
+        cout << "Introduceti expresia (ex. (step1 + step2) / max(step3, 1)): ";
+        string text;
+        getline(cin >> ws, text);
+        setOperation(text);
+        if (operationKind != CalculusOperation::Expression) {
+            cout << (extra->operationError.empty() ? "Expresia este o operatie simpla, nu o expresie." : extra->operationError) << endl;
+            return false;
+        }
+        return true;
+    }
+
+    void specifyInput() {
+        cout << "Introduceti valorile pentru pasul 'Calculul':" << endl;
+        for (int i = 0; i < steps; ++i) {
+            float inputValue;
+            cout << "Valoare pentru pasul " << (i + 1) << ": ";
+            cin >> inputValue;
+            inputs.push_back(inputValue);
+        }
+    }
+
+    // Setează operația și valorile fără prompt (folosit de modul batch). Un text care nu este
+    // o operație cu nume este compilat ca expresie; pașii referiți devin pașii de intrare.
+    void setOperation(const string &op) {
+        Extra &data = extra.edit();
+        data.operation = op;
+        operationKind = parseCalculusOperation(op);
+        data.expression = CalculusExpression();
+        data.operationError.clear();
+        if (operationKind == CalculusOperation::Unknown && !op.empty()) {
+            try {
+                data.expression = CalculusExpression::compile(op);
+                operationKind = CalculusOperation::Expression;
+                inputSteps = data.expression.references();
+            } catch (const runtime_error &e) {
+                data.operationError = e.what();
+            }
+        }
+    }
+
+    CalculusOperation getOperationKind() const {
+        return operationKind;
+    }
+
+    const string &getOperationError() const {
+        return extra->operationError;
+    }
+
+    const CalculusExpression &getExpression() const {
+        return extra->expression;
+    }
+
+    // Există valori din care se poate calcula rezultatul (o expresie fără referințe are doar constante)
+    bool hasValues() const {
+        if (sourceStep != 0) {
+            return extra->hasColumnValues;
+        }
+        if (operationKind == CalculusOperation::Expression) {
+            return inputs.size() == extra->expression.references().size();
+        }
+        return !inputs.empty();
+    }
+
+    void setInputs(const vector<float> &values) {
+        inputs = values;
+        steps = static_cast<int>(values.size());
+    }
+
+    void setAccumulationMode(AccumulationMode mode) {
+        accumulation = mode;
+    }
+
+    AccumulationMode getAccumulationMode() const {
+        return accumulation;
+    }
+
+    // Valorile vor fi citite din coloana <column> a pasului CSV cu numărul <stepNumber>
+    void setColumnSource(size_t stepNumber, const string &column) {
+        sourceStep = stepNumber;
+        Extra &data = extra.edit();
+        data.sourceColumn = column;
+        data.hasColumnValues = false;
+    }
+
+    void specifyColumnSource() {
+        cout << "Introduceti numarul step-ului CSV sau text: ";
+        cin >> sourceStep;
+        cout << "Introduceti numele coloanei (pentru un fisier text: lines, words, bytes, matches, uniquewords): ";
+        Extra &data = extra.edit();
+        cin >> data.sourceColumn;
+        data.hasColumnValues = false;
+    }
+
+    // Valorile vor fi citite din pașii NumberInput sau Calculus cu numerele date, la fiecare recalculare
+    void setInputSteps(const vector<size_t> &stepNumbers) {
+        inputSteps = stepNumbers;
+    }
+
+    const vector<size_t> &getInputSteps() const {
+        return inputSteps;
+    }
+
+    size_t getSourceStep() const {
+        return sourceStep;
+    }
+
+    const string &getSourceColumn() const {
+        return extra->sourceColumn;
+    }
+
+    // Valorile vin din alți pași (coloană CSV, pași de intrare sau o expresie), nu sunt date direct
+    bool readsSteps() const {
+        return sourceStep != 0 || !inputSteps.empty() || operationKind == CalculusOperation::Expression;
+    }
+
+    // Citește valorile din pașii referiți (coloana CSV sau pașii de intrare), recalculează
+    // rezultatul și îl scrie în slotul pasului, `position`; definită după StepStore
+    bool calculateFromSteps(StepStore &steps, size_t position, ostream &out = cout);
+
+    // Rezultatul scris în slotul pasului, dacă pasul este într-un flow și a fost calculat
+    bool storedResult(const StepStore *steps, size_t position, double &result) const;
+
+    const string &getOperation() const {
+        return extra->operation;
+    }
+
+    const vector<float>& getInputs() const {
+        return inputs;
+    }
+
+    // Apelează function(valoare) pentru valorile calculului: cele introduse sau, pentru un pas din
+    // flow care citește alți pași și a fost calculat, valorile acestora, citite din sloturi
+    template <typename Function>
+    void forEachValue(const StepStore *steps, size_t position, Function &&function) const;
+
+    void getStepInfo(ostream &out) const override {
+        writeStepInfo(out, nullptr, 0);
+    }
+
+    // `steps` este nullptr pentru un pas din afara unui flow
+    void writeStepInfo(ostream &out, const StepStore *steps, size_t position) const {
+        out << "Operatie: " << extra->operation << endl;
+        if (sourceStep != 0) {
+            out << "Sursa: coloana '" << extra->sourceColumn << "' din step-ul " << sourceStep << endl;
+            if (extra->hasColumnValues) {
+                out << "Valori numerice: " << extra->columnValues.count;
+                if (extra->columnValues.skipped > 0) {
+                    out << " (" << extra->columnValues.skipped << " campuri ignorate)";
+                }
+                out << endl;
+            }
+        } else {
+            if (accumulation != AccumulationMode::Float) {
+                out << "Acumulare: " << accumulationModeName(accumulation) << endl;
+            }
+            if (!inputSteps.empty()) {
+                out << "Valori din step-urile:";
+                for (size_t stepNumber : inputSteps) {
+                    out << " " << stepNumber;
+                }
+                out << endl;
+            }
+            out << "Valori introduse:";
+            forEachValue(steps, position, [&out](double value) { out << " " << value; });
+            out << endl;
+        }
+        if (!extra->operation.empty()) {
+            double result = 0;
+            bool known = storedResult(steps, position, result);
+            if (!known && hasValues()) {
+                result = performCalculation(out);
+                known = true;
+            }
+            if (known) {
+                out << "Rezultat: " << result << endl;
+            }
+        }
+    }
+
+    StepKind getKind() const override {
+        return StepKind::Calculus;
+    }
+
+    void writeToFile(TextWriter &file) const {
+        writeStepFile(file, nullptr, 0);
+    }
+
+    void writeStepFile(TextWriter &file, const StepStore *steps, size_t position) const {
+        file << "CalculusStep" << '\n';
+        file << "Operatie: " << extra->operation << '\n';
+        if (sourceStep != 0) {
+            file << "Sursa: coloana '" << extra->sourceColumn << "' din step-ul " << sourceStep << '\n';
+            if (extra->hasColumnValues) {
+                file << "Valori numerice: " << extra->columnValues.count << '\n';
+                // Mesajele operației (de ex. o coloană fără valori) sunt scrise înaintea rezultatului
+                ostringstream messages;
+                float result = columnCalculation(messages);
+                file << messages.str() << "Rezultat: " << result << '\n';
+            }
+            return;
+        }
+        if (accumulation != AccumulationMode::Float) {
+            file << "Acumulare: " << accumulationModeName(accumulation) << '\n';
+        }
+        if (!inputSteps.empty()) {
+            file << "Valori din step-urile:";
+            for (size_t stepNumber : inputSteps) {
+                file << " " << stepNumber;
+            }
+            file << '\n';
+        }
+        file << "Valori introduse:";
+        forEachValue(steps, position, [&file](double value) { file << " " << value; });
+        file << '\n';
+    }
+
+    void writeBinary(BinaryWriter &out) const override {
+        out.write<int32_t>(steps);
+        out.writeString(extra->operation);
+        out.write<uint32_t>(static_cast<uint32_t>(inputs.size()));
+        for (float value : inputs) {
+            out.write<float>(value);
+        }
+        out.write<uint8_t>(static_cast<uint8_t>(accumulation));
+        out.write<uint64_t>(sourceStep);
+        out.writeString(extra->sourceColumn);
+        out.write<uint32_t>(static_cast<uint32_t>(inputSteps.size()));
+        for (size_t stepNumber : inputSteps) {
+            out.write<uint64_t>(stepNumber);
+        }
+    }
+
+    void writeDefinition(TextWriter &out) const override {
+        out << extra->operation;
+        if (operationKind != CalculusOperation::Expression) {
+            out << " | ";
+            double metric;
+            if (sourceStep != 0) {
+                // Ambele forme sunt citite la fel; "text" doar pentru valorile unei analize de text
+                out << (TextStatistics().metric(extra->sourceColumn, metric) ? "text " : "csv ") << sourceStep << ' ' << extra->sourceColumn;
+            } else if (!inputSteps.empty()) {
+                out << "steps";
+                for (size_t stepNumber : inputSteps) {
+                    out << ' ' << stepNumber;
+                }
+            } else {
+                for (size_t i = 0; i < inputs.size(); ++i) {
+                    if (i > 0) {
+                        out << ' ';
+                    }
+                    out.exact(inputs[i]);
+                }
+            }
+        } else if (accumulation != AccumulationMode::Float) {
+            out << " | ";
+        }
+        if (accumulation != AccumulationMode::Float) {
+            out << " | " << accumulationModeName(accumulation);
+        }
+    }
+};
+
+class TitleStep final : public Step
+{
+    private:
+        string title, subtitle;
+    public:
+        TitleStep(const string &t, const string &s)
+        {
+            this->title = t;
+            this->subtitle = s;
+        }
+        const string &getTitle() const
+        {
+            return title;
+        }
+
+        const string &getSubtitle() const
+        {
+            return subtitle;
+        }
+        void getStepInfo(ostream &out) const override
+        {
+            out << "Titlu: " << title << endl;
+            out << "Subtitlu: " << subtitle << endl;
+        }
+
+        StepKind getKind() const override
+        {
+            return StepKind::Title;
+        }
+
+        void writeToFile(TextWriter &file) const
+        {
+            file << "TitleStep" << '\n';
+            file << "Title: " << title << '\n';
+            file << "Subtitle: " << subtitle << '\n';
+        }
+
+        void writeBinary(BinaryWriter &out) const override
+        {
+            out.writeString(title);
+            out.writeString(subtitle);
+        }
+
+        void writeDefinition(TextWriter &out) const override
+        {
+            out << title << " | " << subtitle;
+        }
+};
+
+class TextStep final : public Step
+{
+    private:
+        string title, copy;
+    public:
+        TextStep(const string &t, const string &c)
+        {
+            this->title = t;
+            this->copy = c;
+        }
+        const string &getTitle() const
+        {
+            return title;
+        }
+
+        const string &getCopy() const
+        {
+            return copy;
+        }
+        void getStepInfo(ostream &out) const override
+        {
+            out << "Titlu: " << title << endl;
+            out << "Copie: " << copy << endl;
+        }
+        StepKind getKind() const override
+        {
+            return StepKind::Text;
+        }
+
+        void writeToFile(TextWriter &file) const
+        {
+            file << "TextStep" << '\n';
+            file << "Title: " << title << '\n';
+            file << "Copie: " << copy << '\n';
+        }
+
+        void writeBinary(BinaryWriter &out) const override
+        {
+            out.writeString(title);
+            out.writeString(copy);
+        }
+
+        void writeDefinition(TextWriter &out) const override
+        {
+            out << title << " | " << copy;
+        }
+};
+
+// Șirurile distincte ale aplicației, păstrate o singură dată. Pașii TextInput și sloturile
+// flow-urilor împart același șir; el este scos din pool și eliberat odată cu ultima referință,
+// deci memoria rămâne proporțională cu valorile distincte în uz.
+class StringPool {
+public:
+    using Handle = shared_ptr<const string>;
+
+    Handle intern(string_view text) {
+        lock_guard<mutex> lock(poolMutex);
+        auto it = strings.find(text);
+        if (it != strings.end()) {
+            if (Handle existing = it->second.lock()) {
+                return existing;
+            }
+            strings.erase(it);  // Ultima referință tocmai a dispărut; release() nu a rulat încă
+        }
+        Handle created(new string(text), [this](const string *value) { release(value); });
+        strings.emplace(*created, created);
+        return created;
+    }
+
+    size_t size() const {
+        lock_guard<mutex> lock(poolMutex);
+        return strings.size();
+    }
+
+private:
+    mutable mutex poolMutex;
+    unordered_map<string_view, weak_ptr<const string>> strings;  // Cheile indică în șirurile din pool
+
+    // Apelat la eliberarea ultimei referințe. Între timp același text poate fi internat din nou,
+    // într-un șir nou: intrarea este ștearsă doar dacă este încă a acestui șir.
+    void release(const string *value) {
+        {
+            lock_guard<mutex> lock(poolMutex);
+            auto it = strings.find(*value);
+            if (it != strings.end() && it->first.data() == value->data()) {
+                strings.erase(it);
+            }
+        }
+        delete value;
+    }
+};
+
+// Instanța nu este distrusă niciodată: șirurile pașilor statici pot fi eliberate după ea
+StringPool &stringPool() {
+    static StringPool *pool = new StringPool();
+    return *pool;
+}
+
+class TextInputStep final : public Step {
+private:
+    string description;
+    bool hasUserInput;  // Indică dacă input-ul a fost deja introdus
+    StringPool::Handle text_input;  // Input-ul specific pasului, internat; nullptr până la setare
+
+public:
+    TextInputStep(const string &d) {
+        this->description = d;
+        this->hasUserInput = false;
+    }
+
+    // Introduce descrierea pasului
+    void inputDescription() {
+        cout << "Introduceti descrierea: ";
+        cin.ignore();  // Ignorăm orice caracter rămas în buffer
+        getline(cin, description);
+    }
+
+    // Specifică input-ul pasului
+    void specifyInput() {
+        if (!hasUserInput) {
+            cout << "Introduceti input-ul pentru pasul '" << description << "': ";
+            cin.ignore();  // Ignorăm orice caracter rămas în buffer
+            string value;
+            getline(cin, value);
+            setInput(value);
+        }
+    }
+
+    // Setează input-ul fără prompt (folosit de modul batch)
+    void setInput(string_view value) {
+        text_input = stringPool().intern(value);
+        hasUserInput = true;
+    }
+
+    const string &getTextInput() const {
+        static const string empty;
+        return text_input ? *text_input : empty;
+    }
+
+    // Șirul internat, împărțit cu slotul pasului din tabelul de valori
+    const StringPool::Handle &getSharedText() const {
+        return text_input;
+    }
+
+    const string &getDescription() const {
+        return description;
+    }
+
+    void getStepInfo(ostream &out) const override {
+        out << "Descriere: " << description << endl;
+        if (hasUserInput) {
+            out << "Input :" << getTextInput() << endl;
+        }
+    }
+
+    StepKind getKind() const override {
+        return StepKind::TextInput;
+    }
+
+    void writeToFile(TextWriter &file) const
+    {   
+        file << "TextInputStep" << '\n';
+        file << "Descriere: " << description << '\n';
+        if (hasUserInput) {
+            file << "Input: " << getTextInput() << '\n';
+        }   
+    }
+
+    void writeBinary(BinaryWriter &out) const override {
+        out.writeString(description);
+        out.write<uint8_t>(hasUserInput);
+        out.writeString(getTextInput());
+    }
+
+    void writeDefinition(TextWriter &out) const override {
+        out << description;
+        if (hasUserInput) {
+            out << " | " << getTextInput();
+        }
+    }
+};
+
+// Bufferul inițial al lui cout; modul batch silențios îl înlocuiește temporar
+streambuf *const initialCoutBuffer = cout.rdbuf();
+
+// Scrie un bloc mare în stdout dintr-o singură bucată, fără flush pe fiecare linie. Când cout
+// scrie în consolă, blocul (de obicei direct din fișierul mapat) ajunge la write() fără copii
+// intermediare; când cout a fost redirecționat, blocul trece prin cout.
+void writeToConsole(const char *data, size_t size) {
+    if (cout.rdbuf() != initialCoutBuffer) {
+        cout.write(data, static_cast<streamsize>(size));
+        return;
+    }
+    cout.flush();
+    fflush(stdout);
+#ifdef _WIN32
+    fwrite(data, 1, size, stdout);
+    fflush(stdout);
+#else
+    while (size > 0) {
+        ssize_t written = ::write(STDOUT_FILENO, data, std::min<size_t>(size, 1 << 30));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "Eroare la scrierea in consola!" << endl;
+            return;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+#endif
+}
+
+// Ce parte a fișierului afișează un DisplayStep
+enum class DisplayMode : uint8_t {
+    All,    // Tot fișierul
+    Head,   // Primele <count> linii
+    Tail,   // Ultimele <count> linii
+    Lines,  // <count> linii începând cu linia <first> (numerotate de la 1)
+    Bytes,  // <count> octeți începând cu octetul <first>
+    Pages   // Tot fișierul, câte <count> linii pe pagină, cu navigare interactivă
+};
+
+struct DisplayRange {
+    DisplayMode mode = DisplayMode::All;
+    uint64_t first = 0;
+    uint64_t count = 0;
+};
+
+// Scrie forma textuală a intervalului, aceeași pe care o acceptă parseDisplayRange
+void writeDisplayRange(TextWriter &out, const DisplayRange &range) {
+    switch (range.mode) {
+        case DisplayMode::Head: out << "head " << range.count; break;
+        case DisplayMode::Tail: out << "tail " << range.count; break;
+        case DisplayMode::Lines: out << "lines " << range.first << ' ' << range.first + range.count - 1; break;
+        case DisplayMode::Bytes: out << "bytes " << range.first << ' ' << range.count; break;
+        case DisplayMode::Pages: out << "pages " << range.count; break;
+        default: out << "all"; break;
+    }
+}
+
+string describeDisplayRange(const DisplayRange &range) {
+    string text;
+    StringSink sink(text);
+    {
+        TextWriter out(sink);
+        writeDisplayRange(out, range);
+    }
+    return text;
+}
+
+// all | head <n> | tail <n> | lines <prima> <ultima> | bytes <offset> <lungime> | pages <linii pe pagina>
+DisplayRange parseDisplayRange(string_view text) {
+    string_view rest = text;
+    string_view mode = nextToken(rest);
+    DisplayRange range;
+    if (mode.empty() || mode == "all") {
+        return range;
+    }
+    uint64_t a = 0, b = 0;
+    if (mode == "head" || mode == "tail" || mode == "pages") {
+        if (!parseNumber(nextToken(rest), a) || a == 0) {
+            throw runtime_error("Interval de afisare invalid: " + string(text));
+        }
+        range.mode = mode == "head" ? DisplayMode::Head : mode == "tail" ? DisplayMode::Tail : DisplayMode::Pages;
+        range.count = a;
+    } else if (mode == "lines") {
+        if (!parseNumber(nextToken(rest), a) || !parseNumber(nextToken(rest), b) || a == 0 || b < a) {
+            throw runtime_error("Interval de linii invalid: " + string(text));
+        }
+        range.mode = DisplayMode::Lines;
+        range.first = a;
+        range.count = b - a + 1;
+    } else if (mode == "bytes") {
+        if (!parseNumber(nextToken(rest), a) || !parseNumber(nextToken(rest), b)) {
+            throw runtime_error("Interval de octeti invalid: " + string(text));
+        }
+        range.mode = DisplayMode::Bytes;
+        range.first = a;
+        range.count = b;
+    } else {
+        throw runtime_error("Mod de afisare necunoscut: " + string(mode));
+    }
+    return range;
+}
+
+// Fișier mapat în memorie cu indexul începuturilor de linie. Indexul este construit la prima
+// cerere care are nevoie de el; după aceea, găsirea liniei N este O(1).
+class LineIndexedFile {
+private:
+    MappedFile file;
+    vector<uint64_t> lineStarts;
+    // Același fișier este folosit din mai multe fire (openLineIndexedFile): indexul este construit o
+    // singură dată, iar `indexed` devine true abia după ce lineStarts este complet
+    once_flag indexOnce;
+    atomic<bool> indexed{false};
+
+    void buildIndex() {
+        const char *data = file.getData();
+        size_t size = file.getSize();
+        lineStarts.clear();
+        if (size > 0) {
+            lineStarts.reserve(size / 64 + 1);
+            lineStarts.push_back(0);
+            const char *end = data + size;
+            for (const char *p = data; (p = static_cast<const char *>(memchr(p, '\n', end - p))) != nullptr;) {
+                ++p;
+                if (p == end) {
+                    break;
+                }
+                lineStarts.push_back(static_cast<uint64_t>(p - data));
+            }
+        }
+        indexed.store(true, memory_order_release);
+    }
+
+public:
+    // Se apelează o singură dată, înainte ca fișierul să fie împărțit între fire
+    bool open(const string &path) {
+        return file.open(path);
+    }
+
+    const char *getData() const {
+        return file.getData();
+    }
+
+    size_t getSize() const {
+        return file.getSize();
+    }
+
+    bool isIndexed() const {
+        return indexed.load(memory_order_acquire);
+    }
+
+    size_t lineCount() {
+        call_once(indexOnce, [this] { buildIndex(); });
+        return lineStarts.size();
+    }
+
+    // Octeții [begin, end) ai liniilor [first, first + count), numerotate de la 0
+    pair<size_t, size_t> lineRange(size_t first, size_t count) {
+        size_t lines = lineCount();
+        if (first >= lines) {
+            return {getSize(), getSize()};
+        }
+        size_t last = first + std::min(count, lines - first);
+        return {lineStarts[first], last < lines ? lineStarts[last] : getSize()};
+    }
+
+    // Primele <count> linii; fără index, scanează doar până la sfârșitul lor
+    pair<size_t, size_t> headRange(size_t count) {
+        if (isIndexed()) {
+            return lineRange(0, count);
+        }
+        const char *data = getData();
+        const char *end = data + getSize();
+        const char *p = data;
+        for (size_t line = 0; line < count && p != nullptr && p < end; ++line) {
+            p = static_cast<const char *>(memchr(p, '\n', end - p));
+            if (p != nullptr) {
+                ++p;
+            }
+        }
+        return {0, p != nullptr ? static_cast<size_t>(p - data) : getSize()};
+    }
+
+    // Ultimele <count> linii; fără index, scanează de la sfârșitul fișierului înapoi
+    pair<size_t, size_t> tailRange(size_t count) {
+        if (isIndexed()) {
+            size_t lines = lineStarts.size();
+            return lineRange(lines - std::min(count, lines), count);
+        }
+        const char *data = getData();
+        size_t position = getSize();
+        if (position > 0 && data[position - 1] == '\n') {
+            position--;
+        }
+        size_t found = 0;
+        while (position > 0) {
+            if (data[position - 1] == '\n' && ++found == count) {
+                break;
+            }
+            position--;
+        }
+        return {position, getSize()};
+    }
+};
+
+// Fișierele deja indexate, refolosite cât timp nu se schimbă dimensiunea sau data modificării
+// (cu nanosecunde, ca o rescriere în aceeași secundă să nu refolosească indexul vechi)
+shared_ptr<LineIndexedFile> openLineIndexedFile(const string &path) {
+    struct CacheEntry {
+        shared_ptr<LineIndexedFile> file;
+        uint64_t size;
+        int64_t modified;
+    };
+    static mutex cacheMutex;
+    static vector<pair<string, CacheEntry>> cache;
+    const size_t cacheCapacity = 8;
+
+    uint64_t size = 0;
+    int64_t modified = 0;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)) {
+        return nullptr;
+    }
+    size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+    modified = (static_cast<int64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return nullptr;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+#ifdef __APPLE__
+    modified = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    modified = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+#endif
+
+    lock_guard<mutex> lock(cacheMutex);
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+        if (it->first == path) {
+            if (it->second.size == size && it->second.modified == modified) {
+                return it->second.file;
+            }
+            cache.erase(it);
+            break;
+        }
+    }
+    shared_ptr<LineIndexedFile> file = make_shared<LineIndexedFile>();
+    if (!file->open(path)) {
+        return nullptr;
+    }
+    if (cache.size() == cacheCapacity) {
+        cache.erase(cache.begin());
+    }
+    cache.push_back({path, {file, size, modified}});
+    return file;
+}
+
+class DisplayStep final : public Step {
+private:
+    size_t stepNumber;
+    DisplayRange range;
+
+    // Afișează interactiv câte range.count linii pe pagină; citește comenzile de navigare din cin
+    void displayPages(LineIndexedFile &file) const {
+        size_t pageSize = static_cast<size_t>(range.count);
+        size_t pageCount = (file.lineCount() + pageSize - 1) / pageSize;
+        size_t page = 0;
+        while (page < pageCount) {
+            pair<size_t, size_t> bytes = file.lineRange(page * pageSize, pageSize);
+            writeToConsole(file.getData() + bytes.first, bytes.second - bytes.first);
+            if (bytes.second > bytes.first && file.getData()[bytes.second - 1] != '\n') {
+                cout << endl;
+            }
+            if (page + 1 == pageCount) {
+                break;
+            }
+            cout << "-- Pagina " << (page + 1) << "/" << pageCount << " (n = urmatoarea, p = anterioara, <numar> = pagina, q = iesire): ";
+            string command;
+            if (!(cin >> command) || command == "q") {
+                break;
+            } else if (command == "p") {
+                page = page > 0 ? page - 1 : 0;
+            } else if (!command.empty() && isdigit(static_cast<unsigned char>(command[0]))) {
+                size_t requested = strtoull(command.c_str(), nullptr, 10);
+                page = requested >= 1 && requested <= pageCount ? requested - 1 : page;
+            } else {
+                page++;
+            }
+        }
+    }
+
+public:
+    DisplayStep(size_t stepNum, DisplayRange range = DisplayRange()) : stepNumber(stepNum), range(range) {}
+
+    void specifyStepNumber() {
+        cout << "Introduceti numarul pasului pentru care doriti sa afisati continutul: ";
+        cin >> stepNumber;
+    }
+
+    void specifyRange() {
+        cout << "Ce parte a fisierului doriti sa afisati? (all, head <n>, tail <n>, lines <prima> <ultima>, bytes <offset> <lungime>, pages <linii pe pagina>): ";
+        string text;
+        cin >> ws;
+        getline(cin, text);
+        try {
+            range = parseDisplayRange(text);
+        } catch (const exception &e) {
+            cerr << e.what() << " Se afiseaza tot fisierul." << endl;
+            range = DisplayRange();
+        }
+    }
+
+    const DisplayRange &getRange() const {
+        return range;
+    }
+
+    size_t getStepNumber() const {
+        return stepNumber;
+    }
+
+    void getStepInfo(ostream &out) const override {
+        out << "Numarul pasului pentru afisare: " << stepNumber << endl;
+        if (range.mode != DisplayMode::All) {
+            out << "Interval: " << describeDisplayRange(range) << endl;
+        }
+    }
+
+    // Definită după StepStore
+    void displayContent(const StepStore &steps, ostream &out = cout) const;
+
+    // Afișează intervalul ales din fișier. Fișierul este mapat în memorie și scris în blocuri
+    // mari direct din mapare; indexul de linii este păstrat între afișări. Afișarea pe pagini
+    // este interactivă și se face doar în consolă; în alt stream se scrie tot fișierul.
+    void displayFileContent(const string &fileName, ostream &out = cout) const {
+        EventCounters &counters = flowAnalytics().operation(AnalyticsOperation::Display);
+        ScopedTimer timer(counters);
+        shared_ptr<LineIndexedFile> file = openLineIndexedFile(fileName);
+        if (!file) {
+            timer.fail();
+            out << "Eroare la deschiderea fisierului pentru afisare!" << endl;
+            return;
+        }
+
+        pair<size_t, size_t> bytes(0, file->getSize());
+        switch (range.mode) {
+            case DisplayMode::Head:
+                bytes = file->headRange(static_cast<size_t>(range.count));
+                break;
+            case DisplayMode::Tail:
+                bytes = file->tailRange(static_cast<size_t>(range.count));
+                break;
+            case DisplayMode::Lines:
+                if (range.first > file->lineCount()) {
+                    out << "Fisierul are doar " << file->lineCount() << " linii." << endl;
+                    return;
+                }
+                bytes = file->lineRange(static_cast<size_t>(range.first - 1), static_cast<size_t>(range.count));
+                break;
+            case DisplayMode::Bytes:
+                if (range.first >= file->getSize()) {
+                    out << "Fisierul are doar " << file->getSize() << " octeti." << endl;
+                    return;
+                }
+                bytes.first = static_cast<size_t>(range.first);
+                // Lungimea este limitată la restul fișierului, deci first + count nu poate depăși size_t
+                bytes.second = bytes.first + static_cast<size_t>(std::min<uint64_t>(range.count, file->getSize() - range.first));
+                break;
+            case DisplayMode::Pages:
+                if (&out == &cout) {
+                    displayPages(*file);
+                    return;
+                }
+                break;
+            default:
+                break;
+        }
+        if (bytes.second < bytes.first) {
+            timer.fail();
+            return;
+        }
+        counters.addBytesRead(bytes.second - bytes.first);
+        if (&out == &cout) {
+            writeToConsole(file->getData() + bytes.first, bytes.second - bytes.first);
+        } else {
+            out.write(file->getData() + bytes.first, static_cast<streamsize>(bytes.second - bytes.first));
+        }
+        if (bytes.second > bytes.first && file->getData()[bytes.second - 1] != '\n') {
+            out << endl;
+        }
+    }
+
+    StepKind getKind() const override {
+        return StepKind::Display;
+    }
+
+    void writeToFile(TextWriter &file) const {
+        file << "DisplayStep" << '\n';
+        file << "Numarul pasului pentru afisare: " << stepNumber << '\n';
+        if (range.mode != DisplayMode::All) {
+            file << "Interval: " << describeDisplayRange(range) << '\n';
+        }
+    }
+
+    void writeBinary(BinaryWriter &out) const override {
+        out.write<uint64_t>(stepNumber);
+        out.write<uint8_t>(static_cast<uint8_t>(range.mode));
+        out.write<uint64_t>(range.first);
+        out.write<uint64_t>(range.count);
+    }
+
+    void writeDefinition(TextWriter &out) const override {
+        out << stepNumber;
+        if (range.mode != DisplayMode::All) {
+            out << " | ";
+            writeDisplayRange(out, range);
+        }
+    }
+};
+
+// Toate tipurile de pași, în aceeași ordine ca StepKind (indexul din variant este tipul pasului)
+using StepValue = variant<TitleStep, TextStep, TextInputStep, NumberInputStep, CalculusStep,
+                          TextFileInputStep, CSVFileInputStep, OutputStep, DisplayStep, EndStep>;
+
+static_assert(variant_size<StepValue>::value == stepKindCount, "StepValue trebuie sa contina toate tipurile din StepKind");
+static_assert(is_same<variant_alternative_t<static_cast<size_t>(StepKind::Calculus), StepValue>, CalculusStep>::value,
+              "Ordinea din StepValue trebuie sa fie aceeasi cu StepKind");
+static_assert(is_same<variant_alternative_t<static_cast<size_t>(StepKind::End), StepValue>, EndStep>::value,
+              "Ordinea din StepValue trebuie sa fie aceeasi cu StepKind");
+
+// Buffer care ignoră tot ce se scrie în el (folosit pentru a suprima output-ul în modul batch)
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override {
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char *, streamsize n) override {
+        return n;
+    }
+};
+
+// Tipul valorii produse de un pas, păstrată în FlowValues
+enum class ValueKind : uint8_t { None, Number, Text, Table, Statistics };
+
+// Tabelul de valori al unui flow, pe coloane, cu un slot pentru fiecare pas (slotul este poziția
+// pasului): numerele (input-urile NumberInput și rezultatele Calculus) ca double, textele
+// TextInput ca șiruri internate în stringPool(), împărțite cu pașii, iar conținutul fișierelor
+// (tabelul CSV, analiza unui fișier text) prin referință, fără copiere. Rezultatele Calculus
+// există doar aici. Pașii Calculus și rapoartele Output citesc valoarea oricărui pas în O(1),
+// după slot. Slotul unui text sau al unui fișier își rezervă intrarea la adăugarea pasului, deci
+// pașii care rulează în paralel scriu doar în sloturile lor, fără realocări.
+class FlowValues {
+private:
+    vector<ValueKind> kinds;
+    vector<double> numbers;
+    vector<uint32_t> references;  // Indicele din `texts`, `tables` sau `statistics`
+    vector<StringPool::Handle> texts;
+    vector<shared_ptr<const CsvTable>> tables;
+    vector<shared_ptr<const TextStatistics>> statistics;
+
+public:
+    size_t size() const {
+        return kinds.size();
+    }
+
+    // Adaugă un slot gol; un pas TextInput sau unul care citește un fișier își rezervă referința
+    // (`reserved` = Text, Table sau Statistics)
+    void append(ValueKind reserved = ValueKind::None) {
+        kinds.push_back(ValueKind::None);
+        numbers.push_back(0);
+        if (reserved == ValueKind::Text) {
+            references.push_back(static_cast<uint32_t>(texts.size()));
+            texts.emplace_back();
+        } else if (reserved == ValueKind::Table) {
+            references.push_back(static_cast<uint32_t>(tables.size()));
+            tables.emplace_back();
+        } else if (reserved == ValueKind::Statistics) {
+            references.push_back(static_cast<uint32_t>(statistics.size()));
+            statistics.emplace_back();
+        } else {
+            references.push_back(0);
+        }
+    }
+
+    void reserve(size_t count) {
+        kinds.reserve(count);
+        numbers.reserve(count);
+        references.reserve(count);
+    }
+
+    ValueKind kind(size_t slot) const {
+        return kinds[slot];
+    }
+
+    double number(size_t slot) const {
+        return numbers[slot];
+    }
+
+    string_view text(size_t slot) const {
+        return kinds[slot] == ValueKind::Text ? string_view(*texts[references[slot]]) : string_view();
+    }
+
+    // nullptr dacă fișierul nu este încărcat
+    const CsvTable *table(size_t slot) const {
+        return kinds[slot] == ValueKind::Table ? tables[references[slot]].get() : nullptr;
+    }
+
+    const TextStatistics *textStatistics(size_t slot) const {
+        return kinds[slot] == ValueKind::Statistics ? statistics[references[slot]].get() : nullptr;
+    }
+
+    void clear(size_t slot) {
+        kinds[slot] = ValueKind::None;
+    }
+
+    void setNumber(size_t slot, double value) {
+        numbers[slot] = value;
+        kinds[slot] = ValueKind::Number;
+    }
+
+    // Sloturile de text și de fișier trebuie rezervate la append()
+    void setText(size_t slot, StringPool::Handle value) {
+        kinds[slot] = value ? ValueKind::Text : ValueKind::None;
+        texts[references[slot]] = move(value);
+    }
+
+    void setTable(size_t slot, shared_ptr<const CsvTable> value) {
+        kinds[slot] = value ? ValueKind::Table : ValueKind::None;
+        tables[references[slot]] = move(value);
+    }
+
+    void setStatistics(size_t slot, shared_ptr<const TextStatistics> value) {
+        kinds[slot] = value ? ValueKind::Statistics : ValueKind::None;
+        statistics[references[slot]] = move(value);
+    }
+
+    // Textele distincte referite de sloturi
+    size_t distinctTexts() const {
+        unordered_set<const string *> distinct;
+        for (const StringPool::Handle &text : texts) {
+            if (text) {
+                distinct.insert(text.get());
+            }
+        }
+        return distinct.size();
+    }
+};
+
+// Pașii unui flow, stocați contiguu, după valoare. Tipul unui pas este indexul din variant,
+// iar accesul prin interfața Step trece printr-un switch generat de std::visit, fără RTTI.
+class StepStore {
+private:
+    vector<StepValue> steps;
+    FlowValues values;  // Valoarea produsă de fiecare pas, pe poziția lui
+
+public:
+    size_t size() const {
+        return steps.size();
+    }
+
+    bool empty() const {
+        return steps.empty();
+    }
+
+    void reserve(size_t count) {
+        steps.reserve(count);
+        values.reserve(count);
+    }
+
+    StepKind kind(size_t position) const {
+        return static_cast<StepKind>(steps[position].index());
+    }
+
+    Step &operator[](size_t position) {
+        return visit([](auto &step) -> Step & { return step; }, steps[position]);
+    }
+
+    const Step &operator[](size_t position) const {
+        return visit([](const auto &step) -> const Step & { return step; }, steps[position]);
+    }
+
+    // Pasul de pe poziția dată, de tipul concret T (tipul trebuie verificat în prealabil cu kind())
+    template <typename T>
+    T &as(size_t position) {
+        return get<T>(steps[position]);
+    }
+
+    template <typename T>
+    const T &as(size_t position) const {
+        return get<T>(steps[position]);
+    }
+
+    StepValue &value(size_t position) {
+        return steps[position];
+    }
+
+    const StepValue &value(size_t position) const {
+        return steps[position];
+    }
+
+    template <typename T>
+    T &push(T &&step) {
+        steps.emplace_back(in_place_type<decay_t<T>>, forward<T>(step));
+        using Stored = decay_t<T>;
+        values.append(is_same<Stored, TextInputStep>::value       ? ValueKind::Text
+                      : is_same<Stored, CSVFileInputStep>::value  ? ValueKind::Table
+                      : is_same<Stored, TextFileInputStep>::value ? ValueKind::Statistics
+                                                                  : ValueKind::None);
+        publish(steps.size() - 1);
+        return get<Stored>(steps.back());
+    }
+
+    const FlowValues &getValues() const {
+        return values;
+    }
+
+    // Publică în tabelul de valori valoarea curentă a pasului, după ce pasul a fost modificat.
+    // Un Calculus își scrie rezultatul la calcul (calculateFromSteps), deci aici nu se calculează
+    // nimic. Pașii de pe poziții diferite pot fi publicați în paralel.
+    void publish(size_t position) {
+        switch (kind(position)) {
+            case StepKind::NumberInput:
+                values.setNumber(position, as<NumberInputStep>(position).getNumberInput());
+                break;
+            case StepKind::TextInput:
+                values.setText(position, as<TextInputStep>(position).getSharedText());
+                break;
+            case StepKind::CSVFileInput:
+                values.setTable(position, as<CSVFileInputStep>(position).getSharedTable());
+                break;
+            case StepKind::TextFileInput:
+                values.setStatistics(position, as<TextFileInputStep>(position).getSharedStatistics());
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Rezultatul unui pas Calculus, scris doar de pasul însuși
+    void setResult(size_t position, double result) {
+        values.setNumber(position, result);
+    }
+
+    void clearResult(size_t position) {
+        values.clear(position);
+    }
+
+    // Valoarea numerică a pasului NumberInput sau Calculus de pe poziția dată. Un Calculus încă
+    // necalculat este calculat acum din valorile introduse, fără ca rezultatul să fie păstrat.
+    double number(size_t position, ostream &out) const;
+
+    // Informațiile pasului; un Calculus își ia rezultatul și valorile citite din alți pași din sloturi
+    void writeInfo(size_t position, ostream &out) const;
+    void writeToFile(size_t position, TextWriter &file) const;
+};
+
+// Listă persistentă de pași: fiecare modificare returnează o listă nouă, iar cea veche rămâne
+// neschimbată. Pașii sunt frunzele unui arbore binar de căutare aleator (după poziție) cu noduri
+// imutabile; o modificare copiază doar drumul până la pozițiile atinse, deci costă O(log n)
+// așteptat, iar versiunile împart restul nodurilor și pașii nemodificați.
+class StepList {
+private:
+    struct Node;
+    using NodePtr = shared_ptr<const Node>;
+    using StepPtr = shared_ptr<const StepValue>;
+
+    struct Node {
+        StepPtr step;
+        NodePtr left;
+        NodePtr right;
+        size_t size;
+    };
+
+    NodePtr root;
+
+    explicit StepList(NodePtr root) : root(move(root)) {}
+
+    static size_t sizeOf(const NodePtr &node) {
+        return node ? node->size : 0;
+    }
+
+    static NodePtr makeNode(StepPtr step, NodePtr left, NodePtr right) {
+        size_t size = sizeOf(left) + sizeOf(right) + 1;
+        return make_shared<const Node>(Node{move(step), move(left), move(right), size});
+    }
+
+    // Alegerile aleatoare țin arborele echilibrat în medie, indiferent de ordinea modificărilor
+    static size_t randomBelow(size_t bound) {
+        static thread_local mt19937_64 generator(0x5EED);
+        return static_cast<size_t>(generator() % bound);
+    }
+
+    // Concatenează două liste; rădăcina este aleasă proporțional cu mărimile (Martínez-Roura)
+    static NodePtr join(const NodePtr &first, const NodePtr &second) {
+        if (!first) {
+            return second;
+        }
+        if (!second) {
+            return first;
+        }
+        if (randomBelow(first->size + second->size) < first->size) {
+            return makeNode(first->step, first->left, join(first->right, second));
+        }
+        return makeNode(second->step, join(first, second->left), second->right);
+    }
+
+    // Primii `count` pași și restul
+    static pair<NodePtr, NodePtr> split(const NodePtr &node, size_t count) {
+        if (!node) {
+            return {};
+        }
+        size_t leftSize = sizeOf(node->left);
+        if (count <= leftSize) {
+            pair<NodePtr, NodePtr> parts = split(node->left, count);
+            return {move(parts.first), makeNode(node->step, move(parts.second), node->right)};
+        }
+        pair<NodePtr, NodePtr> parts = split(node->right, count - leftSize - 1);
+        return {makeNode(node->step, node->left, move(parts.first)), move(parts.second)};
+    }
+
+    static NodePtr replaced(const NodePtr &node, size_t position, StepPtr step) {
+        size_t leftSize = sizeOf(node->left);
+        if (position < leftSize) {
+            return makeNode(node->step, replaced(node->left, position, move(step)), node->right);
+        }
+        if (position > leftSize) {
+            return makeNode(node->step, node->left, replaced(node->right, position - leftSize - 1, move(step)));
+        }
+        return makeNode(move(step), node->left, node->right);
+    }
+
+    // Arbore perfect echilibrat din pașii [first, last)
+    static NodePtr build(const StepStore &steps, size_t first, size_t last) {
+        if (first == last) {
+            return nullptr;
+        }
+        size_t middle = first + (last - first) / 2;
+        NodePtr left = build(steps, first, middle);
+        NodePtr right = build(steps, middle + 1, last);
+        return makeNode(make_shared<const StepValue>(steps.value(middle)), move(left), move(right));
+    }
+
+    template <typename Function>
+    static void visitNodes(const NodePtr &node, Function &function) {
+        if (node) {
+            visitNodes(node->left, function);
+            function(*node->step);
+            visitNodes(node->right, function);
+        }
+    }
+
+    const StepPtr &stepAt(size_t position) const {
+        const Node *node = root.get();
+        while (true) {
+            size_t leftSize = sizeOf(node->left);
+            if (position == leftSize) {
+                return node->step;
+            }
+            if (position < leftSize) {
+                node = node->left.get();
+            } else {
+                position -= leftSize + 1;
+                node = node->right.get();
+            }
+        }
+    }
+
+    void checkPosition(size_t position, size_t limit) const {
+        if (position >= limit) {
+            throw out_of_range("Pozitia " + to_string(position + 1) + " nu exista in flow.");
+        }
+    }
+
+public:
+    StepList() = default;
+
+    // Copiază pașii flow-ului o singură dată; versiunile următoare îi împart
+    explicit StepList(const StepStore &steps) : root(build(steps, 0, steps.size())) {}
+
+    size_t size() const {
+        return sizeOf(root);
+    }
+
+    bool empty() const {
+        return !root;
+    }
+
+    const StepValue &at(size_t position) const {
+        checkPosition(position, size());
+        return *stepAt(position);
+    }
+
+    StepKind kind(size_t position) const {
+        return static_cast<StepKind>(at(position).index());
+    }
+
+    // Lista cu `step` inserat înaintea poziției date (position == size() adaugă la sfârșit)
+    StepList insert(size_t position, StepValue step) const {
+        checkPosition(position, size() + 1);
+        pair<NodePtr, NodePtr> parts = split(root, position);
+        NodePtr single = makeNode(make_shared<const StepValue>(move(step)), nullptr, nullptr);
+        return StepList(join(join(parts.first, single), parts.second));
+    }
+
+    StepList erase(size_t position) const {
+        checkPosition(position, size());
+        pair<NodePtr, NodePtr> before = split(root, position);
+        pair<NodePtr, NodePtr> after = split(before.second, 1);
+        return StepList(join(before.first, after.second));
+    }
+
+    StepList replace(size_t position, StepValue step) const {
+        checkPosition(position, size());
+        return StepList(replaced(root, position, make_shared<const StepValue>(move(step))));
+    }
+
+    // Mută pasul de pe poziția `from` astfel încât să ajungă pe poziția `to`; pasul nu este copiat
+    StepList moveStep(size_t from, size_t to) const {
+        checkPosition(from, size());
+        checkPosition(to, size());
+        StepPtr step = stepAt(from);
+        pair<NodePtr, NodePtr> before = split(root, from);
+        pair<NodePtr, NodePtr> after = split(before.second, 1);
+        pair<NodePtr, NodePtr> target = split(join(before.first, after.second), to);
+        return StepList(join(join(target.first, after.first), target.second));
+    }
+
+    // Apelează `function` pentru fiecare pas, în ordine
+    template <typename Function>
+    void forEach(Function &&function) const {
+        visitNodes(root, function);
+    }
+
+    // Numărul de noduri distincte din toate listele date (memoria ocupată de versiuni)
+    static size_t distinctNodes(const vector<StepList> &lists) {
+        unordered_set<const Node *> seen;
+        vector<const Node *> pending;
+        for (const StepList &list : lists) {
+            if (list.root) {
+                pending.push_back(list.root.get());
+            }
+        }
+        while (!pending.empty()) {
+            const Node *node = pending.back();
+            pending.pop_back();
+            if (!seen.insert(node).second) {
+                continue;
+            }
+            for (const NodePtr *child : {&node->left, &node->right}) {
+                if (*child) {
+                    pending.push_back(child->get());
+                }
+            }
+        }
+        return seen.size();
+    }
+};
+
+bool ReportTemplate::appendField(string &buffer, const StepStore &steps, size_t position, ReportField field, ostream &out) {
+    auto appendNumber = [&](double value) {
+        char text[32];
+        int length = snprintf(text, sizeof(text), "%g", value);
+        buffer.append(text, static_cast<size_t>(length));
+        return true;
+    };
+    auto appendFile = [&](const string &path) {
+        MappedFile file;
+        if (!file.open(path)) {
+            return false;
+        }
+        buffer.append(file.getData(), file.getSize());
+        return true;
+    };
+
+    if (field == ReportField::Info) {
+        StringSink sink(buffer);
+        TextWriter info(sink);
+        steps.writeToFile(position, info);
+        return true;
+    }
+    switch (steps.kind(position)) {
+        case StepKind::Title: {
+            const TitleStep &step = steps.as<TitleStep>(position);
+            if (field == ReportField::Title || field == ReportField::Subtitle) {
+                buffer += field == ReportField::Title ? step.getTitle() : step.getSubtitle();
+                return true;
+            }
+            return false;
+        }
+        case StepKind::Text: {
+            const TextStep &step = steps.as<TextStep>(position);
+            if (field == ReportField::Title || field == ReportField::Text) {
+                buffer += field == ReportField::Title ? step.getTitle() : step.getCopy();
+                return true;
+            }
+            return false;
+        }
+        case StepKind::TextInput: {
+            const TextInputStep &step = steps.as<TextInputStep>(position);
+            if (field == ReportField::Description || field == ReportField::Input) {
+                if (field == ReportField::Description) {
+                    buffer += step.getDescription();
+                } else {
+                    buffer += steps.getValues().text(position);
+                }
+                return true;
+            }
+            return false;
+        }
+        case StepKind::NumberInput: {
+            const NumberInputStep &step = steps.as<NumberInputStep>(position);
+            if (field == ReportField::Description) {
+                buffer += step.getDescription();
+                return true;
+            }
+            return field == ReportField::Input && appendNumber(steps.getValues().number(position));
+        }
+        case StepKind::Calculus: {
+            const CalculusStep &step = steps.as<CalculusStep>(position);
+            if (field == ReportField::Operation) {
+                buffer += step.getOperation();
+                return true;
+            } else if (field == ReportField::Result) {
+                return appendNumber(steps.number(position, out));
+            } else if (field == ReportField::Values) {
+                bool first = true;
+                step.forEachValue(&steps, position, [&](double value) {
+                    if (!first) {
+                        buffer += ' ';
+                    }
+                    first = false;
+                    appendNumber(value);
+                });
+                return true;
+            }
+            return false;
+        }
+        case StepKind::TextFileInput: {
+            const TextFileInputStep &step = steps.as<TextFileInputStep>(position);
+            if (field == ReportField::Description) {
+                buffer += step.getDescription();
+                return true;
+            } else if (field == ReportField::File) {
+                buffer += step.getFileName() + ".txt";
+                return true;
+            } else if (field == ReportField::Content) {
+                return step.waitForFile() && appendFile(step.getFileName() + ".txt");
+            }
+            const TextStatistics *statistics = step.getStatistics();
+            if (statistics == nullptr) {
+                return false;
+            } else if (field == ReportField::TopWords) {
+                ostringstream words;
+                statistics->writeTopWords(words);
+                buffer += words.str();
+                return true;
+            }
+            static const pair<ReportField, const char *> metrics[] = {
+                {ReportField::Lines, "lines"}, {ReportField::Words, "words"}, {ReportField::Bytes, "bytes"}, {ReportField::Matches, "matches"}};
+            for (const auto &metric : metrics) {
+                double value;
+                if (field == metric.first && statistics->metric(metric.second, value)) {
+                    return appendNumber(value);
+                }
+            }
+            return false;
+        }
+        case StepKind::CSVFileInput: {
+            const CSVFileInputStep &step = steps.as<CSVFileInputStep>(position);
+            if (field == ReportField::Description) {
+                buffer += step.getDescription();
+                return true;
+            } else if (field == ReportField::File) {
+                buffer += step.getFileName() + ".csv";
+                return true;
+            } else if (field == ReportField::Rows) {
+                return step.getTable() != nullptr && appendNumber(static_cast<double>(step.getTable()->rowCount()));
+            }
+            return field == ReportField::Content && step.waitForFile() && appendFile(step.getFileName() + ".csv");
+        }
+        case StepKind::Output: {
+            const OutputStep &step = steps.as<OutputStep>(position);
+            if (field == ReportField::Title) {
+                buffer += step.getTitle();
+                return true;
+            } else if (field == ReportField::File) {
+                buffer += step.getFileName() + ".txt";
+                return true;
+            } else if (field == ReportField::Content) {
+                return step.waitForFile() && appendFile(step.getFileName() + ".txt");
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
+}
+
+void ReportTemplate::render(const StepStore &steps, string &buffer, vector<string> &problems, ostream &out) const {
+    buffer.reserve(buffer.size() + literalBytes);
+    for (const Segment &segment : segments) {
+        if (segment.step == 0) {
+            buffer.append(source, segment.offset, segment.length);
+            continue;
+        }
+        string placeholder = "{{step" + to_string(segment.step) + "." + reportFieldName(segment.field) + "}}";
+        if (segment.step > steps.size()) {
+            problems.push_back(placeholder + ": step-ul nu exista in flow.");
+        } else if (!appendField(buffer, steps, segment.step - 1, segment.field, out)) {
+            problems.push_back(placeholder + ": campul nu este disponibil pentru " + string(stepKindName(steps.kind(segment.step - 1))) + ".");
+        }
+    }
+}
+
+bool OutputStep::createFile(const StepStore &steps, ostream &out) const {
+    EventCounters &counters = flowAnalytics().operation(AnalyticsOperation::FileCreation);
+    ScopedTimer timer(counters);
+    string buffer = fileWriter().acquireBuffer();
+    if (!extra->templateFile.empty()) {
+        shared_ptr<const ReportTemplate> compiled = extra->report;
+        if (!compiled) {
+            try {
+                compiled = ReportTemplate::load(extra->templateFile);
+            } catch (const exception &e) {
+                timer.fail();
+                out << e.what() << endl;
+                return false;
+            }
+        }
+        if (!title.empty()) {
+            buffer += title;
+            buffer += '\n';
+        }
+        vector<string> problems;
+        compiled->render(steps, buffer, problems, out);
+        for (const string &problem : problems) {
+            out << "Raport " << fileName << ".txt: " << problem << endl;
+        }
+    } else if (stepNumber >= 1 && stepNumber <= steps.size()) {
+        buffer += title;
+        buffer += '\n';
+
+        // Obține informațiile pentru step-ul specificat
+        StringSink sink(buffer);
+        TextWriter info(sink);
+        steps.writeToFile(stepNumber - 1, info);
+    } else {
+        timer.fail();
+        out << "Numarul step-ului specificat nu exista in flow!" << endl;
+        return false;
+    }
+
+    // Scrierea se face pe firele AsyncFileWriter; pasul așteaptă doar fișierul său, nu toată coada
+    counters.addBytesWritten(buffer.size());
+    extra.edit().created = fileWriter().submit(fileName + ".txt", move(buffer));
+    if (!waitForFile()) {
+        timer.fail();
+        out << "Fisierul text " << fileName << ".txt nu a putut fi creat." << endl;
+        return false;
+    }
+    out << "Fisier text creat cu succes!" << endl;
+    return true;
+}
+
+void DisplayStep::displayContent(const StepStore &steps, ostream &out) const {
+    if (stepNumber >= 1 && stepNumber <= steps.size()) {
+        size_t position = stepNumber - 1;
+        switch (steps.kind(position)) {
+            case StepKind::TextFileInput:
+                // Fișierul pasului poate fi încă în coada de scriere
+                steps.as<TextFileInputStep>(position).waitForFile();
+                displayFileContent(steps.as<TextFileInputStep>(position).getFileName() + ".txt", out);
+                break;
+            case StepKind::CSVFileInput:
+                steps.as<CSVFileInputStep>(position).waitForFile();
+                displayFileContent(steps.as<CSVFileInputStep>(position).getFileName() + ".csv", out);
+                break;
+            case StepKind::Output:
+                steps.as<OutputStep>(position).waitForFile();
+                displayFileContent(steps.as<OutputStep>(position).getFileName() + ".txt", out);
+                break;
+            default:
+                out << "Pasul specificat nu este de tipul TextFileInputStep sau CSVFileInputStep." << endl;
+                break;
+        }
+    } else {
+        out << "Numarul pasului specificat nu exista in flow!" << endl;
+    }
+}
+
+double StepStore::number(size_t position, ostream &out) const {
+    if (values.kind(position) == ValueKind::Number) {
+        return values.number(position);
+    }
+    return kind(position) == StepKind::Calculus ? as<CalculusStep>(position).performCalculation(out) : 0;
+}
+
+void StepStore::writeInfo(size_t position, ostream &out) const {
+    if (kind(position) == StepKind::Calculus) {
+        as<CalculusStep>(position).writeStepInfo(out, this, position);
+    } else {
+        visit([&out](const auto &step) { step.getStepInfo(out); }, steps[position]);
+    }
+}
+
+void StepStore::writeToFile(size_t position, TextWriter &file) const {
+    if (kind(position) == StepKind::Calculus) {
+        as<CalculusStep>(position).writeStepFile(file, this, position);
+    } else {
+        (*this)[position].writeToFile(file);
+    }
+}
+
+bool CalculusStep::storedResult(const StepStore *steps, size_t position, double &result) const {
+    if (steps == nullptr || steps->getValues().kind(position) != ValueKind::Number) {
+        return false;
+    }
+    result = steps->getValues().number(position);
+    return true;
+}
+
+template <typename Function>
+void CalculusStep::forEachValue(const StepStore *steps, size_t position, Function &&function) const {
+    if (steps == nullptr || inputSteps.empty()) {
+        for (float value : inputs) {
+            function(static_cast<double>(value));
+        }
+    } else if (steps->getValues().kind(position) == ValueKind::Number) {
+        // Pasul a fost calculat, deci toți pașii de intrare există și au valori numerice
+        NullBuffer nullBuffer;
+        ostream discard(&nullBuffer);
+        for (size_t stepNumber : inputSteps) {
+            function(steps->number(stepNumber - 1, discard));
+        }
+    }
+}
+
+bool CalculusStep::calculateFromSteps(StepStore &steps, size_t position, ostream &out) {
+    ScopedTimer timer(flowAnalytics().operation(AnalyticsOperation::CalculusEvaluation));
+    steps.clearResult(position);
+    if (sourceStep != 0) {
+        Extra &data = extra.edit();
+        data.hasColumnValues = false;
+        StepKind sourceKind = sourceStep <= steps.size() ? steps.kind(sourceStep - 1) : StepKind::End;
+        if (sourceKind == StepKind::TextFileInput) {
+            // O valoare a analizei fișierului text, folosită ca singura valoare a calculului
+            const TextStatistics *statistics = steps.getValues().textStatistics(sourceStep - 1);
+            double value;
+            if (statistics == nullptr) {
+                out << "Fisierul text din step-ul " << sourceStep << " nu este analizat." << endl;
+                timer.fail();
+                return false;
+            } else if (!statistics->metric(data.sourceColumn, value)) {
+                out << "Valoarea '" << data.sourceColumn << "' nu exista pentru un fisier text (lines, words, bytes, matches, uniquewords)." << endl;
+                timer.fail();
+                return false;
+            }
+            data.columnValues = ColumnAggregate();
+            data.columnValues.add(value);
+            data.hasColumnValues = true;
+        } else if (sourceKind != StepKind::CSVFileInput) {
+            out << "Step-ul " << sourceStep << " nu este un CSV File Input Step sau Text File Input Step." << endl;
+            timer.fail();
+            return false;
+        } else {
+            const CsvTable *table = steps.getValues().table(sourceStep - 1);
+            if (table == nullptr) {
+                out << "Fisierul CSV din step-ul " << sourceStep << " nu este incarcat." << endl;
+                timer.fail();
+                return false;
+            }
+            long column = table->findColumn(data.sourceColumn);
+            if (column < 0) {
+                out << "Coloana '" << data.sourceColumn << "' nu exista in fisierul CSV." << endl;
+                timer.fail();
+                return false;
+            }
+            data.columnValues = table->aggregateColumn(static_cast<size_t>(column), sharedThreadPool());
+            data.hasColumnValues = true;
+        }
+        if (!data.operation.empty()) {
+            steps.setResult(position, columnCalculation(out));
+        }
+        return true;
+    }
+
+    if (!inputSteps.empty() || operationKind == CalculusOperation::Expression) {
+        // Valorile sunt citite direct din sloturi, ca double, fără a fi copiate în pas. Un
+        // Calculus încă necalculat își calculează acum rezultatul, cu mesajele scrise o singură dată.
+        for (size_t stepNumber : inputSteps) {
+            if (stepNumber < 1 || stepNumber > steps.size()) {
+                out << "Step-ul " << stepNumber << " nu exista in flow." << endl;
+                timer.fail();
+                return false;
+            }
+            StepKind kind = steps.kind(stepNumber - 1);
+            if (kind == StepKind::Calculus && stepNumber - 1 != position) {
+                if (steps.getValues().kind(stepNumber - 1) != ValueKind::Number) {
+                    steps.number(stepNumber - 1, out);
+                }
+            } else if (kind != StepKind::NumberInput) {
+                out << "Step-ul " << stepNumber << " nu este un Number Input Step sau alt Calculus Step." << endl;
+                timer.fail();
+                return false;
+            }
+        }
+        if (!extra->operation.empty()) {
+            NullBuffer nullBuffer;
+            ostream discard(&nullBuffer);
+            auto value = [&](size_t i) { return steps.number(inputSteps[i] - 1, discard); };
+            steps.setResult(position, calculateValues(inputSteps.size(), value, out));
+        }
+        return true;
+    }
+
+    if (!extra->operation.empty() && hasValues()) {
+        steps.setResult(position, performCalculation(out));
+    }
+    return true;
+}
+
+// Graful de dependențe dintre pașii unui flow, construit din referințele dintre pași:
+// Display și Output depind de pasul afișat sau raportat (un Output cu șablon, de toți pașii din
+// șablon; dacă șablonul nu este încă încărcat, de toți pașii anteriori), un Calculus depinde de
+// pasul CSV sau de pașii de intrare din care își ia valorile, iar două Output-uri în același
+// fișier își păstrează ordinea. Muchiile de execuție merg mereu de la pasul cu indice mai mic la
+// cel cu indice mai mare, ca la execuția secvențială: un pas care referă un pas ulterior îl
+// citește înainte ca acesta să fie executat. Separat, `readers` păstrează pentru fiecare pas
+// pașii care îi citesc datele, folosiți la recalcularea incrementală.
+struct StepGraph {
+    vector<uint32_t> dependencyCount;  // Numărul de dependențe ale fiecărui pas
+    vector<uint32_t> dependentStart;   // Dependenții pasului i: dependents[dependentStart[i], dependentStart[i + 1])
+    vector<uint32_t> dependents;
+    vector<uint32_t> readerStart;      // Pașii care citesc pasul i: readers[readerStart[i], readerStart[i + 1])
+    vector<uint32_t> readers;
+    size_t criticalPath = 0;           // Numărul de pași din cel mai lung lanț de dependențe
+
+    explicit StepGraph(const StepStore &steps) {
+        size_t count = steps.size();
+        vector<pair<uint32_t, uint32_t>> edges;  // (pas anterior, pas ulterior)
+        vector<pair<uint32_t, uint32_t>> reads;  // (pas citit, pas care citește)
+        auto reference = [&](size_t from, size_t stepNumber) {
+            if (stepNumber >= 1 && stepNumber <= count && stepNumber - 1 != from) {
+                size_t to = stepNumber - 1;
+                edges.emplace_back(static_cast<uint32_t>(std::min(from, to)), static_cast<uint32_t>(std::max(from, to)));
+                reads.emplace_back(static_cast<uint32_t>(to), static_cast<uint32_t>(from));
+            }
+        };
+
+        vector<pair<string, size_t>> lastOutputs;  // Ultimul Output care scrie în fiecare fișier
+        for (size_t i = 0; i < count; ++i) {
+            switch (steps.kind(i)) {
+                case StepKind::Display:
+                    reference(i, steps.as<DisplayStep>(i).getStepNumber());
+                    break;
+                case StepKind::Calculus:
+                    reference(i, steps.as<CalculusStep>(i).getSourceStep());
+                    for (size_t stepNumber : steps.as<CalculusStep>(i).getInputSteps()) {
+                        reference(i, stepNumber);
+                    }
+                    break;
+                case StepKind::Output: {
+                    const OutputStep &output = steps.as<OutputStep>(i);
+                    if (output.getTemplateFile().empty()) {
+                        reference(i, output.getStepNumber());
+                    } else if (output.getReport()) {
+                        for (size_t stepNumber : output.getReport()->referencedSteps()) {
+                            reference(i, stepNumber);
+                        }
+                    } else {
+                        for (size_t j = 0; j < i; ++j) {
+                            reference(i, j + 1);
+                        }
+                    }
+                    auto previous = find_if(lastOutputs.begin(), lastOutputs.end(),
+                                            [&](const pair<string, size_t> &entry) { return entry.first == output.getFileName(); });
+                    if (previous != lastOutputs.end()) {
+                        // Doar ordine de scriere, nu o citire
+                        edges.emplace_back(static_cast<uint32_t>(previous->second), static_cast<uint32_t>(i));
+                        previous->second = i;
+                    } else {
+                        lastOutputs.emplace_back(output.getFileName(), i);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        sort(edges.begin(), edges.end());
+        edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+        dependencyCount.assign(count, 0);
+        dependentStart.assign(count + 1, 0);
+        dependents.resize(edges.size());
+        for (const pair<uint32_t, uint32_t> &edge : edges) {
+            dependencyCount[edge.second]++;
+            dependentStart[edge.first + 1]++;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            dependentStart[i + 1] += dependentStart[i];
+        }
+        for (size_t e = 0; e < edges.size(); ++e) {
+            dependents[e] = edges[e].second;  // Muchiile sunt deja sortate după pasul anterior
+        }
+
+        sort(reads.begin(), reads.end());
+        reads.erase(unique(reads.begin(), reads.end()), reads.end());
+        readerStart.assign(count + 1, 0);
+        readers.resize(reads.size());
+        for (size_t e = 0; e < reads.size(); ++e) {
+            readerStart[reads[e].first + 1]++;
+            readers[e] = reads[e].second;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            readerStart[i + 1] += readerStart[i];
+        }
+
+        vector<size_t> depth(count, 1);
+        for (size_t i = 0; i < count; ++i) {
+            for (uint32_t e = dependentStart[i]; e < dependentStart[i + 1]; ++e) {
+                depth[dependents[e]] = std::max(depth[dependents[e]], depth[i] + 1);
+            }
+            criticalPath = std::max(criticalPath, depth[i]);
+        }
+    }
+};
+
+// Clasa principală pentru manipularea flow-urilor
+class Flow {
+private:
+    string name;
+    uint64_t id;  // Cheia contoarelor din FlowAnalytics
+    StepStore steps;
+    bool hasEndStep;
+    size_t endStepPosition;
+    shared_ptr<const StepGraph> graph;  // Construit la prima execuție sau editare, invalidat de addStep
+
+    // Actualizează datele flow-ului pentru un pas nou; returnează false dacă pasul este respins.
+    // Valorile pașilor de intrare nu sunt copiate: Calculus le citește din pași la recalculare.
+    bool acceptStep(StepKind kind) {
+        if (kind == StepKind::End) {
+            if (hasEndStep) {
+                cout << "Un flow poate avea doar un End Step. Nu se poate adauga End Step suplimentar." << endl;
+                return false;
+            }
+            hasEndStep = true;
+            endStepPosition = steps.size();
+        }
+        graph.reset();
+        return true;
+    }
+
+    const StepGraph &dependencyGraph() {
+        if (!graph) {
+            graph = make_shared<const StepGraph>(steps);
+        }
+        return *graph;
+    }
+
+    // Recalculează pașii care citesc, direct sau indirect, pasul `position`, în ordinea pașilor;
+    // ceilalți pași își păstrează rezultatele. Costul depinde doar de pașii afectați.
+    size_t recomputeReaders(size_t position, ostream &out) {
+        const StepGraph &readGraph = dependencyGraph();
+        vector<uint32_t> dirty;
+        vector<uint32_t> pending(1, static_cast<uint32_t>(position));
+        unordered_set<uint32_t> visited;
+        while (!pending.empty()) {
+            uint32_t current = pending.back();
+            pending.pop_back();
+            for (uint32_t e = readGraph.readerStart[current]; e < readGraph.readerStart[current + 1]; ++e) {
+                uint32_t reader = readGraph.readers[e];
+                if (visited.insert(reader).second) {
+                    dirty.push_back(reader);
+                    pending.push_back(reader);
+                }
+            }
+        }
+        sort(dirty.begin(), dirty.end());
+        for (uint32_t i : dirty) {
+            executeStep(i, out);
+            if (steps.kind(i) == StepKind::Display) {
+                steps.as<DisplayStep>(i).displayContent(steps, out);
+            }
+        }
+        return dirty.size();
+    }
+
+public: 
+    // Un id 0 înseamnă un flow nou, cu id rezervat acum
+    Flow(const string &n, uint64_t flowId = 0) : name(n), id(flowId != 0 ? flowId : reserveFlowIds(1)) {
+        hasEndStep = false;
+        endStepPosition = 0;
+    }
+
+    // Flow-ul deține pașii după valoare, deci poate fi mutat, dar nu copiat
+    Flow(const Flow &) = delete;
+    Flow &operator=(const Flow &) = delete;
+    Flow(Flow &&other) noexcept = default;
+    Flow &operator=(Flow &&other) noexcept = default;
+
+    string getFlowName() const {
+        return name;
+    }
+
+    uint64_t getId() const {
+        return id;
+    }
+
+    const StepStore &getSteps() const {
+        return steps;
+    }
+
+    void reserveSteps(size_t count) {
+        steps.reserve(count);
+    }
+
+    // Adaugă un pas după valoare și returnează pasul stocat în flow.
+    // Un End Step suplimentar este respins și se returnează cel existent.
+    template <typename T, typename = enable_if_t<is_base_of<Step, T>::value>>
+    T &addStep(T step) {
+        StepKind kind = step.getKind();
+        if (!acceptStep(kind)) {
+            return steps.as<T>(endStepPosition);
+        }
+        return steps.push(move(step));
+    }
+
+    // Adaugă un pas construit de registrul tipurilor de pași (buildStep, readStepBinary)
+    void addStep(StepValue step) {
+        visit([this](auto &value) { addStep(move(value)); }, step);
+    }
+
+    // Valorile curente ale pașilor NumberInput, în ordinea pașilor
+    vector<float> getNumberInputs() const {
+        vector<float> values;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            if (steps.kind(i) == StepKind::NumberInput) {
+                values.push_back(static_cast<float>(steps.getValues().number(i)));
+            }
+        }
+        return values;
+    }
+
+    // Actualizează tabelul de valori după ce pasul a fost modificat prin referința întoarsă de
+    // addStep() (de ex. un fișier încărcat imediat după adăugare)
+    void publishValue(size_t position) {
+        steps.publish(position);
+    }
+
+    // Calculează pasul Calculus de pe poziția dată din pașii pe care îi citește; rezultatul este
+    // scris în slotul pasului. Returnează false dacă valorile nu au putut fi citite.
+    bool calculateStep(size_t position, ostream &out = cout) {
+        return steps.as<CalculusStep>(position).calculateFromSteps(steps, position, out);
+    }
+
+    // Rezultatul unui pas Calculus (vezi StepStore::number)
+    double calculusResult(size_t position, ostream &out = cout) const {
+        return steps.number(position, out);
+    }
+
+    // Schimbă valoarea unui pas NumberInput sau TextInput și recalculează doar pașii Calculus,
+    // Output și Display care depind de el. Returnează numărul de pași recalculați; aruncă
+    // runtime_error dacă pasul nu este de tipul potrivit.
+    size_t setNumberInput(size_t position, float value, ostream &out = cout) {
+        if (position >= steps.size() || steps.kind(position) != StepKind::NumberInput) {
+            throw runtime_error("Step-ul " + to_string(position + 1) + " nu este un Number Input Step.");
+        }
+        steps.as<NumberInputStep>(position).setInput(value);
+        steps.publish(position);
+        return recomputeReaders(position, out);
+    }
+
+    size_t setTextInput(size_t position, const string &value, ostream &out = cout) {
+        if (position >= steps.size() || steps.kind(position) != StepKind::TextInput) {
+            throw runtime_error("Step-ul " + to_string(position + 1) + " nu este un Text Input Step.");
+        }
+        steps.as<TextInputStep>(position).setInput(value);
+        steps.publish(position);
+        return recomputeReaders(position, out);
+    }
+
+    // Recalculează, în ordine, pașii Calculus care citesc alți pași (de ex. după ce pașii au fost
+    // reordonați). Returnează numărul de pași care nu au putut fi calculați.
+    size_t recalculate(ostream &out = cout) {
+        size_t failed = 0;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            if (steps.kind(i) == StepKind::Calculus && steps.as<CalculusStep>(i).readsSteps()) {
+                failed += !steps.as<CalculusStep>(i).calculateFromSteps(steps, i, out);
+            }
+        }
+        return failed;
+    }
+
+    // Munca unui pas la execuție; mesajele sunt scrise în `log`. Display nu are muncă proprie:
+    // conținutul este afișat de execute(), în ordinea pașilor. Durata este înregistrată pe tipul
+    // pasului și, dacă `timing` este dat, pe poziția lui din flow. Returnează false la eroare.
+    bool executeStep(size_t position, ostream &log, StepTiming *timing = nullptr) {
+        StepKind kind = steps.kind(position);
+        EventCounters &counters = flowAnalytics().stepExecution(kind);
+        auto start = chrono::steady_clock::now();
+        bool succeeded = true;
+        try {
+            switch (kind) {
+                case StepKind::CSVFileInput:
+                    if (steps.as<CSVFileInputStep>(position).getTable() == nullptr) {
+                        succeeded = steps.as<CSVFileInputStep>(position).loadTable(log);
+                    } else {
+                        counters.skip();
+                    }
+                    break;
+                case StepKind::TextFileInput:
+                    if (steps.as<TextFileInputStep>(position).getStatistics() == nullptr) {
+                        succeeded = steps.as<TextFileInputStep>(position).analyze(log);
+                    } else {
+                        counters.skip();
+                    }
+                    break;
+                case StepKind::Calculus:
+                    succeeded = steps.as<CalculusStep>(position).calculateFromSteps(steps, position, log);
+                    break;
+                case StepKind::Output:
+                    succeeded = steps.as<OutputStep>(position).createFile(steps, log);
+                    break;
+                default:
+                    break;
+            }
+            // Doar slotul acestui pas este scris, deci pașii independenți pot rula în paralel;
+            // un Calculus și-a scris deja rezultatul
+            if (kind == StepKind::CSVFileInput || kind == StepKind::TextFileInput) {
+                steps.publish(position);
+            }
+        } catch (const exception &e) {
+            log << "Eroare la executia pasului " << (position + 1) << ": " << e.what() << endl;
+            succeeded = false;
+        }
+        uint64_t elapsed = elapsedNanoseconds(start);
+        counters.record(elapsed, !succeeded);
+        if (timing != nullptr) {
+            timing->record(elapsed, !succeeded);
+        }
+        return succeeded;
+    }
+
+    // Scrie informațiile pasului și înregistrează durata pe tipul lui și, dacă `timing` este dat,
+    // pe poziția lui din flow
+    void writeStepInfo(size_t position, ostream &out, StepTiming *timing = nullptr) const {
+        auto start = chrono::steady_clock::now();
+        steps.writeInfo(position, out);
+        uint64_t elapsed = elapsedNanoseconds(start);
+        flowAnalytics().stepInfo(steps.kind(position)).record(elapsed);
+        if (timing != nullptr) {
+            timing->record(elapsed, false);
+        }
+    }
+
+    // Execută pașii flow-ului: încarcă fișierele CSV, calculează pașii Calculus cu sursă CSV,
+    // generează rapoartele Output și afișează conținutul pașilor Display, apoi informațiile
+    // fiecărui pas. Cu un pool, pașii independenți rulează în paralel după StepGraph, fiecare cu
+    // bufferul lui de mesaje, iar rezultatele sunt scrise în `out` în ordinea pașilor. Fără pool,
+    // pașii rulează în ordine pe firul curent. Display rulează mereu pe firul apelant, la rândul lui.
+    void execute(ostream &out, ThreadPool *pool = nullptr) {
+        size_t count = steps.size();
+        shared_ptr<FlowCounters> counters = flowAnalytics().flow(id, name);
+        shared_ptr<StepTiming[]> timings = counters->stepTimings(count);
+        ScopedTimer runTimer(counters->runs);
+        auto writeStep = [&](size_t i, const string &log) {
+            out << "Step " << (i + 1) << " of Flow '" << name << "':" << endl;
+            out << log;
+            if (steps.kind(i) == StepKind::Display) {
+                steps.as<DisplayStep>(i).displayContent(steps, out);
+            }
+            writeStepInfo(i, out);
+            out << endl;
+        };
+
+        if (pool == nullptr) {
+            ostringstream log;
+            for (size_t i = 0; i < count; ++i) {
+                log.str(string());
+                if (!executeStep(i, log, &timings[i])) {
+                    runTimer.fail();
+                }
+                writeStep(i, log.str());
+            }
+            return;
+        }
+
+        const StepGraph &graph = dependencyGraph();
+        vector<ostringstream> logs(count);
+        atomic<bool> failed(false);
+        unique_ptr<atomic<uint32_t>[]> remaining(new atomic<uint32_t>[count]);
+        vector<char> done(count, 0);
+        mutex doneMutex;
+        condition_variable stepDone;
+        for (size_t i = 0; i < count; ++i) {
+            remaining[i] = graph.dependencyCount[i];
+        }
+
+        function<void(size_t)> runStep = [&](size_t i) {
+            if (!executeStep(i, logs[i], &timings[i])) {
+                failed.store(true, memory_order_relaxed);
+            }
+            for (uint32_t e = graph.dependentStart[i]; e < graph.dependentStart[i + 1]; ++e) {
+                size_t dependent = graph.dependents[e];
+                if (--remaining[dependent] == 0) {
+                    pool->submit([&runStep, dependent] { runStep(dependent); });
+                }
+            }
+            lock_guard<mutex> lock(doneMutex);
+            done[i] = 1;
+            stepDone.notify_all();
+        };
+        for (size_t i = 0; i < count; ++i) {
+            if (graph.dependencyCount[i] == 0) {
+                pool->submit([&runStep, i] { runStep(i); });
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            while (true) {
+                {
+                    lock_guard<mutex> lock(doneMutex);
+                    if (done[i]) {
+                        break;
+                    }
+                }
+                if (!pool->runPendingTask()) {
+                    unique_lock<mutex> lock(doneMutex);
+                    stepDone.wait_for(lock, chrono::milliseconds(1), [&] { return done[i] != 0; });
+                }
+            }
+            writeStep(i, logs[i].str());
+        }
+        if (failed.load(memory_order_relaxed)) {
+            runTimer.fail();
+        }
+    }
+
+    void displayFlowInfo() const {
+        cout << "Nume Flow: " << name << " | ";
+        for (size_t i = 0; i < steps.size(); ++i) {
+            cout << stepKindName(steps.kind(i)) << " | ";
+        }
+        cout << endl;
+    }
+
+    // Afișează informațiile pașilor. Durata fiecărui pas se măsoară între două citiri consecutive
+    // ale ceasului, deci fiecare pas costă o singură citire.
+    void runFlow(ostream &out = cout) const {
+        shared_ptr<FlowCounters> counters = flowAnalytics().flow(id, name);
+        shared_ptr<StepTiming[]> timings = counters->stepTimings(steps.size());
+        auto runStart = chrono::steady_clock::now();
+        auto stepStart = runStart;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            out << "Step " << (i + 1) << " of Flow '" << name << "':" << endl;
+            steps.writeInfo(i, out);
+            out << endl;
+            auto stepEnd = chrono::steady_clock::now();
+            uint64_t elapsed = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(stepEnd - stepStart).count());
+            flowAnalytics().stepInfo(steps.kind(i)).record(elapsed);
+            timings[i].record(elapsed, false);
+            stepStart = stepEnd;
+        }
+        counters->runs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(stepStart - runStart).count()));
+    }
+};
+
+// Editarea pașilor unui flow pe versiuni. Fiecare modificare (inserare, ștergere, mutare,
+// înlocuire) adaugă o versiune nouă a listei de pași, care împarte cu versiunea anterioară tot
+// ce nu s-a schimbat; revenirea la o versiune anterioară adaugă și ea o versiune, în O(1).
+// Flow-ul este reconstruit din versiunea curentă o singură dată, la salvare.
+class FlowEditor {
+private:
+    string name;
+    uint64_t id;
+    vector<StepList> versions;
+    vector<string> descriptions;
+
+    void addVersion(StepList steps, const string &description) {
+        versions.push_back(move(steps));
+        descriptions.push_back(description);
+    }
+
+public:
+    explicit FlowEditor(const Flow &flow) : name(flow.getFlowName()), id(flow.getId()) {
+        addVersion(StepList(flow.getSteps()), "versiunea initiala");
+    }
+
+    const StepList &steps() const {
+        return versions.back();
+    }
+
+    const vector<StepList> &getVersions() const {
+        return versions;
+    }
+
+    // Versiunile sunt numerotate de la 0 (flow-ul inițial)
+    size_t currentVersion() const {
+        return versions.size() - 1;
+    }
+
+    const string &getDescription(size_t version) const {
+        return descriptions.at(version);
+    }
+
+    // Pozițiile sunt indici de la 0; aruncă out_of_range pentru o poziție inexistentă
+    void insert(size_t position, StepValue step) {
+        string description = "inserare " + string(stepKindName(static_cast<StepKind>(step.index()))) + " pe pozitia " + to_string(position + 1);
+        addVersion(steps().insert(position, move(step)), description);
+    }
+
+    void erase(size_t position) {
+        addVersion(steps().erase(position), "stergere pas " + to_string(position + 1));
+    }
+
+    void replace(size_t position, StepValue step) {
+        addVersion(steps().replace(position, move(step)), "modificare pas " + to_string(position + 1));
+    }
+
+    void moveStep(size_t from, size_t to) {
+        addVersion(steps().moveStep(from, to), "mutare pas " + to_string(from + 1) + " pe pozitia " + to_string(to + 1));
+    }
+
+    void rollback(size_t version) {
+        addVersion(StepList(versions.at(version)), "revenire la versiunea " + to_string(version));
+    }
+
+    // Flow-ul cu pașii versiunii curente; pașii Calculus care citesc alți pași sunt recalculați
+    Flow build(ostream &out = cout) const {
+        Flow flow(name, id);
+        flow.reserveSteps(steps().size());
+        steps().forEach([&flow](const StepValue &value) {
+            visit([&flow](const auto &step) { flow.addStep(step); }, value);
+        });
+        flow.recalculate(out);
+        return flow;
+    }
+};
+
+// Identificator stabil pentru un flow din FlowRegistry: slotul și generația acestuia.
+// Un handle rămâne valid până la ștergerea flow-ului, chiar dacă alte flow-uri sunt șterse.
+struct FlowHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const FlowHandle &other) const {
+        return slot == other.slot && generation == other.generation;
+    }
+
+    bool operator!=(const FlowHandle &other) const {
+        return !(*this == other);
+    }
+};
+
+// Registrul flow-urilor din sesiune (slot map): creare, căutare și ștergere în O(1).
+// Flow-urile sunt ținute contiguu; la ștergere ultimul flow este mutat în locul celui șters,
+// deci ordinea de iterare se poate schimba, dar handle-urile rămân valide.
+class FlowRegistry {
+private:
+    static constexpr uint32_t noSlot = UINT32_MAX;
+
+    struct Slot {
+        uint32_t generation = 0;
+        uint32_t position = noSlot;  // Poziția în `flows`, sau noSlot dacă slotul este liber
+        uint32_t nextFree = noSlot;
+    };
+
+    vector<Slot> slots;
+    vector<Flow> flows;
+    vector<uint32_t> slotOfPosition;
+    uint32_t firstFree = noSlot;
+
+public:
+    FlowHandle insert(Flow flow) {
+        uint32_t slot;
+        if (firstFree != noSlot) {
+            slot = firstFree;
+            firstFree = slots[slot].nextFree;
+        } else {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        slots[slot].position = static_cast<uint32_t>(flows.size());
+        flows.push_back(move(flow));
+        slotOfPosition.push_back(slot);
+        return FlowHandle{slot, slots[slot].generation};
+    }
+
+    bool contains(FlowHandle handle) const {
+        return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation &&
+               slots[handle.slot].position != noSlot;
+    }
+
+    // Returnează nullptr dacă flow-ul a fost șters
+    Flow *find(FlowHandle handle) {
+        return contains(handle) ? &flows[slots[handle.slot].position] : nullptr;
+    }
+
+    const Flow *find(FlowHandle handle) const {
+        return contains(handle) ? &flows[slots[handle.slot].position] : nullptr;
+    }
+
+    bool erase(FlowHandle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+
+        Slot &slot = slots[handle.slot];
+        uint32_t position = slot.position;
+        uint32_t last = static_cast<uint32_t>(flows.size() - 1);
+        if (position != last) {
+            flows[position] = move(flows[last]);
+            slotOfPosition[position] = slotOfPosition[last];
+            slots[slotOfPosition[position]].position = position;
+        }
+        flows.pop_back();
+        slotOfPosition.pop_back();
+
+        // Generația nouă invalidează toate handle-urile vechi către acest slot
+        slot.generation++;
+        slot.position = noSlot;
+        slot.nextFree = firstFree;
+        firstFree = handle.slot;
+        return true;
+    }
+
+    void reserve(size_t count) {
+        slots.reserve(count);
+        flows.reserve(count);
+        slotOfPosition.reserve(count);
+    }
+
+    size_t size() const {
+        return flows.size();
+    }
+
+    bool empty() const {
+        return flows.empty();
+    }
+
+    // Acces după poziția curentă (ordinea din listare)
+    Flow &at(size_t position) {
+        return flows[position];
+    }
+
+    const Flow &at(size_t position) const {
+        return flows[position];
+    }
+
+    // Poziția curentă a unui flow existent
+    size_t positionOf(FlowHandle handle) const {
+        return slots[handle.slot].position;
+    }
+
+    FlowHandle handleAt(size_t position) const {
+        uint32_t slot = slotOfPosition[position];
+        return FlowHandle{slot, slots[slot].generation};
+    }
+
+    vector<Flow>::iterator begin() {
+        return flows.begin();
+    }
+
+    vector<Flow>::iterator end() {
+        return flows.end();
+    }
+
+    vector<Flow>::const_iterator begin() const {
+        return flows.begin();
+    }
+
+    vector<Flow>::const_iterator end() const {
+        return flows.end();
+    }
+};
+
+// Reclamarea memoriei pe epoci, pentru structurile citite fără blocare: un fir care citește
+// intră într-o secțiune critică (EpochGuard) și anunță epoca globală pe care a văzut-o. Un obiect
+// scos din structură este „retras” cu epoca din acel moment și este eliberat abia după ce epoca
+// globală a avansat de două ori, adică după ce toate firele care l-ar fi putut vedea au ieșit din
+// secțiunea critică. Epoca avansează doar când toate firele active au văzut-o pe cea curentă.
+class EpochReclaimer {
+public:
+    static constexpr size_t maxThreads = 1024;
+
+private:
+    struct Retired {
+        void *object;
+        void (*destroy)(void *);
+        uint64_t epoch;
+    };
+
+    struct alignas(64) Record {
+        atomic<uint64_t> epoch{0};  // Epoca văzută la intrarea în secțiunea critică; 0 în afara ei
+        atomic<bool> inUse{false};
+        unsigned depth = 0;         // Secțiuni critice imbricate ale firului
+        vector<Retired> retired;    // Folosit doar de firul care deține înregistrarea
+        size_t collectAt = 0;       // Dimensiunea lui `retired` la care se încearcă eliberarea
+    };
+
+    // Înregistrarea firului curent; la oprirea firului obiectele încă neeliberate trec în `orphans`
+    struct ThreadRecord {
+        EpochReclaimer *owner = nullptr;
+        Record *record = nullptr;
+
+        ~ThreadRecord() {
+            if (record != nullptr) {
+                owner->release(*record);
+            }
+        }
+    };
+
+    static constexpr size_t collectThreshold = 64;  // Obiecte retrase între două încercări de eliberare
+
+    atomic<uint64_t> globalEpoch{1};
+    Record records[maxThreads];
+    atomic<size_t> recordCount{0};  // Înregistrările [0, recordCount) au fost folosite cel puțin o dată
+    mutex orphansMutex;
+    vector<Retired> orphans;
+
+    Record &localRecord() {
+        thread_local ThreadRecord local;
+        if (local.record == nullptr) {
+            local.owner = this;
+            local.record = &acquire();
+        }
+        return *local.record;
+    }
+
+    // O înregistrare liberă (a unui fir oprit) sau una nouă; fără blocare
+    Record &acquire() {
+        size_t count = recordCount.load(memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            bool expected = false;
+            if (!records[i].inUse.load(memory_order_relaxed) && records[i].inUse.compare_exchange_strong(expected, true)) {
+                return records[i];
+            }
+        }
+        while (true) {
+            size_t index = recordCount.load(memory_order_acquire);
+            if (index >= maxThreads) {
+                throw runtime_error("Prea multe fire folosesc simultan registrul concurent.");
+            }
+            bool expected = false;
+            if (records[index].inUse.compare_exchange_strong(expected, true)) {
+                size_t next = index;
+                recordCount.compare_exchange_strong(next, index + 1);
+                return records[index];
+            }
+            size_t next = index;
+            recordCount.compare_exchange_strong(next, index + 1);
+        }
+    }
+
+    void release(Record &record) {
+        if (!record.retired.empty()) {
+            lock_guard<mutex> lock(orphansMutex);
+            orphans.insert(orphans.end(), record.retired.begin(), record.retired.end());
+            record.retired.clear();
+        }
+        record.depth = 0;
+        record.collectAt = 0;
+        record.epoch.store(0, memory_order_release);
+        record.inUse.store(false, memory_order_release);
+    }
+
+    // Avansează epoca dacă toate firele active au văzut-o pe cea curentă
+    void tryAdvance() {
+        uint64_t current = globalEpoch.load();
+        size_t count = recordCount.load(memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t seen = records[i].epoch.load();
+            if (seen != 0 && seen != current) {
+                return;
+            }
+        }
+        globalEpoch.compare_exchange_strong(current, current + 1);
+    }
+
+    static size_t freeExpired(vector<Retired> &retired, uint64_t epoch) {
+        size_t kept = 0;
+        for (const Retired &item : retired) {
+            if (item.epoch + 2 <= epoch) {
+                item.destroy(item.object);
+            } else {
+                retired[kept++] = item;
+            }
+        }
+        size_t freed = retired.size() - kept;
+        retired.resize(kept);
+        return freed;
+    }
+
+    void collect(Record &record) {
+        tryAdvance();
+        uint64_t epoch = globalEpoch.load();
+        freeExpired(record.retired, epoch);
+        // Dacă un fir întârzie epoca, lista crește; pragul dublat păstrează costul amortizat constant
+        record.collectAt = std::max(collectThreshold, record.retired.size() * 2);
+        unique_lock<mutex> lock(orphansMutex, try_to_lock);
+        if (lock.owns_lock() && !orphans.empty()) {
+            freeExpired(orphans, epoch);
+        }
+    }
+
+public:
+    void enter() {
+        Record &record = localRecord();
+        if (record.depth++ == 0) {
+            // Schimbul seq_cst face epoca anunțată vizibilă înaintea oricărei citiri din structură
+            record.epoch.exchange(globalEpoch.load());
+        }
+    }
+
+    void exit() {
+        Record &record = localRecord();
+        if (--record.depth == 0) {
+            record.epoch.store(0, memory_order_release);
+        }
+    }
+
+    // Eliberează obiectul (cu `delete`) când niciun fir nu îl mai poate citi. Obiectul trebuie să
+    // fi fost deja scos din structură.
+    template <typename T>
+    void retire(T *object) {
+        Record &record = localRecord();
+        record.retired.push_back({object, [](void *pointer) { delete static_cast<T *>(pointer); }, globalEpoch.load()});
+        if (record.retired.size() >= std::max(record.collectAt, collectThreshold)) {
+            collect(record);
+        }
+    }
+};
+
+// Instanța nu este distrusă: firele care se opresc la ieșirea din program își predau încă obiectele
+EpochReclaimer &epochReclaimer() {
+    static EpochReclaimer *reclaimer = new EpochReclaimer();
+    return *reclaimer;
+}
+
+// Secțiune critică pentru citirile fără blocare dintr-o structură protejată de EpochReclaimer
+class EpochGuard {
+public:
+    EpochGuard() {
+        epochReclaimer().enter();
+    }
+
+    ~EpochGuard() {
+        epochReclaimer().exit();
+    }
+
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+// Registru concurent de valori (flow-uri) după id, pentru mai multe fire care creează, caută și
+// șterg în paralel. Id-urile sunt crescătoare și nu sunt refolosite. Registrul are 64 de shard-uri,
+// fiecare o tabelă hash cu liste înlănțuite: căutarea și iterarea nu blochează (citesc în
+// interiorul unui EpochGuard), iar inserarea și ștergerea blochează doar shard-ul lor. Un nod
+// șters rămâne legat de succesorul lui, deci cititorii care stau pe el își continuă parcurgerea,
+// și este eliberat prin EpochReclaimer. Valorile sunt ținute prin shared_ptr: un flow găsit
+// rămâne valid cât timp este folosit, chiar dacă între timp este șters din registru.
+template <typename T>
+class ConcurrentRegistry {
+private:
+    static constexpr size_t shardCount = 64;
+
+    struct Node {
+        uint64_t id;
+        shared_ptr<T> value;
+        atomic<Node *> next;
+
+        Node(uint64_t id, shared_ptr<T> value, Node *next) : id(id), value(move(value)), next(next) {}
+    };
+
+    // Tabela unui shard; la creștere este înlocuită cu o copie, iar cea veche este retrasă cu nodurile ei
+    struct Buckets {
+        size_t mask;
+        unique_ptr<atomic<Node *>[]> heads;
+
+        explicit Buckets(size_t count) : mask(count - 1), heads(new atomic<Node *>[count]) {
+            for (size_t i = 0; i < count; ++i) {
+                heads[i].store(nullptr, memory_order_relaxed);
+            }
+        }
+
+        ~Buckets() {
+            for (size_t i = 0; i <= mask; ++i) {
+                Node *node = heads[i].load(memory_order_relaxed);
+                while (node != nullptr) {
+                    Node *next = node->next.load(memory_order_relaxed);
+                    delete node;
+                    node = next;
+                }
+            }
+        }
+
+        atomic<Node *> &head(uint64_t id) {
+            return heads[mix(id) >> 6 & mask];
+        }
+    };
+
+    struct alignas(64) Shard {
+        mutex writeMutex;
+        atomic<Buckets *> buckets;
+        size_t count = 0;  // Sub writeMutex
+    };
+
+    Shard shards[shardCount];
+    atomic<uint64_t> nextId{1};
+    atomic<size_t> count{0};
+
+    // Amestecă biții id-ului: id-urile consecutive ajung în shard-uri și liste diferite
+    static uint64_t mix(uint64_t id) {
+        id ^= id >> 33;
+        id *= 0xff51afd7ed558ccdull;
+        id ^= id >> 33;
+        return id;
+    }
+
+    Shard &shardOf(uint64_t id) {
+        return shards[mix(id) & (shardCount - 1)];
+    }
+
+    // Dublează tabela shard-ului (sub writeMutex). Nodurile sunt copiate, fiindcă cititorii pot
+    // parcurge încă listele vechi; tabela veche este eliberată după ce aceștia termină.
+    void grow(Shard &shard) {
+        Buckets *old = shard.buckets.load(memory_order_relaxed);
+        Buckets *bigger = new Buckets((old->mask + 1) * 2);
+        for (size_t i = 0; i <= old->mask; ++i) {
+            for (Node *node = old->heads[i].load(memory_order_relaxed); node != nullptr; node = node->next.load(memory_order_relaxed)) {
+                atomic<Node *> &head = bigger->head(node->id);
+                head.store(new Node(node->id, node->value, head.load(memory_order_relaxed)), memory_order_relaxed);
+            }
+        }
+        shard.buckets.store(bigger, memory_order_release);
+        epochReclaimer().retire(old);
+    }
+
+public:
+    ConcurrentRegistry() {
+        for (Shard &shard : shards) {
+            shard.buckets.store(new Buckets(16), memory_order_relaxed);
+        }
+    }
+
+    // Fără alte fire care folosesc registrul; nodurile deja șterse sunt eliberate de EpochReclaimer
+    ~ConcurrentRegistry() {
+        for (Shard &shard : shards) {
+            delete shard.buckets.load(memory_order_relaxed);
+        }
+    }
+
+    ConcurrentRegistry(const ConcurrentRegistry &) = delete;
+    ConcurrentRegistry &operator=(const ConcurrentRegistry &) = delete;
+
+    // Adaugă valoarea și returnează id-ul ei
+    uint64_t insert(shared_ptr<T> value) {
+        uint64_t id = nextId.fetch_add(1, memory_order_relaxed);
+        Shard &shard = shardOf(id);
+        lock_guard<mutex> lock(shard.writeMutex);
+        Buckets *buckets = shard.buckets.load(memory_order_relaxed);
+        if (shard.count + 1 > buckets->mask + 1) {
+            grow(shard);
+            buckets = shard.buckets.load(memory_order_relaxed);
+        }
+        atomic<Node *> &head = buckets->head(id);
+        // Nodul este complet construit înainte de a fi publicat (release)
+        head.store(new Node(id, move(value), head.load(memory_order_relaxed)), memory_order_release);
+        shard.count++;
+        count.fetch_add(1, memory_order_relaxed);
+        return id;
+    }
+
+    // Valoarea cu id-ul dat sau nullptr; nu blochează
+    shared_ptr<T> find(uint64_t id) {
+        EpochGuard guard;
+        Buckets *buckets = shardOf(id).buckets.load(memory_order_acquire);
+        for (Node *node = buckets->head(id).load(memory_order_acquire); node != nullptr; node = node->next.load(memory_order_acquire)) {
+            if (node->id == id) {
+                return node->value;
+            }
+        }
+        return nullptr;
+    }
+
+    // Scoate valoarea din registru; cei care au găsit-o înainte o pot folosi în continuare
+    bool erase(uint64_t id) {
+        Shard &shard = shardOf(id);
+        lock_guard<mutex> lock(shard.writeMutex);
+        atomic<Node *> *link = &shard.buckets.load(memory_order_relaxed)->head(id);
+        for (Node *node = link->load(memory_order_relaxed); node != nullptr; node = link->load(memory_order_relaxed)) {
+            if (node->id == id) {
+                link->store(node->next.load(memory_order_relaxed), memory_order_release);
+                shard.count--;
+                count.fetch_sub(1, memory_order_relaxed);
+                epochReclaimer().retire(node);
+                return true;
+            }
+            link = &node->next;
+        }
+        return false;
+    }
+
+    // Apelează function(id, valoare) pentru fiecare valoare, fără blocare. Iterarea vede valorile
+    // prezente pe tot parcursul ei; cele adăugate sau șterse între timp pot apărea sau nu.
+    template <typename Function>
+    void forEach(Function &&function) {
+        for (Shard &shard : shards) {
+            EpochGuard guard;
+            Buckets *buckets = shard.buckets.load(memory_order_acquire);
+            for (size_t i = 0; i <= buckets->mask; ++i) {
+                for (Node *node = buckets->heads[i].load(memory_order_acquire); node != nullptr; node = node->next.load(memory_order_acquire)) {
+                    function(node->id, *node->value);
+                }
+            }
+        }
+    }
+
+    size_t size() const {
+        return count.load(memory_order_relaxed);
+    }
+};
+
+// Rulează flow-urile în paralel pe pool. Fiecare flow scrie într-un buffer propriu, iar bufferele
+// sunt scrise în `out` în ordinea flow-urilor, pe măsură ce sunt gata, deci output-ul nu se
+// amestecă. Firul apelant rulează și el flow-uri cât așteaptă.
+void runFlowsParallel(const vector<const Flow *> &flows, ThreadPool &pool, ostream &out) {
+    struct FlowOutput {
+        string text;
+        bool done = false;
+    };
+    vector<FlowOutput> outputs(flows.size());
+    mutex outputsMutex;
+    condition_variable outputReady;
+
+    for (size_t i = 0; i < flows.size(); ++i) {
+        pool.submit([&, i] {
+            ostringstream text;
+            try {
+                flows[i]->runFlow(text);
+            } catch (const exception &e) {
+                text << "Eroare la rularea flow-ului '" << flows[i]->getFlowName() << "': " << e.what() << endl;
+            }
+            lock_guard<mutex> lock(outputsMutex);
+            outputs[i].text = text.str();
+            outputs[i].done = true;
+            outputReady.notify_all();
+        });
+    }
+
+    for (FlowOutput &output : outputs) {
+        while (true) {
+            {
+                lock_guard<mutex> lock(outputsMutex);
+                if (output.done) {
+                    break;
+                }
+            }
+            if (!pool.runPendingTask()) {
+                unique_lock<mutex> lock(outputsMutex);
+                outputReady.wait_for(lock, chrono::milliseconds(1), [&] { return output.done; });
+            }
+        }
+        string text;
+        {
+            lock_guard<mutex> lock(outputsMutex);
+            text.swap(output.text);
+        }
+        out.write(text.data(), static_cast<streamsize>(text.size()));
+    }
+}
+
+string trim(const string &text) {
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+string_view trimView(string_view text) {
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == string_view::npos) {
+        return string_view();
+    }
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+// Împarte restul unei linii din fișierul de definiție în câmpuri separate prin '|'. Câmpurile
+// sunt porțiuni din `text`; vectorul este refolosit, deci o linie nouă nu alocă.
+void splitFields(string_view text, vector<string_view> &fields) {
+    fields.clear();
+    if (text.empty()) {
+        return;
+    }
+    while (true) {
+        size_t separator = text.find('|');
+        fields.push_back(trimView(text.substr(0, separator)));
+        if (separator == string_view::npos) {
+            break;
+        }
+        text.remove_prefix(separator + 1);
+    }
+}
+
+vector<string_view> splitFields(string_view text) {
+    vector<string_view> fields;
+    splitFields(text, fields);
+    return fields;
+}
+
+// Câmpurile unei linii din fișierul de definiție pentru un pas (fără numele tipului).
+// Un câmp obligatoriu lipsă aruncă runtime_error.
+class StepFields {
+private:
+    const vector<string_view> &fields;
+    string_view keyword;
+
+public:
+    StepFields(const vector<string_view> &fields, string_view keyword) : fields(fields), keyword(keyword) {}
+
+    string_view operator[](size_t index) const {
+        if (index >= fields.size()) {
+            throw runtime_error("Camp lipsa pentru pasul " + string(keyword));
+        }
+        return fields[index];
+    }
+
+    bool has(size_t index) const {
+        return index < fields.size();
+    }
+
+    size_t size() const {
+        return fields.size();
+    }
+};
+
+// Construirea unui tip de pas: parse() din câmpurile unei linii batch (formatul de deasupra lui
+// runBatch(), fără efecte secundare) și decode() din formatul binar scris de Step::writeBinary,
+// în versiunea `version` a formatului. Un tip nou de pas are o specializare aici, o intrare în
+// stepTypeTable și o alternativă în StepValue; stepFactories și buildStep() îl preiau singure.
+template <typename T>
+struct StepCodec;
+
+template <>
+struct StepCodec<TitleStep> {
+    static TitleStep parse(const StepFields &fields) {
+        return TitleStep(string(fields[0]), string(fields[1]));
+    }
+
+    static TitleStep decode(BinaryReader &in, uint32_t) {
+        string title = in.readString();
+        string subtitle = in.readString();
+        return TitleStep(title, subtitle);
+    }
+};
+
+template <>
+struct StepCodec<TextStep> {
+    static TextStep parse(const StepFields &fields) {
+        return TextStep(string(fields[0]), string(fields[1]));
+    }
+
+    static TextStep decode(BinaryReader &in, uint32_t) {
+        string title = in.readString();
+        string copy = in.readString();
+        return TextStep(title, copy);
+    }
+};
+
+template <>
+struct StepCodec<TextInputStep> {
+    static TextInputStep parse(const StepFields &fields) {
+        TextInputStep step{string(fields[0])};
+        if (fields.has(1)) {
+            step.setInput(string(fields[1]));
+        }
+        return step;
+    }
+
+    static TextInputStep decode(BinaryReader &in, uint32_t) {
+        TextInputStep step(in.readString());
+        bool hasInput = in.read<uint8_t>() != 0;
+        string input = in.readString();
+        if (hasInput) {
+            step.setInput(input);
+        }
+        return step;
+    }
+};
+
+template <>
+struct StepCodec<NumberInputStep> {
+    static NumberInputStep parse(const StepFields &fields) {
+        NumberInputStep step{string(fields[0])};
+        if (fields.has(1)) {
+            step.setInput(requireNumber<float>(fields[1]));
+        }
+        return step;
+    }
+
+    static NumberInputStep decode(BinaryReader &in, uint32_t) {
+        string description = in.readString();
+        bool hasInput = in.read<uint8_t>() != 0;
+        float input = in.read<float>();
+        NumberInputStep step(description);
+        if (hasInput) {
+            step.setInput(input);
+        }
+        return step;
+    }
+};
+
+template <>
+struct StepCodec<CalculusStep> {
+    static CalculusStep parse(const StepFields &fields) {
+        CalculusStep step(0);
+        step.setOperation(string(fields[0]));
+        if (step.getOperationKind() == CalculusOperation::Unknown) {
+            throw runtime_error(step.getOperationError().empty() ? "Operatie necunoscuta: " + string(fields[0]) : step.getOperationError());
+        }
+        bool isExpression = step.getOperationKind() == CalculusOperation::Expression;
+        string_view values = fields.has(1) ? fields[1] : string_view();
+        string_view rest = values;
+        string_view token = nextToken(rest);
+        if (isExpression) {
+            // Pașii de intrare sunt referințele din expresie, stabilite de setOperation()
+            if (!token.empty()) {
+                throw runtime_error("O expresie isi ia valorile din pasii referiti (stepN), nu din valori separate.");
+            }
+        } else if (token == "csv" || token == "text") {
+            size_t sourceStep = 0;
+            bool hasStep = parseNumber(nextToken(rest), sourceStep);
+            string_view column = trimView(rest);
+            if (!hasStep || column.empty()) {
+                throw runtime_error(token == "csv" ? "Sursa CSV trebuie sa fie: csv <numar step> <coloana>"
+                                                   : "Sursa text trebuie sa fie: text <numar step> lines|words|bytes|matches|uniquewords");
+            }
+            step.setColumnSource(sourceStep, string(column));
+        } else if (token == "steps") {
+            vector<size_t> inputSteps;
+            for (token = nextToken(rest); !token.empty(); token = nextToken(rest)) {
+                size_t stepNumber;
+                if (!parseNumber(token, stepNumber)) {
+                    inputSteps.clear();
+                    break;
+                }
+                inputSteps.push_back(stepNumber);
+            }
+            if (inputSteps.empty()) {
+                throw runtime_error("Pasii de intrare trebuie sa fie: steps <numar step> <numar step> ...");
+            }
+            step.setInputSteps(inputSteps);
+        } else {
+            vector<float> inputs;
+            for (rest = values, token = nextToken(rest); !token.empty(); token = nextToken(rest)) {
+                inputs.push_back(requireNumber<float>(token));
+            }
+            step.setInputs(inputs);
+        }
+        if (fields.has(2)) {
+            step.setAccumulationMode(parseAccumulationMode(fields[2]));
+        }
+        return step;
+    }
+
+    static CalculusStep decode(BinaryReader &in, uint32_t version) {
+        int32_t steps = in.read<int32_t>();
+        string operation = in.readString();
+        vector<float> values(in.read<uint32_t>());
+        for (float &value : values) {
+            value = in.read<float>();
+        }
+        CalculusStep step(steps);
+        step.setOperation(operation);
+        if (version >= 2) {
+            uint8_t mode = in.read<uint8_t>();
+            if (mode > static_cast<uint8_t>(AccumulationMode::Kahan)) {
+                throw runtime_error("Mod de acumulare invalid.");
+            }
+            step.setAccumulationMode(static_cast<AccumulationMode>(mode));
+        }
+        if (version >= 3) {
+            uint64_t sourceStep = in.read<uint64_t>();
+            string sourceColumn = in.readString();
+            if (sourceStep != 0) {
+                step.setColumnSource(static_cast<size_t>(sourceStep), sourceColumn);
+            }
+        }
+        if (version >= 6) {
+            vector<size_t> inputSteps(in.read<uint32_t>());
+            for (size_t &stepNumber : inputSteps) {
+                stepNumber = static_cast<size_t>(in.read<uint64_t>());
+            }
+            step.setInputSteps(inputSteps);
+        }
+        // Catalogele scrise înainte ca valorile citite din pași să rămână în sloturi le conțin
+        // și pe acestea; ele sunt recitite din pași la calcul, deci sunt ignorate
+        if (!values.empty() && !step.readsSteps()) {
+            step.setInputs(values);
+        }
+        return step;
+    }
+};
+
+template <>
+struct StepCodec<TextFileInputStep> {
+    static TextFileInputStep parse(const StepFields &fields) {
+        TextFileInputStep step{string(fields[0])};
+        if (fields.has(1)) {
+            step.setDescription(string(fields[1]));
+        }
+        if (fields.has(2)) {
+            // Modelul este restul liniei, deci poate conține '|' (alternativă în expresia regulată)
+            string pattern(fields[2]);
+            for (size_t i = 3; i < fields.size(); ++i) {
+                pattern += '|';
+                pattern += fields[i];
+            }
+            try {
+                regex validated(pattern);
+            } catch (const regex_error &) {
+                throw runtime_error("Expresia regulata '" + pattern + "' este invalida.");
+            }
+            step.setPattern(pattern);
+        }
+        return step;
+    }
+
+    static TextFileInputStep decode(BinaryReader &in, uint32_t version) {
+        TextFileInputStep step(in.readString());
+        step.setDescription(in.readString());
+        if (version >= 7) {
+            step.setPattern(in.readString());
+        }
+        return step;
+    }
+};
+
+template <>
+struct StepCodec<CSVFileInputStep> {
+    static CSVFileInputStep parse(const StepFields &fields) {
+        CSVFileInputStep step{string(fields[0])};
+        if (fields.has(1)) {
+            step.setDescription(string(fields[1]));
+        }
+        return step;
+    }
+
+    static CSVFileInputStep decode(BinaryReader &in, uint32_t) {
+        CSVFileInputStep step(in.readString());
+        step.setDescription(in.readString());
+        return step;
+    }
+};
+
+template <>
+struct StepCodec<OutputStep> {
+    static OutputStep parse(const StepFields &fields) {
+        string_view source = fields[1];
+        string title(fields.has(2) ? fields[2] : string_view());
+        if (source.compare(0, 9, "template ") == 0) {
+            // Parsarea nu are un stream de ieșire: motivul ajunge în excepție, raportată de apelant
+            OutputStep step(string(fields[0]), 0, title);
+            ostringstream reason;
+            if (!step.setTemplateFile(string(trimView(source.substr(9))), reason)) {
+                throw runtime_error("Sablonul de raport nu a putut fi incarcat: " + trim(reason.str()));
+            }
+            return step;
+        }
+        return OutputStep(string(fields[0]), requireNumber<size_t>(source), title);
+    }
+
+    static OutputStep decode(BinaryReader &in, uint32_t version) {
+        string fileName = in.readString();
+        size_t stepNumber = static_cast<size_t>(in.read<uint64_t>());
+        string title = in.readString();
+        string templateFile = version >= 5 ? in.readString() : string();
+        return OutputStep(fileName, stepNumber, title, templateFile);
+    }
+};
+
+template <>
+struct StepCodec<DisplayStep> {
+    static DisplayStep parse(const StepFields &fields) {
+        DisplayRange range = parseDisplayRange(fields.has(1) ? fields[1] : string_view());
+        if (range.mode == DisplayMode::Pages) {
+            throw runtime_error("Afisarea pe pagini nu este disponibila in modul batch.");
+        }
+        return DisplayStep(requireNumber<size_t>(fields[0]), range);
+    }
+
+    static DisplayStep decode(BinaryReader &in, uint32_t version) {
+        size_t stepNumber = static_cast<size_t>(in.read<uint64_t>());
+        DisplayRange range;
+        if (version >= 4) {
+            uint8_t mode = in.read<uint8_t>();
+            if (mode > static_cast<uint8_t>(DisplayMode::Pages)) {
+                throw runtime_error("Mod de afisare invalid.");
+            }
+            range.mode = static_cast<DisplayMode>(mode);
+            range.first = in.read<uint64_t>();
+            range.count = in.read<uint64_t>();
+        }
+        return DisplayStep(stepNumber, range);
+    }
+};
+
+template <>
+struct StepCodec<EndStep> {
+    static EndStep parse(const StepFields &) {
+        return EndStep();
+    }
+
+    static EndStep decode(BinaryReader &, uint32_t) {
+        return EndStep();
+    }
+};
+
+// Funcțiile de construire ale unui tip de pas, în tabelul indexat după StepKind
+struct StepFactory {
+    StepValue (*parse)(const StepFields &fields);
+    StepValue (*decode)(BinaryReader &in, uint32_t version);
+};
+
+template <typename T>
+StepValue parseStepValue(const StepFields &fields) {
+    return StepCodec<T>::parse(fields);
+}
+
+template <typename T>
+StepValue decodeStepValue(BinaryReader &in, uint32_t version) {
+    return StepCodec<T>::decode(in, version);
+}
+
+template <size_t... Kinds>
+constexpr array<StepFactory, sizeof...(Kinds)> makeStepFactories(index_sequence<Kinds...>) {
+    return {{{&parseStepValue<variant_alternative_t<Kinds, StepValue>>, &decodeStepValue<variant_alternative_t<Kinds, StepValue>>}...}};
+}
+
+// Generat la compilare din StepValue, deci are aceeași ordine ca StepKind și stepTypeTable
+constexpr array<StepFactory, stepKindCount> stepFactories = makeStepFactories(make_index_sequence<stepKindCount>());
+
+// Reconstruiește un pas scris cu tipul său (u8) urmat de Step::writeBinary.
+// `version` este versiunea formatului în care a fost scris pasul.
+StepValue readStepBinary(BinaryReader &in, uint32_t version) {
+    uint8_t kind = in.read<uint8_t>();
+    if (kind >= stepKindCount) {
+        throw runtime_error("Tip de pas necunoscut.");
+    }
+    return stepFactories[kind].decode(in, version);
+}
+
+// Construiește un pas pe baza unei linii din fișierul de definiție (formatul de deasupra lui
+// runBatch(), fără `Set`), fără efecte secundare. Folosit de modul batch, de editarea pașilor din
+// meniu și de tipurile de pași fără formular propriu în meniul de creare.
+StepValue buildStep(string_view keyword, const vector<string_view> &fields) {
+    StepKind kind;
+    if (!parseStepKindKeyword(keyword, kind)) {
+        throw runtime_error("Tip de pas necunoscut: " + string(keyword));
+    }
+    return stepFactories[static_cast<size_t>(kind)].parse(StepFields(fields, keyword));
+}
+
+// Construiește un pas dintr-o linie completă ("Keyword câmp | câmp ..."). `fields` este refolosit
+// între linii, iar câmpurile sunt citite direct din `line`, fără copii intermediare.
+StepValue parseStepDefinition(string_view line, vector<string_view> &fields) {
+    line = trimView(line);
+    size_t separator = line.find_first_of(" \t");
+    splitFields(separator == string_view::npos ? string_view() : trimView(line.substr(separator + 1)), fields);
+    return buildStep(line.substr(0, separator), fields);
+}
+
+// Scrie pasul ca o linie în formatul de definiție; parseStepDefinition() îl citește înapoi.
+// Câmpurile nu sunt escapate, deci un '|' sau un sfârșit de linie dintr-un text nu se păstrează.
+void writeStepDefinition(TextWriter &out, StepKind kind, const Step &step) {
+    out << stepKindKeyword(kind) << ' ';
+    step.writeDefinition(out);
+    out << '\n';
+}
+
+// Scrie pe disc datele unui fișier deschis (fflush + fsync); returnează false la eroare
+bool syncFile(FILE *file) {
+    if (fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool syncFile(const string &path) {
+    FILE *file = fopen(path.c_str(), "r+b");
+    if (file == nullptr) {
+        return false;
+    }
+    bool synced = syncFile(file);
+    return fclose(file) == 0 && synced;
+}
+
+// Catalogul binar al flow-urilor salvate.
+//
+// Format (valorile numerice în ordinea de octeți a platformei):
+//   Header (32 octeți): magic "FLOWCAT\0", versiune u32, generație u32,
+//                       număr flow-uri u64, offset-ul indexului u64
+//   Generația crește la fiecare salvare; jurnalul (FlowJournal) o reține pe cea a catalogului
+//   căruia i se aplică, deci un jurnal mai vechi decât catalogul nu mai este reluat.
+//   O înregistrare pentru fiecare flow: nume (u32 lungime + octeți), număr pași u32,
+//       tipul fiecărui pas (u8 pentru fiecare pas), lungimea datelor pașilor u32,
+//       apoi pașii (tipul u8 + Step::writeBinary)
+//   Index: offset-ul fiecărei înregistrări (u64 pentru fiecare flow)
+//
+// La pornire fișierul este doar mapat în memorie. Listarea citește numele și tipurile
+// pașilor direct din mapare, iar pașii unui flow sunt decodați doar când acesta este rulat.
+class FlowCatalog {
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t generation;
+        uint64_t flowCount;
+        uint64_t indexOffset;
+    };
+
+    MappedFile file;
+    uint32_t version = 0;
+    uint32_t generation = 0;
+    size_t flowCount = 0;
+    const char *index = nullptr;
+    uint64_t flowIdBase = 0;  // Id-ul flow-ului de pe poziția 0; fiecare poziție are id-ul ei
+    vector<bool> deleted;  // Flow-uri șterse în sesiunea curentă, omise la salvare
+    size_t deletedCount = 0;
+
+public:
+    // O înregistrare văzută direct în fișierul mapat, fără copiere
+    struct Record {
+        string_view name;
+        string_view stepKinds;
+        string_view stepData;
+        string_view raw;
+    };
+
+    // Scrie un flow în formatul unei înregistrări (folosit și de jurnal)
+    static void appendFlowRecord(string &buffer, const Flow &flow) {
+        BinaryWriter out(buffer);
+        const StepStore &steps = flow.getSteps();
+        out.writeString(flow.getFlowName());
+        out.write<uint32_t>(static_cast<uint32_t>(steps.size()));
+        for (size_t i = 0; i < steps.size(); ++i) {
+            out.write<uint8_t>(static_cast<uint8_t>(steps.kind(i)));
+        }
+
+        size_t lengthPosition = buffer.size();
+        out.write<uint32_t>(0);
+        for (size_t i = 0; i < steps.size(); ++i) {
+            out.write<uint8_t>(static_cast<uint8_t>(steps.kind(i)));
+            steps[i].writeBinary(out);
+        }
+        uint32_t length = static_cast<uint32_t>(buffer.size() - lengthPosition - sizeof(uint32_t));
+        memcpy(&buffer[lengthPosition], &length, sizeof(length));
+    }
+
+    // Citește o înregistrare din `in` și respinge tipurile de pași necunoscute; câmpurile indică în
+    // datele citite
+    static Record readRecord(BinaryReader &in) {
+        Record record;
+        const char *start = in.take(0);
+        record.name = in.readView(in.read<uint32_t>());
+        record.stepKinds = in.readView(in.read<uint32_t>());
+        for (char kind : record.stepKinds) {
+            if (static_cast<uint8_t>(kind) >= stepKindCount) {
+                throw runtime_error("Tip de pas necunoscut in catalog.");
+            }
+        }
+        record.stepData = in.readView(in.read<uint32_t>());
+        const char *end = record.stepData.data() + record.stepData.size();
+        record.raw = string_view(start, static_cast<size_t>(end - start));
+        return record;
+    }
+
+    // Decodează pașii unei înregistrări scrise în versiunea `version` a formatului; un id 0
+    // dă flow-ului un id nou
+    static Flow decodeFlow(const Record &record, uint32_t version, uint64_t id = 0) {
+        Flow flow(string(record.name), id);
+        BinaryReader in(record.stepData.data(), record.stepData.size());
+        for (size_t i = 0; i < record.stepKinds.size(); ++i) {
+            flow.addStep(readStepBinary(in, version));
+        }
+        return flow;
+    }
+
+    // Versiunea 2 adaugă modul de acumulare al CalculusStep, versiunea 3 sursa CSV a valorilor,
+    // versiunea 4 intervalul de afișare al DisplayStep, versiunea 5 șablonul OutputStep,
+    // versiunea 6 pașii de intrare ai CalculusStep, versiunea 7 modelul căutat de TextFileInputStep;
+    // versiunile mai vechi sunt încă citite
+    static const uint32_t formatVersion = 7;
+
+    // Returnează false dacă fișierul nu există; aruncă excepție dacă fișierul este invalid
+    bool open(const string &path) {
+        close();
+        if (!file.open(path)) {
+            return false;
+        }
+
+        Header header;
+        if (file.getSize() < sizeof(header)) {
+            throw runtime_error("Fisierul este prea mic pentru un catalog.");
+        }
+        memcpy(&header, file.getData(), sizeof(header));
+        if (memcmp(header.magic, "FLOWCAT", 8) != 0) {
+            throw runtime_error("Fisierul nu este un catalog de flow-uri.");
+        }
+        if (header.version < 1 || header.version > formatVersion) {
+            throw runtime_error("Versiune de catalog necunoscuta: " + to_string(header.version));
+        }
+        if (header.indexOffset < sizeof(header) || header.indexOffset > file.getSize() ||
+            header.flowCount > (file.getSize() - header.indexOffset) / sizeof(uint64_t)) {
+            throw runtime_error("Indexul catalogului este corupt.");
+        }
+
+        version = header.version;
+        generation = header.generation;
+        flowCount = static_cast<size_t>(header.flowCount);
+        flowIdBase = reserveFlowIds(header.flowCount);
+        index = file.getData() + header.indexOffset;
+        return true;
+    }
+
+    void close() {
+        file.close();
+        generation = 0;
+        flowCount = 0;
+        index = nullptr;
+        deleted.clear();
+        deletedCount = 0;
+    }
+
+    size_t size() const {
+        return flowCount;
+    }
+
+    // 0 dacă nu există un catalog deschis
+    uint32_t getGeneration() const {
+        return generation;
+    }
+
+    size_t liveCount() const {
+        return flowCount - deletedCount;
+    }
+
+    bool isDeleted(size_t position) const {
+        return !deleted.empty() && deleted[position];
+    }
+
+    bool hasDeletions() const {
+        return deletedCount > 0;
+    }
+
+    void markDeleted(size_t position) {
+        if (deleted.empty()) {
+            deleted.resize(flowCount, false);
+        }
+        if (!deleted[position]) {
+            deleted[position] = true;
+            deletedCount++;
+        }
+    }
+
+    Record getRecord(size_t position) const {
+        uint64_t offset;
+        memcpy(&offset, index + position * sizeof(uint64_t), sizeof(offset));
+        size_t recordsEnd = static_cast<size_t>(index - file.getData());
+        if (offset < sizeof(Header) || offset >= recordsEnd) {
+            throw runtime_error("Offset invalid in catalog.");
+        }
+
+        BinaryReader in(file.getData() + offset, recordsEnd - static_cast<size_t>(offset));
+        return readRecord(in);
+    }
+
+    // Afișează un flow salvat în același format ca Flow::displayFlowInfo, fără a decoda pașii
+    void displayFlowInfo(size_t position) const {
+        Record record = getRecord(position);
+        cout << "Nume Flow: " << record.name << " | ";
+        for (char kind : record.stepKinds) {
+            cout << stepKindName(static_cast<StepKind>(kind)) << " | ";
+        }
+        cout << endl;
+    }
+
+    // Id-ul flow-ului de pe poziția dată, același la fiecare încărcare din catalogul deschis
+    uint64_t flowId(size_t position) const {
+        return flowIdBase + position;
+    }
+
+    // Decodează pașii unui flow salvat
+    Flow loadFlow(size_t position) const {
+        return decodeFlow(getRecord(position), version, flowId(position));
+    }
+
+    // Scrie catalogul nou (flow-urile salvate care nu au fost șterse, copiate ca atare,
+    // urmate de flow-urile din sesiune) într-un fișier temporar și îl înlocuiește pe cel vechi.
+    // După salvare catalogul curent este închis. Returnează generația catalogului nou.
+    uint32_t save(const string &path, const FlowRegistry &flows) {
+        string temporaryPath = path + ".tmp";
+        ofstream out(temporaryPath, ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            throw runtime_error("Eroare la crearea fisierului " + temporaryPath);
+        }
+
+        Header header = {};
+        memcpy(header.magic, "FLOWCAT", 8);
+        header.version = formatVersion;
+        header.generation = generation + 1;
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        vector<uint64_t> offsets;
+        offsets.reserve(liveCount() + flows.size());
+        uint64_t position = sizeof(header);
+        string buffer;
+        for (size_t i = 0; i < flowCount; ++i) {
+            if (isDeleted(i)) {
+                continue;
+            }
+            string_view raw = getRecord(i).raw;
+            if (version != formatVersion) {
+                // Înregistrările dintr-o versiune mai veche sunt recodate în formatul curent
+                buffer.clear();
+                appendFlowRecord(buffer, loadFlow(i));
+                raw = buffer;
+            }
+            offsets.push_back(position);
+            out.write(raw.data(), static_cast<streamsize>(raw.size()));
+            position += raw.size();
+        }
+
+        for (const Flow &flow : flows) {
+            buffer.clear();
+            appendFlowRecord(buffer, flow);
+            offsets.push_back(position);
+            out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            position += buffer.size();
+        }
+
+        header.flowCount = offsets.size();
+        header.indexOffset = position;
+        out.write(reinterpret_cast<const char *>(offsets.data()), static_cast<streamsize>(offsets.size() * sizeof(uint64_t)));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.close();
+        // Catalogul trebuie să fie pe disc înainte ca jurnalul să fie golit
+        if (!out || !syncFile(temporaryPath)) {
+            throw runtime_error("Eroare la scrierea fisierului " + temporaryPath);
+        }
+
+        close();
+#ifdef _WIN32
+        remove(path.c_str());
+#endif
+        if (rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            throw runtime_error("Eroare la inlocuirea catalogului " + path);
+        }
+        return header.generation;
+    }
+};
+
+// Momentul creării unui flow, din sufixul " - AAAA-LL-ZZ HH:MM:SS" pus de getCurrentDateTime, în secunde.
+// Ora locală este numărată ca și cum ar fi UTC (fără mktime), deci valorile sunt comparabile între ele
+// și cu cele date de parseDateTime, dar nu reprezintă un timestamp Unix.
+const int64_t noTimestamp = INT64_MIN;
+
+int64_t parseDateTime(string_view text) {
+    // "AAAA-LL-ZZ" sau "AAAA-LL-ZZ HH:MM:SS"
+    if (text.size() != 10 && text.size() != 19) {
+        return noTimestamp;
+    }
+    auto number = [&text](size_t position, size_t digits, int &value) {
+        value = 0;
+        for (size_t i = position; i < position + digits; ++i) {
+            if (!isdigit(static_cast<unsigned char>(text[i]))) {
+                return false;
+            }
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    };
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    bool valid = number(0, 4, year) && text[4] == '-' && number(5, 2, month) && text[7] == '-' && number(8, 2, day);
+    if (valid && text.size() == 19) {
+        valid = text[10] == ' ' && number(11, 2, hour) && text[13] == ':' && number(14, 2, minute) && text[16] == ':' &&
+                number(17, 2, second);
+    }
+    if (!valid || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return noTimestamp;
+    }
+    // Zilele de la 1970-01-01 în calendarul gregorian (algoritmul days_from_civil)
+    int64_t y = year - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yearOfEra = y - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = era * 146097 + dayOfEra - 719468;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+int64_t flowCreationTime(string_view flowName) {
+    const size_t suffixLength = 22;  // " - " + "AAAA-LL-ZZ HH:MM:SS"
+    if (flowName.size() < suffixLength || flowName.substr(flowName.size() - suffixLength, 3) != " - ") {
+        return noTimestamp;
+    }
+    return parseDateTime(flowName.substr(flowName.size() - suffixLength + 3));
+}
+
+// Condițiile unei căutări în FlowIndex; condițiile lipsă nu filtrează nimic
+struct FlowQuery {
+    string prefix;              // Începutul numelui
+    int64_t from = noTimestamp; // Intervalul închis al momentului creării (flow-urile fără moment sunt excluse)
+    int64_t to = noTimestamp;
+    uint32_t requiredKinds = 0; // Tipurile de pași pe care flow-ul trebuie să le conțină (bitul 1 << StepKind)
+
+    bool hasTimeRange() const {
+        return from != noTimestamp || to != noTimestamp;
+    }
+};
+
+// Indexul flow-urilor din meniu (salvate în catalog și create în sesiune) după nume, momentul
+// creării și tipurile de pași. Numele și momentele sunt în arbori ordonați, deci căutarea după
+// prefix și după interval costă O(log n + rezultate); pentru fiecare tip de pas se ține lista
+// flow-urilor care îl conțin, iar căutarea pornește de la cea mai scurtă listă cerută.
+// Indexul este actualizat la fiecare creare și ștergere, fără reconstruire.
+class FlowIndex {
+public:
+    // Un flow salvat este identificat prin poziția din catalog, unul din sesiune prin handle
+    struct Location {
+        bool saved = false;
+        size_t catalogPosition = 0;
+        FlowHandle handle;
+    };
+
+private:
+    static constexpr uint32_t noPosition = UINT32_MAX;
+    using NameTree = multimap<string, uint32_t, less<>>;
+    using TimeTree = multimap<int64_t, uint32_t>;
+
+    struct Entry {
+        Location location;
+        uint32_t kindMask = 0;
+        NameTree::iterator nameNode;
+        TimeTree::iterator timeNode;  // timeTree.end() dacă numele nu are moment de creare
+        uint32_t kindPosition[stepKindCount];  // Poziția în kindMembers, sau noPosition
+        bool live = false;
+    };
+
+    vector<Entry> entries;
+    vector<uint32_t> freeEntries;
+    vector<uint32_t> savedEntries;    // Intrarea fiecărei poziții din catalog
+    vector<uint32_t> sessionEntries;  // Intrarea fiecărui slot din FlowRegistry
+    NameTree nameTree;
+    TimeTree timeTree;
+    vector<uint32_t> kindMembers[stepKindCount];
+    size_t liveCount = 0;
+
+    static void assign(vector<uint32_t> &table, size_t key, uint32_t entry) {
+        if (table.size() <= key) {
+            table.resize(key + 1, noPosition);
+        }
+        table[key] = entry;
+    }
+
+    // Intrarea nouă, fără nodurile din arbori
+    uint32_t addEntry(const Location &location, uint32_t kindMask) {
+        uint32_t id;
+        if (!freeEntries.empty()) {
+            id = freeEntries.back();
+            freeEntries.pop_back();
+        } else {
+            id = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+        }
+        Entry &entry = entries[id];
+        entry.location = location;
+        entry.kindMask = kindMask;
+        entry.nameNode = nameTree.end();
+        entry.timeNode = timeTree.end();
+        for (size_t kind = 0; kind < stepKindCount; ++kind) {
+            entry.kindPosition[kind] = noPosition;
+            if (kindMask & (1u << kind)) {
+                entry.kindPosition[kind] = static_cast<uint32_t>(kindMembers[kind].size());
+                kindMembers[kind].push_back(id);
+            }
+        }
+        entry.live = true;
+        liveCount++;
+        return id;
+    }
+
+    uint32_t add(const Location &location, string_view name, uint32_t kindMask) {
+        uint32_t id = addEntry(location, kindMask);
+        Entry &entry = entries[id];
+        entry.nameNode = nameTree.emplace(string(name), id);
+        int64_t created = flowCreationTime(name);
+        if (created != noTimestamp) {
+            entry.timeNode = timeTree.emplace(created, id);
+        }
+        return id;
+    }
+
+    void remove(vector<uint32_t> &table, size_t key) {
+        if (key >= table.size() || table[key] == noPosition) {
+            return;
+        }
+        uint32_t id = table[key];
+        table[key] = noPosition;
+        Entry &entry = entries[id];
+        nameTree.erase(entry.nameNode);
+        if (entry.timeNode != timeTree.end()) {
+            timeTree.erase(entry.timeNode);
+        }
+        // Ca în FlowRegistry: ultimul membru al listei este mutat în locul celui șters
+        for (size_t kind = 0; kind < stepKindCount; ++kind) {
+            uint32_t position = entry.kindPosition[kind];
+            if (position == noPosition) {
+                continue;
+            }
+            vector<uint32_t> &members = kindMembers[kind];
+            members[position] = members.back();
+            entries[members[position]].kindPosition[kind] = position;
+            members.pop_back();
+        }
+        entry.live = false;
+        freeEntries.push_back(id);
+        liveCount--;
+    }
+
+    bool matches(const Entry &entry, const FlowQuery &query) const {
+        if ((entry.kindMask & query.requiredKinds) != query.requiredKinds) {
+            return false;
+        }
+        if (query.hasTimeRange()) {
+            if (entry.timeNode == timeTree.end()) {
+                return false;
+            }
+            int64_t created = entry.timeNode->first;
+            if ((query.from != noTimestamp && created < query.from) || (query.to != noTimestamp && created > query.to)) {
+                return false;
+            }
+        }
+        const string &name = entry.nameNode->first;
+        return name.compare(0, query.prefix.size(), query.prefix) == 0;
+    }
+
+public:
+    static_assert(stepKindCount <= 32, "Masca de tipuri are un bit pe tip de pas");
+
+    // Tipurile vin din FlowCatalog::readRecord, care respinge valorile necunoscute; un octet
+    // invalid este totuși ignorat aici, ca deplasarea să rămână sub 32 de biți
+    static uint32_t kindMaskOf(string_view stepKinds) {
+        uint32_t mask = 0;
+        for (char kind : stepKinds) {
+            if (static_cast<uint8_t>(kind) < stepKindCount) {
+                mask |= 1u << static_cast<uint8_t>(kind);
+            }
+        }
+        return mask;
+    }
+
+    static uint32_t kindMaskOf(const StepStore &steps) {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            mask |= 1u << static_cast<uint8_t>(steps.kind(i));
+        }
+        return mask;
+    }
+
+    // Adaugă toate flow-urile din catalog care nu sunt șterse; citește doar numele și tipurile pașilor.
+    // Nodurile sunt inserate în ordine, la sfârșitul arborilor, ceea ce este mult mai rapid decât
+    // inserarea lor una câte una în ordinea din catalog.
+    void addCatalog(const FlowCatalog &catalog) {
+        struct Pending {
+            string_view name;
+            int64_t created;
+            uint32_t id;
+        };
+        vector<Pending> pending;
+        pending.reserve(catalog.liveCount());
+        for (size_t i = 0; i < catalog.size(); ++i) {
+            if (!catalog.isDeleted(i)) {
+                removeSaved(i);
+                FlowCatalog::Record record = catalog.getRecord(i);
+                Location location;
+                location.saved = true;
+                location.catalogPosition = i;
+                uint32_t id = addEntry(location, kindMaskOf(record.stepKinds));
+                assign(savedEntries, i, id);
+                pending.push_back(Pending{record.name, flowCreationTime(record.name), id});
+            }
+        }
+
+        sort(pending.begin(), pending.end(), [](const Pending &a, const Pending &b) { return a.name < b.name; });
+        for (const Pending &flow : pending) {
+            entries[flow.id].nameNode = nameTree.emplace_hint(nameTree.upper_bound(flow.name), string(flow.name), flow.id);
+        }
+        stable_sort(pending.begin(), pending.end(), [](const Pending &a, const Pending &b) { return a.created < b.created; });
+        for (const Pending &flow : pending) {
+            if (flow.created != noTimestamp) {
+                entries[flow.id].timeNode = timeTree.emplace_hint(timeTree.upper_bound(flow.created), flow.created, flow.id);
+            }
+        }
+    }
+
+    void addSaved(size_t catalogPosition, string_view name, uint32_t kindMask) {
+        removeSaved(catalogPosition);
+        Location location;
+        location.saved = true;
+        location.catalogPosition = catalogPosition;
+        assign(savedEntries, catalogPosition, add(location, name, kindMask));
+    }
+
+    void addSession(FlowHandle handle, const Flow &flow) {
+        removeSession(handle);
+        Location location;
+        location.handle = handle;
+        assign(sessionEntries, handle.slot, add(location, flow.getFlowName(), kindMaskOf(flow.getSteps())));
+    }
+
+    void removeSaved(size_t catalogPosition) {
+        remove(savedEntries, catalogPosition);
+    }
+
+    void removeSession(FlowHandle handle) {
+        remove(sessionEntries, handle.slot);
+    }
+
+    size_t size() const {
+        return liveCount;
+    }
+
+    // Flow-urile care îndeplinesc toate condițiile, în ordinea numelui (sau a momentului creării,
+    // dacă lipsește prefixul și este dat un interval); cel mult `limit` rezultate
+    vector<Location> search(const FlowQuery &query, size_t limit = SIZE_MAX) const {
+        vector<Location> results;
+        auto collect = [&](uint32_t id) {
+            if (matches(entries[id], query)) {
+                results.push_back(entries[id].location);
+            }
+            return results.size() < limit;
+        };
+
+        if (!query.prefix.empty() || !query.hasTimeRange()) {
+            if (query.requiredKinds != 0 && query.prefix.empty()) {
+                // Doar tipuri de pași: cea mai scurtă listă dintre tipurile cerute
+                const vector<uint32_t> *shortest = nullptr;
+                for (size_t kind = 0; kind < stepKindCount; ++kind) {
+                    if ((query.requiredKinds & (1u << kind)) && (!shortest || kindMembers[kind].size() < shortest->size())) {
+                        shortest = &kindMembers[kind];
+                    }
+                }
+                for (uint32_t id : *shortest) {
+                    if (!collect(id)) {
+                        break;
+                    }
+                }
+                return results;
+            }
+            for (auto node = nameTree.lower_bound(query.prefix); node != nameTree.end(); ++node) {
+                if (node->first.compare(0, query.prefix.size(), query.prefix) != 0 || !collect(node->second)) {
+                    break;
+                }
+            }
+            return results;
+        }
+
+        auto node = query.from == noTimestamp ? timeTree.begin() : timeTree.lower_bound(query.from);
+        auto end = query.to == noTimestamp ? timeTree.end() : timeTree.upper_bound(query.to);
+        for (; node != end; ++node) {
+            if (!collect(node->second)) {
+                break;
+            }
+        }
+        return results;
+    }
+};
+
+// Indexul flow-urilor din meniu, construit la prima căutare sau alegere după prefix, astfel încât
+// pornirea să nu citească înregistrările catalogului. Până atunci modificările sunt ignorate:
+// indexul este construit din starea de atunci a catalogului și a sesiunii.
+class MenuFlowIndex {
+private:
+    const FlowCatalog &catalog;
+    const FlowRegistry &flows;
+    FlowIndex index;
+    bool built = false;
+
+public:
+    MenuFlowIndex(const FlowCatalog &catalog, const FlowRegistry &flows) : catalog(catalog), flows(flows) {}
+
+    FlowIndex &get() {
+        if (!built) {
+            built = true;
+            try {
+                index.addCatalog(catalog);
+            } catch (const exception &e) {
+                cerr << "Eroare la indexarea catalogului: " << e.what() << endl;
+            }
+            for (size_t i = 0; i < flows.size(); ++i) {
+                index.addSession(flows.handleAt(i), flows.at(i));
+            }
+        }
+        return index;
+    }
+
+    // Catalogul sau sesiunea au fost înlocuite (compactarea jurnalului)
+    void reset() {
+        index = FlowIndex();
+        built = false;
+    }
+
+    void addSession(FlowHandle handle, const Flow &flow) {
+        if (built) {
+            index.addSession(handle, flow);
+        }
+    }
+
+    void removeSaved(size_t catalogPosition) {
+        if (built) {
+            index.removeSaved(catalogPosition);
+        }
+    }
+
+    void removeSession(FlowHandle handle) {
+        if (built) {
+            index.removeSession(handle);
+        }
+    }
+};
+
+// Numărul unui flow în meniu: 1..catalog.size() pentru cele salvate, apoi cele din sesiune
+size_t flowMenuNumber(const FlowIndex::Location &location, const FlowCatalog &catalog, const FlowRegistry &flows) {
+    return location.saved ? location.catalogPosition + 1 : catalog.size() + flows.positionOf(location.handle) + 1;
+}
+
+// Afișează rezultatele unei căutări în ordinea din meniu (cel mult `limit`)
+void displayFlowSearchResults(vector<FlowIndex::Location> results, const FlowCatalog &catalog, const FlowRegistry &flows,
+                              size_t limit) {
+    vector<pair<size_t, const FlowIndex::Location *>> numbered;
+    numbered.reserve(results.size());
+    for (const FlowIndex::Location &location : results) {
+        numbered.emplace_back(flowMenuNumber(location, catalog, flows), &location);
+    }
+    sort(numbered.begin(), numbered.end());
+    for (size_t i = 0; i < numbered.size() && i < limit; ++i) {
+        cout << numbered[i].first << ". ";
+        if (numbered[i].second->saved) {
+            catalog.displayFlowInfo(numbered[i].second->catalogPosition);
+        } else {
+            flows.find(numbered[i].second->handle)->displayFlowInfo();
+        }
+    }
+    if (numbered.size() > limit) {
+        cout << "... inca " << numbered.size() - limit << " flow-uri" << endl;
+    }
+}
+
+// Citește alegerea unui flow: numărul din meniu sau începutul numelui, dacă acesta identifică un
+// singur flow. Returnează 0 dacă prefixul nu identifică un flow.
+size_t readFlowChoice(MenuFlowIndex &index, const FlowCatalog &catalog, const FlowRegistry &flows) {
+    string choice;
+    cin >> choice;
+    if (!choice.empty() && all_of(choice.begin(), choice.end(), [](unsigned char c) { return isdigit(c); })) {
+        // Un număr prea mare pentru size_t este o alegere invalidă, ca orice număr din afara listei
+        size_t number;
+        return parseNumber(choice, number) ? number : 0;
+    }
+    FlowQuery query;
+    query.prefix = choice;
+    vector<FlowIndex::Location> results = index.get().search(query, 21);
+    if (results.size() == 1) {
+        return flowMenuNumber(results[0], catalog, flows);
+    }
+    if (results.empty()) {
+        cout << "Niciun flow nu incepe cu '" << choice << "'." << endl;
+    } else {
+        cout << "Mai multe flow-uri incep cu '" << choice << "'; alegeti dupa numar:" << endl;
+        displayFlowSearchResults(move(results), catalog, flows, 20);
+    }
+    return 0;
+}
+
+// CRC-32 (polinomul IEEE), folosit de jurnal pentru a recunoaște înregistrările scrise parțial
+uint32_t crc32(const char *data, size_t size) {
+    static const vector<uint32_t> table = [] {
+        vector<uint32_t> values(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            values[i] = value;
+        }
+        return values;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Jurnalul modificărilor (write-ahead log) pentru flow-urile din meniu. Catalogul este
+// instantaneul; jurnalul păstrează modificările de după ultima salvare a catalogului, iar la
+// pornire doar acestea sunt reluate peste catalog.
+//
+// Format: header (16 octeți): magic "FLOWJRN\0", versiune u32, generația catalogului u32,
+//   apoi înregistrări: lungime u32, CRC-32 u32 (ambele pentru tip + date), tip u8, date.
+// O înregistrare incompletă sau cu CRC greșit (scriere întreruptă) încheie jurnalul.
+// Flow-urile din înregistrări sunt în formatul catalogului corespunzător versiunii jurnalului
+// (catalogVersion); un jurnal dintr-o versiune mai veche este încă reluat.
+//
+// Scrierea folosește group commit: append() pune înregistrarea în buffer și returnează imediat,
+// iar un fir dedicat scrie tot ce s-a adunat și face un singur fsync pentru toate înregistrările;
+// cât timp fsync rulează, înregistrările noi se adună pentru următorul. waitDurable() așteaptă
+// până când o înregistrare este pe disc.
+class FlowJournal {
+public:
+    enum class RecordType : uint8_t {
+        CreateFlow = 1,     // Înregistrarea flow-ului, în formatul catalogului
+        DeleteFlow = 2,     // id u64
+        SetNumberInput = 3, // id u64, poziție u32, valoare float
+        SetTextInput = 4,   // id u64, poziție u32, text
+        ReplaceFlow = 5     // id u64, înregistrarea flow-ului editat
+    };
+
+    struct ReplayStats {
+        size_t records = 0;
+        size_t failed = 0;     // Înregistrări valide care nu au putut fi aplicate
+        size_t bytes = 0;      // Octeții valizi, inclusiv header-ul
+        bool tornTail = false; // Jurnalul se termina cu o înregistrare incompletă
+        bool stale = false;    // Jurnalul aparține unei generații mai vechi a catalogului
+        uint32_t version = 0;  // Versiunea jurnalului reluat; 0 dacă nu a fost reluat
+        double seconds = 0;
+    };
+
+    static const uint32_t formatVersion = 2;
+
+    // Versiunea formatului catalogului în care sunt codate flow-urile din jurnal
+    static uint32_t catalogVersion(uint32_t journalVersion) {
+        static const uint32_t versions[formatVersion + 1] = {0, 6, FlowCatalog::formatVersion};
+        return versions[journalVersion];
+    }
+
+private:
+    static const size_t headerSize = 16;
+
+    string path;
+    FILE *file = nullptr;
+    string pending;               // Înregistrările încă nescrise
+    uint64_t appendedSequence = 0;
+    uint64_t durableSequence = 0;
+    uint64_t fileSize = 0;
+    uint64_t syncCount = 0;
+    bool failed = false;
+    bool stopping = false;
+    mutex journalMutex;
+    condition_variable dataAvailable;
+    condition_variable durable;
+    thread flusher;
+
+    static string header(uint32_t generation) {
+        string data;
+        BinaryWriter out(data);
+        data.append("FLOWJRN", 8);
+        out.write<uint32_t>(formatVersion);
+        out.write<uint32_t>(generation);
+        return data;
+    }
+
+    // Scrie `data` ca jurnal nou (fișier temporar + rename), fără a atinge jurnalul vechi până la final
+    static bool replaceFile(const string &path, const string &data) {
+        string temporaryPath = path + ".tmp";
+        FILE *temporary = fopen(temporaryPath.c_str(), "wb");
+        if (temporary == nullptr) {
+            return false;
+        }
+        bool written = fwrite(data.data(), 1, data.size(), temporary) == data.size() && syncFile(temporary);
+        written = fclose(temporary) == 0 && written;
+#ifdef _WIN32
+        remove(path.c_str());
+#endif
+        return written && rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+
+    void flusherLoop() {
+        string batch;
+        while (true) {
+            uint64_t sequence;
+            {
+                unique_lock<mutex> lock(journalMutex);
+                dataAvailable.wait(lock, [this] { return stopping || !pending.empty(); });
+                if (pending.empty()) {
+                    return;
+                }
+                batch.swap(pending);
+                sequence = appendedSequence;
+            }
+            bool written = fwrite(batch.data(), 1, batch.size(), file) == batch.size() && syncFile(file);
+            {
+                lock_guard<mutex> lock(journalMutex);
+                fileSize += batch.size();
+                durableSequence = sequence;
+                syncCount++;
+                failed = failed || !written;
+            }
+            batch.clear();
+            durable.notify_all();
+        }
+    }
+
+    void stopFlusher() {
+        if (!flusher.joinable()) {
+            return;
+        }
+        {
+            lock_guard<mutex> lock(journalMutex);
+            stopping = true;
+        }
+        dataAvailable.notify_all();
+        flusher.join();
+        stopping = false;
+    }
+
+public:
+    FlowJournal() = default;
+    FlowJournal(const FlowJournal &) = delete;
+    FlowJournal &operator=(const FlowJournal &) = delete;
+
+    ~FlowJournal() {
+        close();
+    }
+
+    // Citește jurnalul și apelează `apply(tip, date, versiunea catalogului)` pentru fiecare
+    // înregistrare validă, în ordine. Un jurnal lipsă sau al altei generații nu este reluat.
+    // Excepțiile din `apply` sunt numărate în `failed`, iar reluarea continuă.
+    template <typename Apply>
+    static ReplayStats replay(const string &path, uint32_t generation, Apply &&apply) {
+        ReplayStats stats;
+        auto start = chrono::steady_clock::now();
+        ifstream in(path, ios::binary);
+        string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        uint32_t version = 0, journalGeneration = 0;
+        bool isJournal = data.size() >= headerSize && data.compare(0, 8, string("FLOWJRN", 8)) == 0;
+        if (isJournal) {
+            memcpy(&version, data.data() + 8, sizeof(version));
+            memcpy(&journalGeneration, data.data() + 12, sizeof(journalGeneration));
+        }
+        if (!isJournal || version < 1 || version > formatVersion || journalGeneration != generation) {
+            stats.stale = isJournal;
+            stats.seconds = secondsSince(start);
+            return stats;
+        }
+        stats.version = version;
+
+        size_t position = headerSize;
+        while (data.size() - position >= 2 * sizeof(uint32_t)) {
+            uint32_t length, checksum;
+            memcpy(&length, data.data() + position, sizeof(length));
+            memcpy(&checksum, data.data() + position + sizeof(length), sizeof(checksum));
+            const char *record = data.data() + position + 2 * sizeof(uint32_t);
+            if (length == 0 || length > data.size() - position - 2 * sizeof(uint32_t) || crc32(record, length) != checksum) {
+                break;
+            }
+            try {
+                BinaryReader payload(record + 1, length - 1);
+                apply(static_cast<RecordType>(record[0]), payload, catalogVersion(version));
+            } catch (const exception &) {
+                stats.failed++;
+            }
+            stats.records++;
+            position += 2 * sizeof(uint32_t) + length;
+        }
+        stats.bytes = position;
+        stats.tornTail = position != data.size();
+        stats.seconds = secondsSince(start);
+        return stats;
+    }
+
+    // Datele înregistrărilor, în formatul din comentariul RecordType
+    static string encodeFlow(const Flow &flow, uint64_t id = UINT64_MAX) {
+        string data;
+        if (id != UINT64_MAX) {
+            BinaryWriter(data).write<uint64_t>(id);
+        }
+        FlowCatalog::appendFlowRecord(data, flow);
+        return data;
+    }
+
+    static string encodeDelete(uint64_t id) {
+        string data;
+        BinaryWriter(data).write<uint64_t>(id);
+        return data;
+    }
+
+    static string encodeNumberInput(uint64_t id, size_t position, float value) {
+        string data;
+        BinaryWriter out(data);
+        out.write<uint64_t>(id);
+        out.write<uint32_t>(static_cast<uint32_t>(position));
+        out.write<float>(value);
+        return data;
+    }
+
+    static string encodeTextInput(uint64_t id, size_t position, const string &value) {
+        string data;
+        BinaryWriter out(data);
+        out.write<uint64_t>(id);
+        out.write<uint32_t>(static_cast<uint32_t>(position));
+        out.writeString(value);
+        return data;
+    }
+
+    // Deschide jurnalul pentru adăugare după reluare: `validBytes` octeți sunt păstrați (0 pentru un
+    // jurnal nou), iar o coadă incompletă este eliminată
+    bool open(const string &journalPath, uint32_t generation, size_t validBytes) {
+        close();
+        path = journalPath;
+        if (validBytes == 0) {
+            if (!replaceFile(path, header(generation))) {
+                return false;
+            }
+            validBytes = headerSize;
+        } else {
+            ifstream in(path, ios::binary);
+            string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            if (data.size() != validBytes && !replaceFile(path, data.substr(0, validBytes))) {
+                return false;
+            }
+        }
+        file = fopen(path.c_str(), "ab");
+        if (file == nullptr) {
+            return false;
+        }
+        fileSize = validBytes;
+        failed = false;
+        flusher = thread([this] { flusherLoop(); });
+        return true;
+    }
+
+    bool isOpen() const {
+        return file != nullptr;
+    }
+
+    // Scrie înregistrările rămase și închide fișierul
+    void close() {
+        stopFlusher();
+        if (file != nullptr) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    // Înlocuiește jurnalul cu unul gol pentru generația dată (după salvarea catalogului)
+    bool reset(uint32_t generation) {
+        waitDurable(appendedSequence);
+        return open(path, generation, 0);
+    }
+
+    // Adaugă o înregistrare; returnează numărul ei de ordine, pentru waitDurable()
+    uint64_t append(RecordType type, string_view data) {
+        uint32_t length = static_cast<uint32_t>(data.size() + 1);
+        uint64_t sequence;
+        {
+            lock_guard<mutex> lock(journalMutex);
+            size_t position = pending.size();
+            pending.resize(position + 2 * sizeof(uint32_t) + length);
+            char *record = &pending[position + 2 * sizeof(uint32_t)];
+            record[0] = static_cast<char>(type);
+            memcpy(record + 1, data.data(), data.size());
+            uint32_t checksum = crc32(record, length);
+            memcpy(&pending[position], &length, sizeof(length));
+            memcpy(&pending[position + sizeof(length)], &checksum, sizeof(checksum));
+            sequence = ++appendedSequence;
+        }
+        dataAvailable.notify_one();
+        return sequence;
+    }
+
+    // Așteaptă până când înregistrarea `sequence` este pe disc; returnează false la o eroare de scriere
+    bool waitDurable(uint64_t sequence) {
+        unique_lock<mutex> lock(journalMutex);
+        durable.wait(lock, [&] { return durableSequence >= sequence || failed || file == nullptr; });
+        return !failed && durableSequence >= sequence;
+    }
+
+    // Octeții scriși în jurnal (pentru decizia de compactare)
+    uint64_t size() {
+        lock_guard<mutex> lock(journalMutex);
+        return fileSize + pending.size();
+    }
+
+    uint64_t getSyncCount() {
+        lock_guard<mutex> lock(journalMutex);
+        return syncCount;
+    }
+};
+
+// Identificatorii stabili ai flow-urilor din jurnal. Un flow salvat are ca id poziția din catalog
+// (și o păstrează când este mutat în sesiune pentru editare); un flow creat după ultima salvare a
+// catalogului primește catalog.size() + numărul creării. Reluarea jurnalului creează flow-urile în
+// aceeași ordine, deci obține aceleași id-uri.
+class JournalFlowIds {
+private:
+    uint64_t catalogSize = 0;
+    uint64_t nextId = 0;
+    unordered_map<uint64_t, FlowHandle> sessionFlows;
+    vector<uint64_t> idOfSlot;  // Id-ul fiecărui slot din FlowRegistry
+
+public:
+    void reset(size_t catalogFlows) {
+        catalogSize = catalogFlows;
+        nextId = catalogFlows;
+        sessionFlows.clear();
+        idOfSlot.clear();
+    }
+
+    // Înregistrează un flow din sesiune: unul nou (fără `id`) sau unul salvat mutat în sesiune
+    uint64_t addSession(FlowHandle handle, uint64_t id = UINT64_MAX) {
+        if (id == UINT64_MAX) {
+            id = nextId++;
+        }
+        sessionFlows[id] = handle;
+        if (idOfSlot.size() <= handle.slot) {
+            idOfSlot.resize(handle.slot + 1, UINT64_MAX);
+        }
+        idOfSlot[handle.slot] = id;
+        return id;
+    }
+
+    void removeSession(FlowHandle handle) {
+        sessionFlows.erase(idOfSlot[handle.slot]);
+        idOfSlot[handle.slot] = UINT64_MAX;
+    }
+
+    uint64_t idOf(FlowHandle handle) const {
+        return idOfSlot.at(handle.slot);
+    }
+
+    bool isSaved(uint64_t id) const {
+        return id < catalogSize && sessionFlows.count(id) == 0;
+    }
+
+    const FlowHandle *findSession(uint64_t id) const {
+        auto found = sessionFlows.find(id);
+        return found == sessionFlows.end() ? nullptr : &found->second;
+    }
+};
+
+// Aplică o înregistrare din jurnal peste catalog și flow-urile din sesiune, cu aceleași efecte ca
+// operația din meniu care a scris-o
+void applyJournalRecord(FlowJournal::RecordType type, BinaryReader &in, uint32_t version, FlowCatalog &catalog,
+                        FlowRegistry &flows, JournalFlowIds &ids, ostream &out) {
+    if (type == FlowJournal::RecordType::CreateFlow) {
+        ids.addSession(flows.insert(FlowCatalog::decodeFlow(FlowCatalog::readRecord(in), version)));
+        return;
+    }
+
+    uint64_t id = in.read<uint64_t>();
+    // Flow-ul din sesiune cu id-ul dat; un flow salvat este mutat în sesiune, ca la editarea din meniu
+    auto sessionFlow = [&]() -> Flow & {
+        if (const FlowHandle *handle = ids.findSession(id)) {
+            return *flows.find(*handle);
+        }
+        if (!ids.isSaved(id) || catalog.isDeleted(id)) {
+            throw runtime_error("Flow inexistent in jurnal: " + to_string(id));
+        }
+        FlowHandle handle = flows.insert(catalog.loadFlow(id));
+        catalog.markDeleted(id);
+        ids.addSession(handle, id);
+        return *flows.find(handle);
+    };
+
+    switch (type) {
+        case FlowJournal::RecordType::DeleteFlow:
+            if (const FlowHandle *handle = ids.findSession(id)) {
+                FlowHandle deleted = *handle;
+                ids.removeSession(deleted);
+                flows.erase(deleted);
+            } else if (ids.isSaved(id)) {
+                catalog.markDeleted(id);
+            }
+            break;
+        case FlowJournal::RecordType::SetNumberInput: {
+            uint32_t position = in.read<uint32_t>();
+            float value = in.read<float>();
+            sessionFlow().setNumberInput(position, value, out);
+            break;
+        }
+        case FlowJournal::RecordType::SetTextInput: {
+            uint32_t position = in.read<uint32_t>();
+            string value = in.readString();
+            sessionFlow().setTextInput(position, value, out);
+            break;
+        }
+        case FlowJournal::RecordType::ReplaceFlow: {
+            Flow &flow = sessionFlow();
+            flow = FlowCatalog::decodeFlow(FlowCatalog::readRecord(in), version, flow.getId());
+            flow.recalculate(out);
+            break;
+        }
+        default:
+            throw runtime_error("Tip de inregistrare necunoscut in jurnal.");
+    }
+}
+
+// Statisticile unei rulări în modul batch
+struct BatchStats {
+    size_t flows = 0;
+    size_t steps = 0;
+    size_t failedFlows = 0;
+    double seconds = 0;
+};
+
+// Aplică o linie `Set <numar step> | <valoare>` (câmpurile după `Set`): valoarea este numerică
+// pentru un NumberInput și text pentru un TextInput. Returnează numărul de pași recalculați.
+size_t setBatchInput(Flow &flow, const vector<string_view> &fields, ostream &out = cout) {
+    if (fields.size() < 2) {
+        throw runtime_error("Camp lipsa pentru pasul Set");
+    }
+    size_t position = requireNumber<size_t>(fields[0]) - 1;
+    size_t recomputed = position < flow.getSteps().size() && flow.getSteps().kind(position) == StepKind::NumberInput
+                            ? flow.setNumberInput(position, requireNumber<float>(fields[1]), out)
+                            : flow.setTextInput(position, string(fields[1]), out);
+    out << "Pasi recalculati: " << recomputed << endl;
+    return recomputed;
+}
+
+// Construiește un step pe baza unei linii din fișierul de definiție și îl adaugă în flow.
+// Efectele secundare (crearea fișierelor, afișarea) sunt aceleași ca în meniul interactiv;
+// mesajele lor sunt scrise în `out`.
+void addBatchStep(Flow &flow, string_view stepType, const vector<string_view> &fields, ostream &out = cout) {
+    if (stepType == "Set") {
+        setBatchInput(flow, fields, out);
+        return;
+    }
+
+    StepValue value = buildStep(stepType, fields);
+    visit([&flow, &out](auto &step) {
+        using T = decay_t<decltype(step)>;
+        T &addedStep = flow.addStep(move(step));
+        if constexpr (is_same<T, CalculusStep>::value) {
+            if (addedStep.readsSteps() && !flow.calculateStep(flow.getSteps().size() - 1, out)) {
+                throw runtime_error("Valorile din pasii referiti nu au putut fi calculate.");
+            }
+        } else if constexpr (is_same<T, TextFileInputStep>::value) {
+            addedStep.createFile(out);
+            addedStep.analyze(out);
+        } else if constexpr (is_same<T, CSVFileInputStep>::value) {
+            addedStep.createFile(out);
+            addedStep.loadTable(out);
+        } else if constexpr (is_same<T, OutputStep>::value) {
+            addedStep.createFile(flow.getSteps(), out);
+        } else if constexpr (is_same<T, DisplayStep>::value) {
+            addedStep.displayContent(flow.getSteps(), out);
+        }
+        flow.publishValue(flow.getSteps().size() - 1);
+    }, value);
+}
+
+// Editarea interactivă a pașilor unui flow (opțiunea 3 din meniu). Pașii noi se scriu în formatul
+// modului batch; modificările sunt păstrate ca versiuni până la salvare. Referințele la pași sunt
+// numere de pas, ca în formatul batch, deci nu sunt renumerotate la inserare, ștergere sau mutare.
+// Returnează true dacă flow-ul a fost înlocuit cu versiunea editată.
+bool editFlowSteps(Flow &flow) {
+    FlowEditor editor(flow);
+    auto readStep = []() {
+        cout << "Pasul, in formatul batch (ex. Title Titlu | Subtitlu, Calculus + | steps 1 2): ";
+        string line;
+        getline(cin >> ws, line);
+        vector<string_view> fields;
+        return parseStepDefinition(line, fields);
+    };
+
+    while (true) {
+        const StepList &steps = editor.steps();
+        cout << "\nVersiunea " << editor.currentVersion() << ", " << steps.size() << " pasi." << endl;
+        cout << "Comenzi: lista, insereaza <pozitie>, sterge <pozitie>, muta <de la> <la>, modifica <pozitie>," << endl;
+        cout << "         versiuni, revino <versiune>, salveaza, renunta" << endl;
+        cout << "Comanda: ";
+        string command;
+        if (!(cin >> command)) {
+            return false;
+        }
+        try {
+            if (command == "lista") {
+                size_t position = 0;
+                steps.forEach([&position](const StepValue &value) {
+                    ostringstream info;
+                    visit([&info](const auto &step) { step.getStepInfo(info); }, value);
+                    string summary = info.str();
+                    replace(summary.begin(), summary.end(), '\n', ' ');
+                    cout << ++position << ". " << stepKindName(static_cast<StepKind>(value.index())) << ": " << summary.substr(0, 80) << endl;
+                });
+            } else if (command == "insereaza" || command == "sterge" || command == "modifica" || command == "muta" || command == "revino") {
+                size_t first;
+                if (!(cin >> first)) {
+                    cin.clear();
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Numar invalid." << endl;
+                    continue;
+                }
+                if (command == "revino") {
+                    editor.rollback(first);
+                } else if (first == 0) {
+                    cout << "Pozitiile incep de la 1." << endl;
+                } else if (command == "insereaza") {
+                    if (first > steps.size() + 1) {
+                        throw out_of_range("Pozitia " + to_string(first) + " nu exista in flow.");
+                    }
+                    editor.insert(first - 1, readStep());
+                } else if (command == "sterge") {
+                    editor.erase(first - 1);
+                } else if (command == "modifica") {
+                    steps.at(first - 1);  // Poziția este verificată înainte de citirea pasului
+                    editor.replace(first - 1, readStep());
+                } else {
+                    size_t second;
+                    if (!(cin >> second) || second == 0) {
+                        cin.clear();
+                        cout << "Pozitie invalida." << endl;
+                        continue;
+                    }
+                    editor.moveStep(first - 1, second - 1);
+                }
+            } else if (command == "versiuni") {
+                for (size_t version = 0; version <= editor.currentVersion(); ++version) {
+                    cout << version << ". " << editor.getDescription(version) << " (" << editor.getVersions()[version].size() << " pasi)" << endl;
+                }
+            } else if (command == "salveaza") {
+                flow = editor.build();
+                cout << "Flow-ul a fost salvat cu " << flow.getSteps().size() << " pasi." << endl;
+                return true;
+            } else if (command == "renunta") {
+                return false;
+            } else {
+                cout << "Comanda necunoscuta." << endl;
+            }
+        } catch (const exception &e) {
+            cout << e.what() << endl;
+        }
+    }
+}
+
+// Punctul de intrare pentru modul batch: citește definițiile de flow-uri din `in`,
+// le construiește prin Flow::addStep și le rulează în paralel prin runFlowsParallel.
+//
+// Format (o instrucțiune pe linie, câmpurile separate prin '|'):
+//   flow <nume>
+//   Title <titlu> | <subtitlu>
+//   Text <titlu> | <copie>
+//   TextInput <descriere> [| <input>]
+//   NumberInput <descriere> [| <valoare>]
+//   Calculus <operatie> | <valoare> <valoare> ... [| float|double|kahan]
+//   Calculus <operatie> | csv <numar step> <coloana>
+//   Calculus <operatie> | text <numar step> lines|words|bytes|matches|uniquewords
+//   Calculus <operatie> | steps <numar step> <numar step> ...   (pași NumberInput sau Calculus)
+//   Calculus <expresie>   (ex. (step3 + step5) / max(step7, 1): + - * /, paranteze, min, max, abs)
+//   TextFileInput <fisier> [| <descriere> [| <text sau expresie regulata cautata, restul liniei>]]
+//   CSVFileInput <fisier> [| <descriere>]
+//   Output <fisier> | <numar step> [| <titlu>]
+//   Output <fisier> | template <fisier sablon> [| <titlu>]
+//   Display <numar step> [| head <n> | tail <n> | lines <prima> <ultima> | bytes <offset> <lungime>]
+//   Set <numar step> | <valoare>   (schimbă un NumberInput/TextInput și recalculează pașii care depind de el)
+//   End
+// Un flow se termină la `End`, la următorul `flow` sau la sfârșitul fișierului.
+// Liniile goale și cele care încep cu '#' sunt ignorate. Un flow cu o linie
+// invalidă este raportat pe cerr și sărit, iar rularea continuă cu următorul.
+BatchStats runBatch(istream &in, bool quiet) {
+    BatchStats stats;
+    NullBuffer nullBuffer;
+    streambuf *consoleBuffer = cout.rdbuf();
+    if (quiet) {
+        cout.rdbuf(&nullBuffer);
+    }
+
+    auto start = chrono::steady_clock::now();
+    unique_ptr<Flow> flow;
+    bool flowFailed = false;
+
+    // Flow-urile construite sunt rulate în paralel, în grupuri, cu output-ul în ordinea din fișier
+    const size_t runGroupSize = 256;
+    vector<Flow> readyFlows;
+    auto runReadyFlows = [&]() {
+        vector<const Flow *> group;
+        for (const Flow &readyFlow : readyFlows) {
+            group.push_back(&readyFlow);
+        }
+        runFlowsParallel(group, sharedThreadPool(), cout);
+        readyFlows.clear();
+    };
+
+    auto finishFlow = [&]() {
+        if (flow) {
+            if (flowFailed) {
+                stats.failedFlows++;
+            } else {
+                stats.flows++;
+                stats.steps += flow->getSteps().size();
+                readyFlows.push_back(move(*flow));
+                if (readyFlows.size() == runGroupSize) {
+                    runReadyFlows();
+                }
+            }
+        }
+        flow.reset();
+        flowFailed = false;
+    };
+
+    string line;
+    size_t lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        size_t separator = line.find_first_of(" \t");
+        string keyword = line.substr(0, separator);
+        string rest = separator == string::npos ? "" : trim(line.substr(separator + 1));
+
+        if (keyword == "flow") {
+            finishFlow();
+            flow = make_unique<Flow>(rest + " - " + getCurrentDateTime());
+            continue;
+        }
+        if (!flow) {
+            cerr << "Linia " << lineNumber << ": pasul '" << keyword << "' nu apartine niciunui flow." << endl;
+            continue;
+        }
+        if (flowFailed) {
+            continue;
+        }
+
+        try {
+            addBatchStep(*flow, keyword, splitFields(rest));
+        } catch (const exception &e) {
+            cerr << "Linia " << lineNumber << ": " << e.what() << endl;
+            flowFailed = true;
+            continue;
+        }
+
+        if (keyword == "End") {
+            finishFlow();
+        }
+    }
+    finishFlow();
+    runReadyFlows();
+    fileWriter().flush();
+
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout.rdbuf(consoleBuffer);
+    return stats;
+}
+
+int runBatchCommand(const string &source, bool quiet) {
+    BatchStats stats;
+    if (source == "-") {
+        stats = runBatch(cin, quiet);
+    } else {
+        ifstream file(source);
+        if (!file.is_open()) {
+            cerr << "Eroare la deschiderea fisierului de definitie: " << source << endl;
+            return 1;
+        }
+        stats = runBatch(file, quiet);
+    }
+
+    double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+    cout << "Flow-uri rulate: " << stats.flows << " (esuate: " << stats.failedFlows << ")" << endl;
+    cout << "Pasi rulati: " << stats.steps << endl;
+    cout << "Timp: " << stats.seconds << " s" << endl;
+    cout << "Throughput: " << stats.flows / seconds << " flow-uri/s, " << stats.steps / seconds << " pasi/s" << endl;
+    return stats.failedFlows == 0 ? 0 : 1;
+}
+
+// Aplică liniile unei definiții în formatul batch (pași și `Set`, fără `flow`) pe un flow existent.
+// Returnează numărul de linii aplicate; la prima linie invalidă aruncă runtime_error cu numărul
+// liniei, iar liniile de dinainte rămân aplicate.
+size_t applyFlowDefinition(Flow &flow, const string &definition, ostream &out) {
+    istringstream in(definition);
+    string line;
+    size_t lineNumber = 0;
+    size_t applied = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t separator = line.find_first_of(" \t");
+        string keyword = line.substr(0, separator);
+        string rest = separator == string::npos ? "" : trim(line.substr(separator + 1));
+        try {
+            if (keyword == "flow") {
+                throw runtime_error("o definitie contine pasii unui singur flow.");
+            }
+            addBatchStep(flow, keyword, splitFields(rest), out);
+        } catch (const exception &e) {
+            throw runtime_error("Linia " + to_string(lineNumber) + ": " + e.what());
+        }
+        applied++;
+    }
+    return applied;
+}
+
+// Citește o definiție dintr-un fișier sau de la stdin ("-"); aruncă runtime_error dacă fișierul lipsește
+string readDefinition(const string &source) {
+    ostringstream text;
+    if (source == "-") {
+        text << cin.rdbuf();
+    } else {
+        ifstream file(source);
+        if (!file.is_open()) {
+            throw runtime_error("Eroare la deschiderea fisierului de definitie: " + source);
+        }
+        text << file.rdbuf();
+    }
+    return text.str();
+}
+
+// Textul de utilizare, afișat pentru un argument necunoscut sau cu o valoare invalidă
+void printUsage(const char *program) {
+    cerr << "Utilizare: " << program << " [--workers <fire>] [--catalog <fisier>] [--batch <fisier|-> [--quiet]]" << endl;
+    cerr << "           [--stats <fisier.json|fisier.csv>] [--journal-limit <MB>] [--serve <socket>]" << endl;
+    cerr << "           [--client <socket> create <nume> <fisier|-> | run <id> | edit <id> <fisier|-> | set <id> <step> <valoare>" << endl;
+    cerr << "                             | delete <id> | list | stop]" << endl;
+    cerr << "           [--load <socket> [--clients <n>] [--requests <n>]]" << endl;
+    cerr << "           [--bench-steps <numar pasi>] [--bench-registry <numar flow-uri>] [--bench-calculus <numar valori>]" << endl;
+    cerr << "           [--bench-csv <numar randuri>] [--bench-text <MB>] [--bench-parallel <numar flow-uri>]" << endl;
+    cerr << "           [--bench-dag <numar fisiere CSV>] [--bench-incremental <numar pasi>]" << endl;
+    cerr << "           [--bench-expression <numar randuri>] [--bench-search <numar flow-uri>] [--bench-values <numar pasi>]" << endl;
+    cerr << "           [--bench-edit <numar pasi>] [--bench-journal <numar modificari>] [--bench-files <numar pasi>]" << endl;
+    cerr << "           [--bench-concurrent <numar operatii>] [--bench-serialize <numar pasi>]" << endl;
+    cerr << "           [--bench-suite [--steps <n>] [--repeat <n>] [--values <n>] [--text-bytes <n>] [--csv-rows <n>]" << endl;
+    cerr << "                          [--mix <Tip=pondere,...>] [--seed <n>] [--format csv|json] [--output <fisier>] [--filter <text>]]" << endl;
+}
+
+// Citește valoarea opțiunii argv[i] din argv[i + 1] și avansează i. O valoare care nu este un
+// număr pozitiv este raportată împreună cu textul de utilizare, iar rezultatul este false.
+template <typename T>
+bool readPositiveArgument(char *argv[], int &i, T &value) {
+    const char *option = argv[i];
+    if (parseNumber(argv[++i], value) && value > 0) {
+        return true;
+    }
+    cerr << "Valoare invalida pentru " << option << ": " << argv[i] << endl;
+    printUsage(argv[0]);
+    return false;
+}
+
+#ifndef _WIN32
+// Modul server (tema --serve <socket>): flow-urile rămân în memorie între cereri, iar clienții
+// locali le creează, rulează, editează și șterg printr-un socket Unix. Fiecare mesaj este un
+// uint32 cu lungimea conținutului, urmat de conținut scris cu BinaryWriter, în ordinea octeților
+// mașinii (clientul și serverul rulează pe aceeași mașină):
+//   cerere:   uint8 ServerRequest, uint64 id flow, string argument
+//   răspuns:  uint8 ServerStatus, uint64 valoare, string text (mesajele cererii sau eroarea)
+// Argumentul este: pentru Create numele flow-ului pe prima linie, apoi pașii în formatul batch;
+// pentru Edit pașii (și liniile Set) adăugați flow-ului; pentru Input "<numar step> | <valoare>".
+// Valoarea răspunsului este id-ul flow-ului creat, numărul de linii aplicate, numărul de pași
+// recalculați sau numărul de flow-uri listate.
+enum class ServerRequest : uint8_t { Create = 1, Run, Edit, Input, Delete, List, Shutdown };
+enum class ServerStatus : uint8_t { Ok = 0, Error = 1 };
+
+struct ServerResponse {
+    ServerStatus status = ServerStatus::Ok;
+    uint64_t value = 0;
+    string text;
+};
+
+const uint32_t maxServerMessage = 64u << 20;  // Conexiunea care anunță un mesaj mai mare este închisă
+
+// Începe un mesaj: lungimea este completată de finishServerMessage()
+string startServerMessage() {
+    return string(sizeof(uint32_t), '\0');
+}
+
+void finishServerMessage(string &message) {
+    uint32_t size = static_cast<uint32_t>(message.size() - sizeof(uint32_t));
+    memcpy(&message[0], &size, sizeof(size));
+}
+
+string encodeServerRequest(ServerRequest type, uint64_t id, const string &argument) {
+    string message = startServerMessage();
+    BinaryWriter out(message);
+    out.write<uint8_t>(static_cast<uint8_t>(type));
+    out.write<uint64_t>(id);
+    out.writeString(argument);
+    finishServerMessage(message);
+    return message;
+}
+
+string encodeServerResponse(const ServerResponse &response) {
+    string message = startServerMessage();
+    BinaryWriter out(message);
+    out.write<uint8_t>(static_cast<uint8_t>(response.status));
+    out.write<uint64_t>(response.value);
+    out.writeString(response.text);
+    finishServerMessage(message);
+    return message;
+}
+
+// Pune descriptorul în modul neblocant; false la eroare
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool fillSocketAddress(const string &path, sockaddr_un &address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Trimite tot bufferul pe un socket blocant; false la eroare
+bool sendAll(int fd, const char *data, size_t size) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, flags);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// Serverul de flow-uri: o buclă de evenimente (poll) pe firul apelant acceptă conexiunile, citește
+// cererile și scrie răspunsurile, iar cererile sunt procesate pe un pool de fire. O conexiune are
+// cel mult o cerere în lucru, deci răspunsurile sosesc în ordinea cererilor; conexiunile diferite
+// sunt servite în paralel. Flow-urile sunt păstrate după id; o cerere blochează doar flow-ul ei,
+// iar tabela este blocată exclusiv doar la creare și ștergere.
+class FlowServer {
+private:
+    struct ResidentFlow {
+        mutex lock;  // Rularea și editarea unui flow sunt serializate
+        Flow flow;
+
+        explicit ResidentFlow(const string &name) : flow(name) {}
+    };
+
+    struct Connection {
+        int fd = -1;
+        string input;
+        string output;
+        size_t written = 0;  // Octeții din `output` deja trimiși
+        bool busy = false;   // O cerere a conexiunii este procesată pe pool
+    };
+
+    string socketPath;
+    int listenFd = -1;
+    int wakeRead = -1;   // Bucla de evenimente este trezită prin pipe la răspunsuri și semnale
+    int wakeWrite = -1;
+
+    ConcurrentRegistry<ResidentFlow> flows;  // Căutarea nu blochează; ștergerea nu așteaptă rulările
+
+    unordered_map<uint64_t, Connection> connections;
+    uint64_t nextConnectionId = 1;
+    size_t inFlight = 0;  // Cereri trimise pe pool al căror răspuns nu a fost preluat
+    uint64_t served = 0;
+
+    mutex completedMutex;
+    vector<pair<uint64_t, string>> completed;  // Răspunsurile gata, cu id-ul conexiunii
+    atomic<bool> stopRequested{false};
+
+    inline static volatile sig_atomic_t signalled = 0;
+    inline static int signalWakeFd = -1;
+
+    unique_ptr<ThreadPool> workers;  // Oprit primul în destructor: sarcinile folosesc pipe-ul și tabelele
+
+    static void onSignal(int) {
+        signalled = 1;
+        if (signalWakeFd >= 0) {
+            char byte = 's';
+            (void)!write(signalWakeFd, &byte, 1);
+        }
+    }
+
+    void wake() {
+        char byte = 'r';
+        (void)!write(wakeWrite, &byte, 1);
+    }
+
+    shared_ptr<ResidentFlow> findFlow(uint64_t id) {
+        shared_ptr<ResidentFlow> resident = flows.find(id);
+        if (resident == nullptr) {
+            throw runtime_error("Flow-ul " + to_string(id) + " nu exista.");
+        }
+        return resident;
+    }
+
+    ServerResponse handle(const string &payload) {
+        ServerResponse response;
+        ostringstream out;
+        try {
+            BinaryReader in(payload.data(), payload.size());
+            ServerRequest type = static_cast<ServerRequest>(in.read<uint8_t>());
+            uint64_t id = in.read<uint64_t>();
+            string argument = in.readString();
+            switch (type) {
+                case ServerRequest::Create: {
+                    size_t newline = argument.find('\n');
+                    string name = trim(argument.substr(0, newline));
+                    if (name.empty()) {
+                        throw runtime_error("Flow-ul nu are nume.");
+                    }
+                    auto resident = make_shared<ResidentFlow>(name + " - " + getCurrentDateTime());
+                    applyFlowDefinition(resident->flow, newline == string::npos ? "" : argument.substr(newline + 1), out);
+                    response.value = flows.insert(move(resident));
+                    out << "Flow creat cu id-ul " << response.value << "." << endl;
+                    break;
+                }
+                case ServerRequest::Run: {
+                    shared_ptr<ResidentFlow> resident = findFlow(id);
+                    lock_guard<mutex> lock(resident->lock);
+                    resident->flow.execute(out, &sharedThreadPool());
+                    break;
+                }
+                case ServerRequest::Edit: {
+                    shared_ptr<ResidentFlow> resident = findFlow(id);
+                    lock_guard<mutex> lock(resident->lock);
+                    response.value = applyFlowDefinition(resident->flow, argument, out);
+                    out << "Linii aplicate: " << response.value << endl;
+                    break;
+                }
+                case ServerRequest::Input: {
+                    shared_ptr<ResidentFlow> resident = findFlow(id);
+                    lock_guard<mutex> lock(resident->lock);
+                    response.value = setBatchInput(resident->flow, splitFields(argument), out);
+                    break;
+                }
+                case ServerRequest::Delete: {
+                    shared_ptr<ResidentFlow> resident = flows.find(id);
+                    if (resident == nullptr || !flows.erase(id)) {
+                        throw runtime_error("Flow-ul " + to_string(id) + " nu exista.");
+                    }
+                    flowAnalytics().removeFlow(resident->flow.getId());
+                    out << "Flow-ul " << id << " a fost sters." << endl;
+                    break;
+                }
+                case ServerRequest::List: {
+                    map<uint64_t, string> names;  // Numele nu se schimbă după creare
+                    flows.forEach([&names](uint64_t flowId, const ResidentFlow &resident) {
+                        names.emplace(flowId, resident.flow.getFlowName());
+                    });
+                    for (const auto &entry : names) {
+                        out << entry.first << ". " << entry.second << endl;
+                    }
+                    response.value = names.size();
+                    break;
+                }
+                case ServerRequest::Shutdown:
+                    stopRequested = true;
+                    out << "Serverul se opreste." << endl;
+                    break;
+                default:
+                    throw runtime_error("Cerere necunoscuta: " + to_string(static_cast<int>(type)));
+            }
+        } catch (const exception &e) {
+            response.status = ServerStatus::Error;
+            out << e.what() << endl;
+        }
+        response.text = out.str();
+        return response;
+    }
+
+    // Trimite pe pool următoarea cerere completă a conexiunii; false dacă mesajul este prea mare
+    bool dispatch(uint64_t connectionId, Connection &connection) {
+        if (connection.busy || connection.input.size() < sizeof(uint32_t)) {
+            return true;
+        }
+        uint32_t size;
+        memcpy(&size, connection.input.data(), sizeof(size));
+        if (size > maxServerMessage) {
+            return false;
+        }
+        if (connection.input.size() < sizeof(uint32_t) + size) {
+            return true;
+        }
+        string payload = connection.input.substr(sizeof(uint32_t), size);
+        connection.input.erase(0, sizeof(uint32_t) + size);
+        connection.busy = true;
+        inFlight++;
+        workers->submit([this, connectionId, payload = move(payload)] {
+            string message = encodeServerResponse(handle(payload));
+            bool wasEmpty;
+            {
+                lock_guard<mutex> lock(completedMutex);
+                wasEmpty = completed.empty();
+                completed.emplace_back(connectionId, move(message));
+            }
+            // Un singur octet pentru toate răspunsurile adunate până la trezirea buclei
+            if (wasEmpty) {
+                wake();
+            }
+        });
+        return true;
+    }
+
+    // Citește tot ce este disponibil; false dacă clientul a închis conexiunea sau la eroare
+    bool readFrom(Connection &connection) {
+        char buffer[1 << 16];
+        while (true) {
+            ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                connection.input.append(buffer, static_cast<size_t>(received));
+            } else if (received < 0 && errno == EINTR) {
+                continue;
+            } else {
+                return received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            }
+        }
+    }
+
+    // Scrie cât acceptă socket-ul din răspunsurile în așteptare; false la eroare
+    bool writeTo(Connection &connection) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        while (connection.written < connection.output.size()) {
+            ssize_t sent = send(connection.fd, connection.output.data() + connection.written,
+                                connection.output.size() - connection.written, flags);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            connection.written += static_cast<size_t>(sent);
+        }
+        connection.output.clear();
+        connection.written = 0;
+        return true;
+    }
+
+    void closeConnection(unordered_map<uint64_t, Connection>::iterator it) {
+        close(it->second.fd);
+        connections.erase(it);
+    }
+
+    // Preia răspunsurile gata, le trimite și pornește următoarea cerere a fiecărei conexiuni.
+    // Răspunsul pentru o conexiune deja închisă este ignorat.
+    void deliverResponses() {
+        vector<pair<uint64_t, string>> ready;
+        {
+            lock_guard<mutex> lock(completedMutex);
+            ready.swap(completed);
+        }
+        for (auto &entry : ready) {
+            inFlight--;
+            served++;
+            auto it = connections.find(entry.first);
+            if (it == connections.end()) {
+                continue;
+            }
+            Connection &connection = it->second;
+            connection.busy = false;
+            connection.output += entry.second;
+            if (!writeTo(connection) || (!stopping() && !dispatch(entry.first, connection))) {
+                closeConnection(it);
+            }
+        }
+    }
+
+    void acceptConnections() {
+        while (true) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    perror("accept");
+                }
+                return;
+            }
+            if (!setNonBlocking(fd)) {
+                close(fd);
+                continue;
+            }
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            connections[nextConnectionId++].fd = fd;
+        }
+    }
+
+    bool stopping() const {
+        return signalled || stopRequested;
+    }
+
+    // Serverul se poate opri: nicio cerere în lucru și niciun răspuns netrimis
+    bool idle() const {
+        if (inFlight > 0) {
+            return false;
+        }
+        for (const auto &entry : connections) {
+            if (!entry.second.output.empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    FlowServer(const string &path, size_t workerCount) : socketPath(path), workers(make_unique<ThreadPool>(workerCount)) {}
+
+    FlowServer(const FlowServer &) = delete;
+    FlowServer &operator=(const FlowServer &) = delete;
+
+    ~FlowServer() {
+        workers.reset();
+        for (auto &entry : connections) {
+            close(entry.second.fd);
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+        signalWakeFd = -1;
+        if (wakeRead >= 0) {
+            close(wakeRead);
+            close(wakeWrite);
+        }
+    }
+
+    size_t workerCount() const {
+        return workers->size();
+    }
+
+    // Creează socket-ul și pipe-ul de trezire. Un socket rămas de la un server oprit brusc este
+    // înlocuit; dacă pe cale răspunde alt server, deschiderea eșuează. Erorile sunt scrise pe cerr.
+    bool open() {
+        sockaddr_un address;
+        if (!fillSocketAddress(socketPath, address)) {
+            cerr << "Calea socket-ului este goala sau prea lunga: " << socketPath << endl;
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe >= 0) {
+            bool inUse = connect(probe, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+            close(probe);
+            if (inUse) {
+                cerr << "Un alt server asculta deja pe " << socketPath << endl;
+                return false;
+            }
+        }
+        struct stat info;
+        if (stat(socketPath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+            unlink(socketPath.c_str());
+        }
+
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return false;
+        }
+        wakeRead = fds[0];
+        wakeWrite = fds[1];
+        setNonBlocking(wakeRead);
+        setNonBlocking(wakeWrite);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            perror("socket");
+            return false;
+        }
+        if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            cerr << "Eroare la crearea socket-ului " << socketPath << ": " << strerror(errno) << endl;
+            close(fd);
+            return false;
+        }
+        listenFd = fd;
+        if (listen(listenFd, 128) != 0 || !setNonBlocking(listenFd)) {
+            perror("listen");
+            return false;
+        }
+        fcntl(listenFd, F_SETFD, FD_CLOEXEC);
+        return true;
+    }
+
+    // Bucla de evenimente; se termină la o cerere Shutdown sau la SIGINT/SIGTERM, după ce cererile
+    // în lucru primesc răspuns. Returnează numărul de cereri servite.
+    uint64_t run() {
+        signalled = 0;
+        signalWakeFd = wakeWrite;
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = onSignal;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+        signal(SIGPIPE, SIG_IGN);
+
+        vector<pollfd> polled;
+        vector<uint64_t> polledConnections;
+        while (true) {
+            bool stopNow = stopping();
+            if (stopNow && idle()) {
+                break;
+            }
+            polled.clear();
+            polledConnections.clear();
+            polled.push_back({wakeRead, POLLIN, 0});
+            if (!stopNow) {
+                polled.push_back({listenFd, POLLIN, 0});
+            }
+            for (const auto &entry : connections) {
+                const Connection &connection = entry.second;
+                short events = 0;
+                // O conexiune ocupată nu mai este citită după ce are o cerere întreagă în așteptare
+                if (!stopNow && (!connection.busy || connection.input.size() < (1u << 20))) {
+                    events |= POLLIN;
+                }
+                if (!connection.output.empty()) {
+                    events |= POLLOUT;
+                }
+                polled.push_back({connection.fd, events, 0});
+                polledConnections.push_back(entry.first);
+            }
+
+            if (poll(polled.data(), polled.size(), -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("poll");
+                break;
+            }
+
+            if (polled[0].revents & POLLIN) {
+                char buffer[256];
+                while (read(wakeRead, buffer, sizeof(buffer)) > 0) {
+                }
+            }
+            deliverResponses();
+            if (!stopNow && (polled[1].revents & POLLIN)) {
+                acceptConnections();
+            }
+            size_t first = stopNow ? 1 : 2;
+            for (size_t k = 0; k < polledConnections.size(); ++k) {
+                auto it = connections.find(polledConnections[k]);
+                if (it == connections.end()) {
+                    continue;
+                }
+                short events = polled[first + k].revents;
+                Connection &connection = it->second;
+                bool keep = true;
+                if (events & (POLLIN | POLLHUP | POLLERR)) {
+                    keep = readFrom(connection);
+                }
+                if (keep && (events & POLLOUT)) {
+                    keep = writeTo(connection);
+                }
+                if (keep && !stopping()) {
+                    keep = dispatch(it->first, connection);
+                }
+                if (!keep) {
+                    closeConnection(it);
+                }
+            }
+        }
+        return served;
+    }
+};
+
+// Conexiune blocantă la un server pornit cu --serve; folosită de --client și de generatorul de încărcare
+class FlowClient {
+private:
+    int fd = -1;
+
+    bool receiveAll(char *data, size_t size) {
+        while (size > 0) {
+            ssize_t received = recv(fd, data, size, 0);
+            if (received <= 0) {
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+public:
+    FlowClient() = default;
+    FlowClient(const FlowClient &) = delete;
+    FlowClient &operator=(const FlowClient &) = delete;
+
+    ~FlowClient() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // false dacă serverul nu poate fi contactat (motivul este în errno)
+    bool connectTo(const string &path) {
+        sockaddr_un address;
+        if (!fillSocketAddress(path, address)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        return fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+    }
+
+    // Trimite o cerere și așteaptă răspunsul; aruncă runtime_error dacă conexiunea se întrerupe
+    ServerResponse call(ServerRequest type, uint64_t id = 0, const string &argument = "") {
+        string request = encodeServerRequest(type, id, argument);
+        uint32_t size;
+        if (!sendAll(fd, request.data(), request.size()) || !receiveAll(reinterpret_cast<char *>(&size), sizeof(size))) {
+            throw runtime_error("Conexiunea cu serverul a fost intrerupta.");
+        }
+        string payload(size, '\0');
+        if (!receiveAll(&payload[0], size)) {
+            throw runtime_error("Conexiunea cu serverul a fost intrerupta.");
+        }
+        BinaryReader in(payload.data(), payload.size());
+        ServerResponse response;
+        response.status = static_cast<ServerStatus>(in.read<uint8_t>());
+        response.value = in.read<uint64_t>();
+        response.text = in.readString();
+        return response;
+    }
+};
+
+// tema --serve <socket>: cererile sunt procesate pe --workers fire (cel puțin 2, ca o rulare lungă
+// să nu blocheze celelalte conexiuni); pașii unui flow rulează în paralel pe pool-ul comun
+int runServer(const string &socketPath) {
+    FlowServer server(socketPath, std::max<size_t>(sharedThreadPool().size(), 2));
+    if (!server.open()) {
+        return 1;
+    }
+    cout << "Server pornit pe " << socketPath << " (" << server.workerCount() << " fire pentru cereri)." << endl;
+    cout << "Oprire: Ctrl+C sau tema --client " << socketPath << " stop" << endl;
+    uint64_t served = server.run();
+    cout << "Server oprit: " << served << " cereri servite." << endl;
+    return 0;
+}
+
+// tema --client <socket> create <nume> <fisier|-> | run <id> | edit <id> <fisier|-> | set <id> <step> <valoare>
+//                        | delete <id> | list | stop
+int runClientCommand(int argc, char *argv[], int first) {
+    try {
+        if (first + 1 >= argc) {
+            throw runtime_error("Utilizare: --client <socket> create|run|edit|set|delete|list|stop ...");
+        }
+        string socketPath = argv[first];
+        string command = argv[first + 1];
+        auto argument = [&](int index) -> string {
+            if (first + 2 + index >= argc) {
+                throw runtime_error("Argument lipsa pentru comanda " + command);
+            }
+            return argv[first + 2 + index];
+        };
+
+        ServerRequest type;
+        uint64_t id = 0;
+        string text;
+        if (command == "create") {
+            type = ServerRequest::Create;
+            text = argument(0) + "\n" + readDefinition(argument(1));
+        } else if (command == "run" || command == "delete") {
+            type = command == "run" ? ServerRequest::Run : ServerRequest::Delete;
+            id = stoull(argument(0));
+        } else if (command == "edit") {
+            type = ServerRequest::Edit;
+            id = stoull(argument(0));
+            text = readDefinition(argument(1));
+        } else if (command == "set") {
+            type = ServerRequest::Input;
+            id = stoull(argument(0));
+            text = argument(1) + " | " + argument(2);
+        } else if (command == "list") {
+            type = ServerRequest::List;
+        } else if (command == "stop") {
+            type = ServerRequest::Shutdown;
+        } else {
+            throw runtime_error("Comanda necunoscuta: " + command);
+        }
+
+        FlowClient client;
+        if (!client.connectTo(socketPath)) {
+            throw runtime_error("Serverul de pe " + socketPath + " nu raspunde: " + strerror(errno));
+        }
+        ServerResponse response = client.call(type, id, text);
+        (response.status == ServerStatus::Ok ? cout : cerr) << response.text;
+        return response.status == ServerStatus::Ok ? 0 : 1;
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
+
+// tema --load <socket> [--clients <n>] [--requests <n>]: generatorul de încărcare. Fiecare client
+// deschide o conexiune și creează un flow propriu, apoi, după ce toți clienții sunt pregătiți,
+// trimite alternativ Input (o valoare nouă, cu recalcularea pașilor dependenți) și Run.
+// Raportează cererile/s și percentilele p50/p99 ale latenței, măsurate la client.
+int runLoadCommand(int argc, char *argv[], int first) {
+    size_t clientCount = 8;
+    size_t requestCount = 1000;  // Pe client
+    const size_t maxLoadClients = 4096;
+    string socketPath;
+    try {
+        if (first >= argc) {
+            throw runtime_error("Utilizare: --load <socket> [--clients <n>] [--requests <n>]");
+        }
+        socketPath = argv[first];
+        for (int i = first + 1; i < argc; ++i) {
+            string option = argv[i];
+            if (i + 1 >= argc) {
+                throw runtime_error("Lipseste valoarea pentru " + option);
+            }
+            if (option == "--clients") {
+                if (!readPositiveArgument(argv, i, clientCount)) {
+                    return 1;
+                }
+                if (clientCount > maxLoadClients) {
+                    throw runtime_error("Cel mult " + to_string(maxLoadClients) + " clienti (un fir pe client).");
+                }
+            } else if (option == "--requests") {
+                if (!readPositiveArgument(argv, i, requestCount)) {
+                    return 1;
+                }
+                requestCount = std::max<size_t>(requestCount, 2);  // Cel puțin un Input și un Run
+            } else {
+                throw runtime_error("Optiune necunoscuta pentru --load: " + option + " " + argv[i + 1]);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    const string definition =
+        "NumberInput pret | 10\n"
+        "NumberInput cantitate | 3\n"
+        "Calculus * | steps 1 2\n"
+        "Calculus (step3 + step1) / max(step2, 1)\n"
+        "End\n";
+
+    struct ClientResult {
+        vector<uint64_t> runLatency;
+        vector<uint64_t> inputLatency;
+        size_t errors = 0;
+        string failure;
+    };
+    vector<ClientResult> results(clientCount);
+    mutex startMutex;
+    condition_variable startSignal;
+    size_t ready = 0;
+    bool started = false;
+
+    auto clientLoop = [&](size_t c) {
+        ClientResult &result = results[c];
+        FlowClient client;
+        uint64_t flowId = 0;
+        try {
+            if (!client.connectTo(socketPath)) {
+                throw runtime_error("Serverul de pe " + socketPath + " nu raspunde: " + strerror(errno));
+            }
+            ServerResponse created = client.call(ServerRequest::Create, 0, "load-" + to_string(c) + "\n" + definition);
+            if (created.status != ServerStatus::Ok) {
+                throw runtime_error(created.text);
+            }
+            flowId = created.value;
+        } catch (const exception &e) {
+            result.failure = e.what();
+        }
+        {
+            unique_lock<mutex> lock(startMutex);
+            ready++;
+            startSignal.notify_all();
+            startSignal.wait(lock, [&] { return started; });
+        }
+        if (!result.failure.empty()) {
+            return;
+        }
+        result.runLatency.reserve(requestCount / 2 + 1);
+        result.inputLatency.reserve(requestCount / 2 + 1);
+        try {
+            for (size_t r = 0; r < requestCount; ++r) {
+                bool isRun = r % 2 == 1;
+                auto start = chrono::steady_clock::now();
+                ServerResponse response = isRun ? client.call(ServerRequest::Run, flowId)
+                                                : client.call(ServerRequest::Input, flowId, "1 | " + to_string(r % 1000));
+                (isRun ? result.runLatency : result.inputLatency).push_back(elapsedNanoseconds(start));
+                result.errors += response.status != ServerStatus::Ok;
+            }
+            client.call(ServerRequest::Delete, flowId);
+        } catch (const exception &e) {
+            result.failure = e.what();
+        }
+    };
+
+    signal(SIGPIPE, SIG_IGN);
+    vector<thread> clients;
+    for (size_t c = 0; c < clientCount; ++c) {
+        clients.emplace_back(clientLoop, c);
+    }
+    chrono::steady_clock::time_point start;
+    {
+        unique_lock<mutex> lock(startMutex);
+        startSignal.wait(lock, [&] { return ready == clientCount; });
+        started = true;
+        start = chrono::steady_clock::now();
+    }
+    startSignal.notify_all();
+    for (thread &client : clients) {
+        client.join();
+    }
+    double seconds = std::max(secondsSince(start), 1e-9);
+
+    vector<uint64_t> all;
+    vector<uint64_t> runs;
+    vector<uint64_t> inputs;
+    size_t errors = 0;
+    for (const ClientResult &result : results) {
+        if (!result.failure.empty()) {
+            cerr << result.failure << endl;
+            return 1;
+        }
+        runs.insert(runs.end(), result.runLatency.begin(), result.runLatency.end());
+        inputs.insert(inputs.end(), result.inputLatency.begin(), result.inputLatency.end());
+        errors += result.errors;
+    }
+    all = runs;
+    all.insert(all.end(), inputs.begin(), inputs.end());
+
+    // Percentila exactă (ns) a latențelor, în microsecunde
+    auto percentile = [](vector<uint64_t> &values, double q) {
+        if (values.empty()) {
+            return 0.0;
+        }
+        size_t rank = static_cast<size_t>(ceil(q * values.size()));
+        rank = rank == 0 ? 0 : rank - 1;
+        nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank] / 1e3;
+    };
+    auto report = [&](const char *label, vector<uint64_t> &values) {
+        cout << label << values.size() << " cereri, p50 " << percentile(values, 0.50) << " us, p99 "
+             << percentile(values, 0.99) << " us, max " << percentile(values, 1.0) << " us" << endl;
+    };
+    cout << "Clienti: " << clientCount << ", cereri: " << all.size() << " (erori: " << errors << ")" << endl;
+    cout << "Timp: " << seconds << " s" << endl;
+    cout << "Throughput: " << all.size() / seconds << " cereri/s" << endl;
+    report("Run:   ", runs);
+    report("Input: ", inputs);
+    report("Total: ", all);
+    return errors == 0 ? 0 : 1;
+}
+#else
+int runServer(const string &) {
+    cerr << "Modul server foloseste socket-uri Unix si nu este disponibil pe Windows." << endl;
+    return 1;
+}
+
+int runClientCommand(int, char *[], int) {
+    return runServer("");
+}
+
+int runLoadCommand(int, char *[], int) {
+    return runServer("");
+}
+#endif
+
+// Reprezentarea anterioară a pașilor unui flow (un obiect alocat pentru fiecare pas,
+// tipul aflat prin dynamic_cast), păstrată doar pentru comparația din benchmark
+class PointerStepList {
+private:
+    vector<Step *> steps;
+    vector<string> stepNames;
+    vector<float> number_Inputs;
+    vector<float> inputs;
+    bool hasEndStep = false;
+    uint64_t id = reserveFlowIds(1);
+
+public:
+    PointerStepList() {}
+    PointerStepList(const PointerStepList &) = delete;
+    PointerStepList &operator=(const PointerStepList &) = delete;
+
+    void addStep(Step *newStep) {
+        if (hasEndStep && dynamic_cast<EndStep *>(newStep)) {
+            delete newStep;
+            return;
+        }
+
+        if (NumberInputStep *numberInputStep = dynamic_cast<NumberInputStep *>(newStep)) {
+            number_Inputs.push_back(numberInputStep->getNumberInput());
+        } else if (CalculusStep *calculusStep = dynamic_cast<CalculusStep *>(newStep)) {
+            for (float value : calculusStep->getInputs()) {
+                inputs.push_back(value);
+            }
+        } else if (dynamic_cast<EndStep *>(newStep)) {
+            hasEndStep = true;
+        }
+
+        steps.push_back(newStep);
+        stepNames.push_back(string(newStep->getStepName()));
+    }
+
+    // Înregistrează aceleași durate ca Flow::runFlow, deci comparația măsoară doar stocarea pașilor
+    void runFlow(const string &name) const {
+        shared_ptr<FlowCounters> counters = flowAnalytics().flow(id, name);
+        shared_ptr<StepTiming[]> timings = counters->stepTimings(steps.size());
+        auto runStart = chrono::steady_clock::now();
+        auto stepStart = runStart;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            cout << "Step " << (i + 1) << " of Flow '" << name << "':" << endl;
+            steps[i]->getStepInfo(cout);
+            cout << endl;
+            auto stepEnd = chrono::steady_clock::now();
+            uint64_t elapsed = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(stepEnd - stepStart).count());
+            flowAnalytics().stepInfo(steps[i]->getKind()).record(elapsed);
+            timings[i].record(elapsed, false);
+            stepStart = stepEnd;
+        }
+        counters->runs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(stepStart - runStart).count()));
+    }
+
+    ~PointerStepList() {
+        for (Step *step : steps) {
+            delete step;
+        }
+    }
+};
+
+// Generează `count` pași care trec prin toate tipurile (cu excepția End Step) și îi trimite către `sink`
+template <typename Sink>
+void generateBenchmarkSteps(size_t count, Sink &&sink) {
+    for (size_t i = 0; i < count; ++i) {
+        switch (i % (stepKindCount - 1)) {
+            case 0:
+                sink(TitleStep("Titlu", "Subtitlu"));
+                break;
+            case 1:
+                sink(TextStep("Titlu", "Copie"));
+                break;
+            case 2: {
+                TextInputStep step("Descriere");
+                step.setInput("text");
+                sink(move(step));
+                break;
+            }
+            case 3: {
+                NumberInputStep step("Descriere");
+                step.setInput(static_cast<float>(i));
+                sink(move(step));
+                break;
+            }
+            case 4: {
+                CalculusStep step(0);
+                step.setOperation("+");
+                step.setInputs({1, 2, 3});
+                sink(move(step));
+                break;
+            }
+            case 5:
+                sink(TextFileInputStep("fisier"));
+                break;
+            case 6:
+                sink(CSVFileInputStep("date"));
+                break;
+            case 7:
+                sink(OutputStep("raport", 1, "Raport"));
+                break;
+            default:
+                sink(DisplayStep(6));
+                break;
+        }
+    }
+}
+
+// Compară addStep și runFlow pe un flow cu `count` pași: vector<Step *> + dynamic_cast
+// (reprezentarea anterioară) față de StepStore. Output-ul lui runFlow este suprimat.
+int runStepStorageBenchmark(size_t count) {
+    NullBuffer nullBuffer;
+    streambuf *consoleBuffer = cout.rdbuf();
+    const string flowName = "benchmark";
+
+    cout.rdbuf(&nullBuffer);
+    double pointerAdd, pointerRun, storeAdd, storeRun;
+    {
+        PointerStepList list;
+        auto start = chrono::steady_clock::now();
+        generateBenchmarkSteps(count, [&](auto &&step) {
+            list.addStep(new decay_t<decltype(step)>(move(step)));
+        });
+        list.addStep(new EndStep());
+        pointerAdd = secondsSince(start);
+
+        start = chrono::steady_clock::now();
+        list.runFlow(flowName);
+        pointerRun = secondsSince(start);
+    }
+    {
+        Flow flow(flowName);
+        auto start = chrono::steady_clock::now();
+        generateBenchmarkSteps(count, [&](auto &&step) {
+            flow.addStep(move(step));
+        });
+        flow.addStep(EndStep());
+        storeAdd = secondsSince(start);
+
+        start = chrono::steady_clock::now();
+        flow.runFlow();
+        storeRun = secondsSince(start);
+    }
+    cout.rdbuf(consoleBuffer);
+
+    double steps = static_cast<double>(count + 1);
+    cout << "Benchmark stocare pasi: " << count + 1 << " pasi" << endl;
+    cout << "vector<Step *> + dynamic_cast: addStep " << steps / pointerAdd << " pasi/s, runFlow " << steps / pointerRun << " pasi/s" << endl;
+    cout << "StepStore (variant contiguu):  addStep " << steps / storeAdd << " pasi/s, runFlow " << steps / storeRun << " pasi/s" << endl;
+    return 0;
+}
+
+// Creează `count` flow-uri în registru, le caută după handle și le șterge în ordine aleatoare
+int runRegistryBenchmark(size_t count) {
+    FlowRegistry registry;
+    vector<FlowHandle> handles;
+    handles.reserve(count);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        Flow flow("flow " + to_string(i));
+        flow.addStep(TitleStep("Titlu", "Subtitlu"));
+        flow.addStep(EndStep());
+        handles.push_back(registry.insert(move(flow)));
+    }
+    double insertSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t found = 0;
+    for (FlowHandle handle : handles) {
+        found += registry.find(handle) != nullptr;
+    }
+    double findSeconds = secondsSince(start);
+
+    shuffle(handles.begin(), handles.end(), mt19937(42));
+    start = chrono::steady_clock::now();
+    size_t erased = 0;
+    for (FlowHandle handle : handles) {
+        erased += registry.erase(handle);
+    }
+    double eraseSeconds = secondsSince(start);
+
+    double flows = static_cast<double>(count);
+    cout << "Benchmark registru: " << count << " flow-uri (gasite: " << found << ", sterse: " << erased << ")" << endl;
+    cout << "Creare: " << flows / insertSeconds << " flow-uri/s" << endl;
+    cout << "Cautare: " << flows / findSeconds << " operatii/s" << endl;
+    cout << "Stergere: " << flows / eraseSeconds << " operatii/s" << endl;
+    return found == count && erased == count ? 0 : 1;
+}
+
+// Registrul de dinainte al serverului, ca reper pentru ConcurrentRegistry: o tabelă hash sub un
+// singur shared_mutex, cu aceeași interfață
+template <typename T>
+class LockedRegistry {
+private:
+    shared_mutex mutex;
+    unordered_map<uint64_t, shared_ptr<T>> values;
+    uint64_t nextId = 1;
+
+public:
+    uint64_t insert(shared_ptr<T> value) {
+        lock_guard<shared_mutex> lock(mutex);
+        values.emplace(nextId, move(value));
+        return nextId++;
+    }
+
+    shared_ptr<T> find(uint64_t id) {
+        shared_lock<shared_mutex> lock(mutex);
+        auto it = values.find(id);
+        return it == values.end() ? nullptr : it->second;
+    }
+
+    bool erase(uint64_t id) {
+        lock_guard<shared_mutex> lock(mutex);
+        return values.erase(id) != 0;
+    }
+
+    template <typename Function>
+    void forEach(Function &&function) {
+        shared_lock<shared_mutex> lock(mutex);
+        for (const auto &entry : values) {
+            function(entry.first, *entry.second);
+        }
+    }
+
+    size_t size() {
+        shared_lock<shared_mutex> lock(mutex);
+        return values.size();
+    }
+};
+
+struct ConcurrentRunResult {
+    double seconds = 0;
+    bool consistent = true;
+};
+
+// `operations` operații împărțite între `threads` fire, pornite împreună: 80% căutări (jumătate
+// pe flow-uri care nu sunt șterse niciodată și trebuie găsite, jumătate pe flow-uri create
+// recent, care pot fi șterse chiar atunci), 10% creări, 10% ștergeri ale flow-urilor create de
+// același fir și, la fiecare 4096 de operații, o parcurgere a registrului. La final numărul de
+// flow-uri trebuie să fie cel așteptat, atât după size(), cât și după parcurgere.
+template <typename Registry>
+ConcurrentRunResult runConcurrentMix(size_t threads, size_t operations, size_t preloaded) {
+    Registry registry;
+    for (size_t i = 0; i < preloaded; ++i) {
+        registry.insert(make_shared<Flow>("flow " + to_string(i)));
+    }
+
+    atomic<uint64_t> lastInserted{preloaded};
+    atomic<size_t> ready{0};
+    atomic<bool> start{false};
+    atomic<bool> consistent{true};
+    vector<size_t> remaining(threads);  // Flow-urile create de fiecare fir și încă neșterse
+    vector<thread> workers;
+    workers.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            mt19937_64 generator(t + 1);
+            vector<uint64_t> own;
+            size_t share = operations / threads + (t < operations % threads ? 1 : 0);
+            size_t checksum = 0;
+            ready.fetch_add(1);
+            while (!start.load(memory_order_acquire)) {
+                this_thread::yield();
+            }
+            for (size_t i = 0; i < share; ++i) {
+                uint64_t choice = generator() % 100;
+                if (i % 4096 == 4095) {
+                    size_t visited = 0;
+                    registry.forEach([&visited](uint64_t, const Flow &flow) {
+                        visited += !flow.getFlowName().empty();
+                    });
+                    if (visited < preloaded) {
+                        consistent = false;
+                    }
+                } else if (choice < 40) {
+                    shared_ptr<Flow> flow = registry.find(1 + generator() % preloaded);
+                    if (flow == nullptr) {
+                        consistent = false;
+                    } else {
+                        checksum += flow->getFlowName().size();
+                    }
+                } else if (choice < 80) {
+                    uint64_t newest = lastInserted.load(memory_order_relaxed);
+                    shared_ptr<Flow> flow = registry.find(newest - generator() % 64);
+                    if (flow != nullptr) {
+                        checksum += flow->getFlowName().size();
+                    }
+                } else if (choice < 90 || own.empty()) {
+                    uint64_t id = registry.insert(make_shared<Flow>("flow nou"));
+                    own.push_back(id);
+                    lastInserted.store(id, memory_order_relaxed);
+                } else {
+                    size_t index = generator() % own.size();
+                    if (!registry.erase(own[index])) {
+                        consistent = false;
+                    }
+                    own[index] = own.back();
+                    own.pop_back();
+                }
+            }
+            remaining[t] = own.size();
+            if (checksum == 0 && share > 1000) {
+                consistent = false;
+            }
+        });
+    }
+
+    while (ready.load() < threads) {
+        this_thread::yield();
+    }
+    auto begin = chrono::steady_clock::now();
+    start.store(true, memory_order_release);
+    for (thread &worker : workers) {
+        worker.join();
+    }
+    ConcurrentRunResult result;
+    result.seconds = secondsSince(begin);
+
+    size_t expected = preloaded + accumulate(remaining.begin(), remaining.end(), size_t(0));
+    size_t visited = 0;
+    registry.forEach([&visited](uint64_t, const Flow &) {
+        visited++;
+    });
+    result.consistent = consistent && registry.size() == expected && visited == expected;
+    return result;
+}
+
+// Aceeași încărcare pe ConcurrentRegistry și pe registrul cu un singur lacăt, de la 1 la 64 de fire
+int runConcurrentRegistryBenchmark(size_t operations) {
+    const size_t preloaded = 10000;
+    cout << "Benchmark registru concurent: " << operations << " operatii, " << preloaded << " flow-uri initiale, "
+         << thread::hardware_concurrency() << " nuclee" << endl;
+    bool consistent = true;
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        ConcurrentRunResult sharded = runConcurrentMix<ConcurrentRegistry<Flow>>(threads, operations, preloaded);
+        ConcurrentRunResult locked = runConcurrentMix<LockedRegistry<Flow>>(threads, operations, preloaded);
+        consistent = consistent && sharded.consistent && locked.consistent;
+        cout << setw(2) << threads << " fire: ConcurrentRegistry " << operations / sharded.seconds << " operatii/s, un lacat "
+             << operations / locked.seconds << " operatii/s, x" << locked.seconds / sharded.seconds << endl;
+    }
+    cout << "Rezultate consistente: " << (consistent ? "da" : "nu") << endl;
+    return consistent ? 0 : 1;
+}
+
+// Rulează `function` de `repetitions` ori și returnează cel mai scurt timp
+template <typename Function>
+double bestOfSeconds(int repetitions, Function &&function) {
+    double best = numeric_limits<double>::max();
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = chrono::steady_clock::now();
+        function();
+        best = std::min(best, secondsSince(start));
+    }
+    return best;
+}
+
+// Indexul de căutare pe `count` flow-uri salvate într-un catalog temporar: construire la pornire,
+// căutare după prefix, interval de timp și tip de pas (comparate cu parcurgerea catalogului, ca la
+// listare), apoi ștergeri de flow-uri salvate și creări de flow-uri în sesiune
+int runSearchBenchmark(size_t count) {
+    const string catalogPath = "bench_search.cat";
+    FlowCatalog catalog;
+    {
+        FlowRegistry registry;
+        registry.reserve(count);
+        mt19937 generator(7);
+        for (size_t i = 0; i < count; ++i) {
+            // Momente de creare răspândite pe un an, cu 1% din flow-uri care au un pas CSVFileInput
+            time_t created = 1700000000 + static_cast<time_t>(generator() % (365 * 86400));
+            char date[32];
+            strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", gmtime(&created));
+            Flow flow("client" + to_string(generator() % 1000) + "_flow" + to_string(i) + " - " + date);
+            flow.addStep(TitleStep("Titlu", "Subtitlu"));
+            if (generator() % 100 == 0) {
+                flow.addStep(CSVFileInputStep("date"));
+            }
+            flow.addStep(EndStep());
+            registry.insert(move(flow));
+        }
+        catalog.save(catalogPath, registry);
+    }
+    if (!catalog.open(catalogPath)) {
+        cerr << "Eroare la deschiderea catalogului " << catalogPath << endl;
+        return 1;
+    }
+
+    FlowIndex index;
+    auto start = chrono::steady_clock::now();
+    index.addCatalog(catalog);
+    double buildSeconds = secondsSince(start);
+
+    FlowQuery prefixQuery;
+    prefixQuery.prefix = "client42_";
+    FlowQuery timeQuery;
+    timeQuery.from = parseDateTime("2024-03-01");
+    timeQuery.to = parseDateTime("2024-03-01") + 86399;
+    FlowQuery kindQuery;
+    kindQuery.requiredKinds = 1u << static_cast<uint8_t>(StepKind::CSVFileInput);
+
+    // Varianta fără index: fiecare flow din catalog este verificat
+    auto scan = [&catalog](const FlowQuery &query) {
+        size_t found = 0;
+        for (size_t i = 0; i < catalog.size(); ++i) {
+            if (catalog.isDeleted(i)) {
+                continue;
+            }
+            FlowCatalog::Record record = catalog.getRecord(i);
+            int64_t created = flowCreationTime(record.name);
+            found += record.name.substr(0, query.prefix.size()) == query.prefix &&
+                     (FlowIndex::kindMaskOf(record.stepKinds) & query.requiredKinds) == query.requiredKinds &&
+                     (!query.hasTimeRange() || (created != noTimestamp && (query.from == noTimestamp || created >= query.from) &&
+                                                (query.to == noTimestamp || created <= query.to)));
+        }
+        return found;
+    };
+
+    bool consistent = index.size() == count;
+    cout << "Benchmark cautare: " << count << " flow-uri, indexul construit in " << buildSeconds * 1e3 << " ms" << endl;
+    for (const pair<const char *, FlowQuery *> &test : {make_pair("prefix", &prefixQuery), make_pair("interval", &timeQuery),
+                                                        make_pair("tip de pas", &kindQuery)}) {
+        size_t indexed = 0;
+        size_t scanned = 0;
+        double indexSeconds = bestOfSeconds(5, [&] { indexed = index.search(*test.second).size(); });
+        double scanSeconds = bestOfSeconds(1, [&] { scanned = scan(*test.second); });
+        consistent = consistent && indexed == scanned;
+        cout << "Cautare dupa " << test.first << ": " << indexed << " rezultate, index " << indexSeconds * 1e6
+             << " us, parcurgere " << scanSeconds * 1e6 << " us" << endl;
+    }
+
+    // Jumătate din flow-urile salvate sunt șterse, iar pentru fiecare este creat un flow în sesiune
+    FlowRegistry flows;
+    size_t changes = count / 2;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < changes; ++i) {
+        catalog.markDeleted(i * 2);
+        index.removeSaved(i * 2);
+        Flow flow("client42_sesiune" + to_string(i) + " - " + getCurrentDateTime());
+        flow.addStep(EndStep());
+        FlowHandle handle = flows.insert(move(flow));
+        index.addSession(handle, *flows.find(handle));
+    }
+    double changeSeconds = secondsSince(start);
+    consistent = consistent && index.size() == catalog.liveCount() + flows.size() &&
+                 index.search(prefixQuery).size() == scan(prefixQuery) + flows.size();
+    cout << "Stergere + creare: " << changeSeconds * 1e9 / std::max<size_t>(changes, 1) << " ns/flow" << endl;
+    cout << "Rezultate identice: " << (consistent ? "da" : "nu") << endl;
+    catalog.close();
+    remove(catalogPath.c_str());
+    return consistent ? 0 : 1;
+}
+
+// Editarea pe versiuni a unui flow cu `count` pași: modificări aleatoare (inserare, ștergere,
+// mutare, înlocuire) față de copierea tuturor pașilor la fiecare versiune, memoria versiunilor și
+// revenirea la o versiune anterioară
+int runEditBenchmark(size_t count) {
+    Flow flow("bench_edit");
+    flow.reserveSteps(count);
+    generateBenchmarkSteps(count, [&flow](auto &&step) { flow.addStep(move(step)); });
+
+    auto start = chrono::steady_clock::now();
+    FlowEditor editor(flow);
+    double openSeconds = secondsSince(start);
+
+    const size_t edits = 10000;
+    mt19937 generator(11);
+    start = chrono::steady_clock::now();
+    for (size_t e = 0; e < edits; ++e) {
+        size_t size = editor.steps().size();
+        size_t position = generator() % size;
+        switch (e % 4) {
+            case 0:
+                editor.insert(position, TextStep("Titlu", "Pas inserat " + to_string(e)));
+                break;
+            case 1:
+                editor.erase(position);
+                break;
+            case 2:
+                editor.moveStep(position, generator() % size);
+                break;
+            default:
+                editor.replace(position, TitleStep("Titlu", "Pas modificat " + to_string(e)));
+                break;
+        }
+    }
+    double editSeconds = secondsSince(start);
+
+    // Varianta naivă: fiecare versiune este o copie completă a pașilor (o singură copie ținută în memorie)
+    const size_t copies = std::max<size_t>(1, std::min<size_t>(100, 2000000 / std::max<size_t>(count, 1)));
+    StepStore copy;
+    start = chrono::steady_clock::now();
+    for (size_t e = 0; e < copies; ++e) {
+        copy = flow.getSteps();
+    }
+    double copySeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    editor.rollback(0);
+    double rollbackSeconds = secondsSince(start);
+
+    NullBuffer nullBuffer;
+    ostream discard(&nullBuffer);
+    start = chrono::steady_clock::now();
+    Flow rebuilt = editor.build(discard);
+    double buildSeconds = secondsSince(start);
+
+    size_t nodes = StepList::distinctNodes(editor.getVersions());
+    bool consistent = rebuilt.getSteps().size() == count;
+    for (size_t i = 0; consistent && i < count; ++i) {
+        consistent = rebuilt.getSteps().kind(i) == flow.getSteps().kind(i);
+    }
+    cout << "Benchmark editare: " << count << " pasi, " << edits << " modificari" << endl;
+    cout << "Deschidere editor: " << openSeconds * 1e3 << " ms" << endl;
+    cout << "Modificare pe versiuni: " << editSeconds * 1e9 / edits << " ns/modificare" << endl;
+    cout << "Copiere completa: " << copySeconds * 1e9 / copies << " ns/versiune" << endl;
+    cout << "Noduri in toate cele " << editor.getVersions().size() << " versiuni: " << nodes << " (" << count
+         << " in versiunea initiala, " << static_cast<double>(nodes - count) / edits << " noi/modificare)" << endl;
+    cout << "Revenire la versiunea initiala: " << rollbackSeconds * 1e9 << " ns, reconstruire flow: " << buildSeconds * 1e3 << " ms" << endl;
+    cout << "Rezultate identice: " << (consistent ? "da" : "nu") << endl;
+    return consistent ? 0 : 1;
+}
+
+// Jurnalul modificărilor cu `count` înregistrări: scriere asincronă, scriere cu așteptarea fsync
+// de pe un fir și de pe mai multe fire (group commit), reluarea la pornire și compactarea în catalog
+int runJournalBenchmark(size_t count) {
+    const string catalogPath = "bench_journal.cat";
+    const string journalPath = catalogPath + ".journal";
+    const size_t created = std::max<size_t>(1, count / 10);
+    FlowJournal journal;
+    if (!journal.open(journalPath, 0, 0)) {
+        cerr << "Eroare la deschiderea jurnalului " << journalPath << endl;
+        return 1;
+    }
+
+    mt19937 generator(5);
+    auto setRecord = [&](mt19937 &random) {
+        return FlowJournal::encodeNumberInput(random() % created, 1, static_cast<float>(random() % 1000));
+    };
+
+    // Scriere asincronă: fsync-urile se suprapun cu adăugarea, se așteaptă doar ultima înregistrare
+    auto start = chrono::steady_clock::now();
+    uint64_t last = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i < created) {
+            Flow flow("jurnal_" + to_string(i));
+            flow.addStep(TitleStep("Titlu", "Subtitlu"));
+            flow.addStep(NumberInputStep("valoare"));
+            flow.addStep(EndStep());
+            last = journal.append(FlowJournal::RecordType::CreateFlow, FlowJournal::encodeFlow(flow));
+        } else {
+            last = journal.append(FlowJournal::RecordType::SetNumberInput, setRecord(generator));
+        }
+    }
+    bool written = journal.waitDurable(last);
+    double asyncSeconds = secondsSince(start);
+    uint64_t asyncSyncs = journal.getSyncCount();
+
+    // Un singur fir care așteaptă fiecare înregistrare: un fsync per modificare
+    const size_t sequential = std::min<size_t>(count, 1000);
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < sequential; ++i) {
+        written = journal.waitDurable(journal.append(FlowJournal::RecordType::SetNumberInput, setRecord(generator))) && written;
+    }
+    double sequentialSeconds = secondsSince(start);
+    uint64_t sequentialSyncs = journal.getSyncCount() - asyncSyncs;
+
+    // Mai multe fire care așteaptă fiecare înregistrare: fsync-urile sunt împărțite (group commit)
+    const size_t threads = 8;
+    const size_t perThread = std::max<size_t>(1, sequential / threads * 4);
+    atomic<bool> threadsWritten(true);
+    uint64_t syncsBefore = journal.getSyncCount();
+    start = chrono::steady_clock::now();
+    {
+        vector<thread> writers;
+        for (size_t t = 0; t < threads; ++t) {
+            writers.emplace_back([&, t]() {
+                mt19937 random(static_cast<uint32_t>(100 + t));
+                for (size_t i = 0; i < perThread; ++i) {
+                    if (!journal.waitDurable(journal.append(FlowJournal::RecordType::SetNumberInput, setRecord(random)))) {
+                        threadsWritten = false;
+                    }
+                }
+            });
+        }
+        for (thread &writer : writers) {
+            writer.join();
+        }
+    }
+    double concurrentSeconds = secondsSince(start);
+    uint64_t concurrentSyncs = journal.getSyncCount() - syncsBefore;
+    uint64_t journalBytes = journal.size();
+    journal.close();
+    size_t total = count + sequential + threads * perThread;
+
+    // Reluarea jurnalului peste un catalog gol, ca la pornire
+    FlowCatalog catalog;
+    FlowRegistry flows;
+    JournalFlowIds ids;
+    ids.reset(0);
+    NullBuffer nullBuffer;
+    ostream discard(&nullBuffer);
+    FlowJournal::ReplayStats replayed = FlowJournal::replay(journalPath, 0, [&](FlowJournal::RecordType type, BinaryReader &in, uint32_t version) {
+        applyJournalRecord(type, in, version, catalog, flows, ids, discard);
+    });
+
+    start = chrono::steady_clock::now();
+    uint32_t generation = catalog.save(catalogPath, flows);
+    bool compacted = journal.open(journalPath, generation, 0);
+    double compactSeconds = secondsSince(start);
+    journal.close();
+
+    cout << "Benchmark jurnal: " << total << " inregistrari, " << journalBytes / 1024 << " KB" << endl;
+    cout << "Scriere asincrona: " << count / asyncSeconds << " inregistrari/s, " << asyncSyncs << " fsync-uri" << endl;
+    cout << "Scriere cu asteptare, 1 fir: " << sequential / sequentialSeconds << " inregistrari/s, "
+         << static_cast<double>(sequential) / std::max<uint64_t>(sequentialSyncs, 1) << " inregistrari/fsync" << endl;
+    cout << "Scriere cu asteptare, " << threads << " fire: " << threads * perThread / concurrentSeconds << " inregistrari/s, "
+         << static_cast<double>(threads * perThread) / std::max<uint64_t>(concurrentSyncs, 1) << " inregistrari/fsync" << endl;
+    cout << "Reluare: " << replayed.records << " inregistrari in " << replayed.seconds * 1e3 << " ms ("
+         << replayed.records / replayed.seconds << " inregistrari/s), " << flows.size() << " flow-uri" << endl;
+    cout << "Compactare in catalog: " << compactSeconds * 1e3 << " ms" << endl;
+
+    catalog.close();
+    remove(catalogPath.c_str());
+    remove(journalPath.c_str());
+    bool consistent = written && threadsWritten && compacted && replayed.records == total && replayed.failed == 0 &&
+                      !replayed.tornTail && flows.size() == created;
+    cout << "Rezultate corecte: " << (consistent ? "da" : "nu") << endl;
+    return consistent ? 0 : 1;
+}
+
+// Crearea fișierelor pentru `count` pași TextFileInput și `count` pași CSVFileInput, ca la
+// construirea flow-urilor în masă: scrierea sincronă pe firul apelant (ofstream, ca înainte)
+// față de AsyncFileWriter, cu timpul firului apelant și timpul până la scrierea tuturor fișierelor
+int runFileCreationBenchmark(size_t count) {
+    vector<TextFileInputStep> textSteps;
+    vector<CSVFileInputStep> csvSteps;
+    textSteps.reserve(count);
+    csvSteps.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        textSteps.emplace_back("bench_file_" + to_string(i));
+        textSteps.back().setDescription("Descriere " + to_string(i));
+        csvSteps.emplace_back("bench_file_" + to_string(i) + "_date");
+        csvSteps.back().setDescription("Coloane " + to_string(i));
+    }
+    auto removeFiles = [&]() {
+        for (size_t i = 0; i < count; ++i) {
+            remove((textSteps[i].getFileName() + ".txt").c_str());
+            remove((csvSteps[i].getFileName() + ".csv").c_str());
+        }
+    };
+    removeFiles();
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        ofstream text(textSteps[i].getFileName() + ".txt");
+        text << textSteps[i].getDescription() << endl;
+        ofstream csv(csvSteps[i].getFileName() + ".csv");
+        csv << "Descriere: " << csvSteps[i].getDescription() << endl;
+    }
+    double syncSeconds = secondsSince(start);
+    removeFiles();
+
+    NullBuffer nullBuffer;
+    streambuf *consoleBuffer = cout.rdbuf(&nullBuffer);  // Mesajele pașilor nu sunt afișate
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        textSteps[i].createFile();
+        csvSteps[i].createFile();
+    }
+    double submitSeconds = secondsSince(start);
+    fileWriter().flush();
+    double asyncSeconds = secondsSince(start);
+    cout.rdbuf(consoleBuffer);
+
+    // Fiecare pas își vede fișierul scris, cu conținutul complet
+    bool consistent = true;
+    for (size_t i = 0; i < count; ++i) {
+        consistent = consistent && textSteps[i].waitForFile() && csvSteps[i].waitForFile();
+        if (consistent && i % 97 == 0) {
+            string line;
+            ifstream text(textSteps[i].getFileName() + ".txt");
+            consistent = getline(text, line) && line == textSteps[i].getDescription();
+        }
+    }
+    removeFiles();
+
+    size_t files = 2 * count;
+    cout << "Benchmark creare fisiere: " << files << " fisiere, " << fileWriter().threadCount() << " fire de scriere" << endl;
+    cout << "Sincron (ofstream): " << files / syncSeconds << " fisiere/s" << endl;
+    cout << "AsyncFileWriter: " << files / asyncSeconds << " fisiere/s (firul apelant: "
+         << submitSeconds * 1e9 / files << " ns/fisier)" << endl;
+    cout << "Accelerare: " << syncSeconds / asyncSeconds << "x" << endl;
+    cout << "Rezultate corecte: " << (consistent ? "da" : "nu") << endl;
+    return consistent ? 0 : 1;
+}
+
+// O operație din CalculusStep: bucla inițială și implementarea cu un set de nuclee
+struct CalculusBenchmarkCase {
+    const char *operation;
+    float (*original)(const vector<float> &inputs);
+    float (*kernel)(const CalculusKernels &kernels, const vector<float> &inputs);
+};
+
+// Compară fiecare nucleu disponibil (scalar, SSE2, AVX2) cu buclele inițiale din CalculusStep
+// pe `count` valori, apoi compară precizia sumei în modurile float, double și Kahan.
+int runCalculusBenchmark(size_t count) {
+    if (count < 2) {
+        cerr << "Benchmark-ul necesita cel putin doua valori." << endl;
+        return 1;
+    }
+    vector<float> values(count);
+    mt19937 generator(7);
+    uniform_real_distribution<float> distribution(0.999f, 1.001f);
+    for (float &value : values) {
+        value = distribution(generator);
+    }
+
+    const CalculusBenchmarkCase cases[] = {
+        {"+",
+         [](const vector<float> &inputs) {
+             float result = 0;
+             for (float value : inputs) {
+                 result += value;
+             }
+             return result;
+         },
+         [](const CalculusKernels &kernels, const vector<float> &inputs) {
+             return kernels.sumFloat(inputs.data(), inputs.size());
+         }},
+        {"-",
+         [](const vector<float> &inputs) {
+             float result = inputs[0];
+             for (size_t i = 1; i < inputs.size(); ++i) {
+                 result -= inputs[i];
+             }
+             return result;
+         },
+         [](const CalculusKernels &kernels, const vector<float> &inputs) {
+             return static_cast<float>(inputs[0] - kernels.sumDouble(inputs.data() + 1, inputs.size() - 1));
+         }},
+        {"*",
+         [](const vector<float> &inputs) {
+             float result = 1;
+             for (float value : inputs) {
+                 result *= value;
+             }
+             return result;
+         },
+         [](const CalculusKernels &kernels, const vector<float> &inputs) {
+             return kernels.productFloat(inputs.data(), inputs.size());
+         }},
+        {"/",
+         [](const vector<float> &inputs) {
+             float result = inputs[0];
+             for (size_t i = 1; i < inputs.size(); ++i) {
+                 if (inputs[i] == 0) {
+                     return 0.0f;
+                 }
+                 result /= inputs[i];
+             }
+             return result;
+         },
+         [](const CalculusKernels &kernels, const vector<float> &inputs) {
+             if (kernels.containsZero(inputs.data() + 1, inputs.size() - 1)) {
+                 return 0.0f;
+             }
+             return static_cast<float>(inputs[0] / kernels.productDouble(inputs.data() + 1, inputs.size() - 1));
+         }},
+        {"min",
+         [](const vector<float> &inputs) {
+             float result = inputs[0];
+             for (size_t i = 1; i < inputs.size(); ++i) {
+                 result = std::min(result, inputs[i]);
+             }
+             return result;
+         },
+         [](const CalculusKernels &kernels, const vector<float> &inputs) {
+             return kernels.minimum(inputs.data(), inputs.size());
+         }},
+        {"max",
+         [](const vector<float> &inputs) {
+             float result = inputs[0];
+             for (size_t i = 1; i < inputs.size(); ++i) {
+                 result = std::max(result, inputs[i]);
+             }
+             return result;
+         },
+         [](const CalculusKernels &kernels, const vector<float> &inputs) {
+             return kernels.maximum(inputs.data(), inputs.size());
+         }},
+    };
+
+    vector<const CalculusKernels *> kernelSets = availableCalculusKernels();
+    const int repetitions = 5;
+    volatile float sink = 0;
+
+    cout << "Benchmark CalculusStep: " << count << " valori, nuclee active: " << calculusKernels().name << endl;
+    cout << "Throughput in milioane de valori/s (cel mai bun din " << repetitions << " rulari)" << endl;
+    cout << left << setw(10) << "operatie" << setw(16) << "bucla initiala";
+    for (const CalculusKernels *kernels : kernelSets) {
+        cout << setw(12) << kernels->name;
+    }
+    cout << endl;
+
+    double millions = static_cast<double>(count) / 1e6;
+    for (const CalculusBenchmarkCase &benchmarkCase : cases) {
+        double original = bestOfSeconds(repetitions, [&]() { sink = benchmarkCase.original(values); });
+        cout << setw(10) << benchmarkCase.operation << setw(16) << millions / original;
+        for (const CalculusKernels *kernels : kernelSets) {
+            double seconds = bestOfSeconds(repetitions, [&]() { sink = benchmarkCase.kernel(*kernels, values); });
+            cout << setw(12) << millions / seconds;
+        }
+        cout << endl;
+    }
+
+    long double reference = 0;
+    for (float value : values) {
+        reference += value;
+    }
+    const CalculusKernels &kernels = calculusKernels();
+    cout << "\nPrecizia sumei (referinta long double: " << setprecision(12) << static_cast<double>(reference) << ")" << endl;
+    cout << "float:  eroare " << fabs(static_cast<double>(kernels.sumFloat(values.data(), count) - reference)) << endl;
+    cout << "double: eroare " << fabs(static_cast<double>(kernels.sumDouble(values.data(), count) - reference)) << endl;
+    cout << "kahan:  eroare " << fabs(static_cast<double>(kernels.sumKahan(values.data(), count) - reference)) << endl;
+    cout << "bucla initiala (float): eroare " << fabs(static_cast<double>(cases[0].original(values) - reference)) << endl;
+
+    // Cazuri în care suma sau produsul în float al valorilor de după prima ar da alt rezultat
+    // decât evaluarea de la stânga la dreapta; verificate în toate modurile de acumulare
+    struct EdgeCase {
+        const char *operation;
+        vector<float> inputs;
+        float expected;
+    };
+    const EdgeCase edgeCases[] = {
+        {"/", {1e30f, 1e20f, 1e20f}, 1e-10f},
+        {"-", {1e8f, 1e8f, 1, 1}, -2},
+    };
+    NullBuffer nullBuffer;
+    ostream discard(&nullBuffer);
+    bool edgeCasesMatch = true;
+    for (const EdgeCase &edgeCase : edgeCases) {
+        for (AccumulationMode mode : {AccumulationMode::Float, AccumulationMode::Double, AccumulationMode::Kahan}) {
+            CalculusStep step(0);
+            step.setOperation(edgeCase.operation);
+            step.setInputs(edgeCase.inputs);
+            step.setAccumulationMode(mode);
+            float result = step.performCalculation(discard);
+            if (!(fabs(result - edgeCase.expected) <= 1e-5f * fabs(edgeCase.expected))) {
+                cout << "Calculus " << edgeCase.operation << " (" << accumulationModeName(mode) << "): " << result
+                     << " in loc de " << edgeCase.expected << endl;
+                edgeCasesMatch = false;
+            }
+        }
+    }
+    cout << "Cazuri limita pentru scadere si impartire: " << (edgeCasesMatch ? "corecte" : "gresite") << endl;
+    return edgeCasesMatch ? 0 : 1;
+}
+
+// Generează un CSV cu `rows` rânduri (id, valoare, text între ghilimele) și măsoară
+// indexarea cu CsvTable și parcurgerea numerică a unei coloane
+int runCsvBenchmark(size_t rows) {
+    const string path = "bench_data.csv";
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            cerr << "Eroare la crearea fisierului " << path << endl;
+            return 1;
+        }
+        mt19937 generator(11);
+        uniform_real_distribution<double> distribution(0, 1000);
+        string buffer = "id,valoare,text\n";
+        for (size_t i = 0; i < rows; ++i) {
+            buffer += to_string(i);
+            buffer += ',';
+            buffer += to_string(distribution(generator));
+            buffer += ",\"text, cu separator\"\n";
+            if (buffer.size() > (1 << 20)) {
+                out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    }
+
+    CsvTable table;
+    auto start = chrono::steady_clock::now();
+    if (!table.open(path)) {
+        cerr << "Eroare la citirea fisierului " << path << endl;
+        return 1;
+    }
+    double indexSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    double sum = 0;
+    size_t skipped = table.forEachNumber(static_cast<size_t>(table.findColumn("valoare")), 0, table.rowCount(),
+                                         [&](size_t, double value) { sum += value; });
+    double columnSeconds = secondsSince(start);
+
+    double megabytes = static_cast<double>(table.byteSize()) / (1 << 20);
+    cout << "Benchmark CSV: " << table.rowCount() << " randuri, " << megabytes << " MB (campuri sarite: " << skipped << ")" << endl;
+    cout << "Indexare randuri: " << megabytes / indexSeconds << " MB/s" << endl;
+    cout << "Suma coloanei 'valoare': " << sum << " (" << megabytes / columnSeconds << " MB/s)" << endl;
+
+    // Agregarea pe bucăți de rânduri cu 1, 2, 4, ... fire, până la numărul de nuclee
+    size_t column = static_cast<size_t>(table.findColumn("valoare"));
+    size_t maxThreads = std::max(1u, thread::hardware_concurrency());
+    bool consistent = true;
+    for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        ThreadPool pool(threads);
+        start = chrono::steady_clock::now();
+        ColumnAggregate aggregate = table.aggregateColumn(column, pool);
+        double aggregateSeconds = secondsSince(start);
+        cout << "Agregare paralela, " << threads << " fire: " << megabytes / aggregateSeconds << " MB/s (suma "
+             << aggregate.sum() << ", medie " << aggregate.sum() / aggregate.count << ")" << endl;
+        consistent = consistent && aggregate.count == table.rowCount() && fabs(aggregate.sum() - sum) <= 1e-6 * fabs(sum);
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+    remove(path.c_str());
+    return rows == table.rowCount() && skipped == 0 && consistent ? 0 : 1;
+}
+
+// Generează un log text de `megabytes` MB și îl analizează ca TextFileInputStep: citirea linie cu
+// linie cu getline (varianta simplă), apoi analyzeText pe fișierul mapat, fără model, cu un text
+// simplu și cu o expresie regulată, pe pool-uri de 1, 2, 4, ... fire, până la numărul de nuclee
+int runTextBenchmark(size_t megabytes) {
+    const string path = "bench_log.txt";
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            cerr << "Eroare la crearea fisierului " << path << endl;
+            return 1;
+        }
+        static const char *const levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+        static const char *const actions[] = {"request served", "cache miss for key", "retrying connection to", "user logged in from"};
+        mt19937 generator(13);
+        string buffer;
+        size_t written = 0;
+        for (size_t line = 0; written < megabytes << 20; ++line) {
+            buffer += "2024-03-01 12:" + to_string(line / 60 % 60) + ":" + to_string(line % 60) + " ";
+            buffer += levels[generator() % 6];
+            buffer += " worker-" + to_string(generator() % 32) + " ";
+            buffer += actions[generator() % 4];
+            buffer += " " + to_string(generator() % 100000) + "\n";
+            if (buffer.size() > (1 << 20)) {
+                out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+                written += buffer.size();
+                buffer.clear();
+            }
+        }
+        out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    }
+
+    // Varianta simplă: getline și un tabel de frecvențe cu chei string, pe un singur fir
+    auto start = chrono::steady_clock::now();
+    uint64_t lines = 0, words = 0;
+    {
+        ifstream in(path, ios::binary);
+        unordered_map<string, uint64_t> frequencies;
+        string line, word;
+        while (getline(in, line)) {
+            lines++;
+            istringstream fields(line);
+            while (fields >> word) {
+                words++;
+                frequencies[word]++;
+            }
+        }
+    }
+    double streamSeconds = secondsSince(start);
+
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "Eroare la citirea fisierului " << path << endl;
+        return 1;
+    }
+    double size = static_cast<double>(file.getSize()) / (1 << 20);
+    cout << "Benchmark text: " << lines << " linii, " << words << " cuvinte, " << size << " MB" << endl;
+    cout << "getline + istringstream, 1 fir: " << size / streamSeconds << " MB/s" << endl;
+
+    const pair<const char *, string> patterns[] = {{"fara model", ""}, {"text simplu", "ERROR"}, {"expresie regulata", "^\\S+ \\S+ (WARN|ERROR)"}};
+    size_t maxThreads = std::max(1u, thread::hardware_concurrency());
+    bool consistent = true;
+    for (const auto &pattern : patterns) {
+        for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+            ThreadPool pool(threads);
+            start = chrono::steady_clock::now();
+            TextStatistics statistics = analyzeText(file.getData(), file.getSize(), pattern.second, pool);
+            double seconds = secondsSince(start);
+            cout << "analyzeText (" << pattern.first << "), " << threads << " fire: " << size / seconds << " MB/s ("
+                 << statistics.uniqueWords << " cuvinte distincte, " << statistics.matchingLines << " linii potrivite)" << endl;
+            consistent = consistent && statistics.lines == lines && statistics.words == words;
+            if (threads == maxThreads) {
+                break;
+            }
+        }
+    }
+    file.close();
+    remove(path.c_str());
+    cout << "Rezultate identice: " << (consistent ? "da" : "nu") << endl;
+    return consistent ? 0 : 1;
+}
+
+// Rulează `count` flow-uri independente (câte 32 de pași) cu runFlowsParallel, pe pool-uri de
+// 1, 2, 4, ... fire, până la numărul de nuclee. Output-ul este construit, dar nu afișat.
+int runParallelBenchmark(size_t count) {
+    FlowRegistry registry;
+    registry.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        Flow flow("flow " + to_string(i));
+        flow.reserveSteps(32);
+        generateBenchmarkSteps(31, [&](auto &&step) { flow.addStep(move(step)); });
+        flow.addStep(EndStep());
+        registry.insert(move(flow));
+    }
+    vector<const Flow *> flows;
+    for (const Flow &flow : registry) {
+        flows.push_back(&flow);
+    }
+
+    NullBuffer nullBuffer;
+    ostream discard(&nullBuffer);
+    size_t maxThreads = std::max(1u, thread::hardware_concurrency());
+    double baseline = 0;
+    cout << "Benchmark rulare paralela: " << count << " flow-uri x 32 pasi" << endl;
+    for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        ThreadPool pool(threads);
+        auto start = chrono::steady_clock::now();
+        runFlowsParallel(flows, pool, discard);
+        double seconds = secondsSince(start);
+        double flowsPerSecond = static_cast<double>(count) / seconds;
+        if (threads == 1) {
+            baseline = flowsPerSecond;
+        }
+        cout << threads << " fire: " << flowsPerSecond << " flow-uri/s (x" << flowsPerSecond / baseline << ")" << endl;
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+    return 0;
+}
+
+// Un flow cu `files` fișiere CSV independente, câte un Calculus pe fiecare și un raport final:
+// compară execuția secvențială cu cea pe graful de dependențe (lanțul critic are 3 pași).
+int runDagBenchmark(size_t files) {
+    const size_t rows = 200000;
+    string reportTemplate;
+    for (size_t f = 0; f < files; ++f) {
+        ofstream csv("bench_dag_" + to_string(f) + ".csv", ios::binary | ios::trunc);
+        string buffer = "id,valoare\n";
+        for (size_t r = 0; r < rows; ++r) {
+            buffer += to_string(r);
+            buffer += ',';
+            buffer += to_string((r * 7919 + f) % 1000);
+            buffer += '\n';
+        }
+        csv.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        reportTemplate += "Fisier " + to_string(f) + ": {{step" + to_string(2 * f + 2) + ".result}}\n";
+    }
+    {
+        ofstream templateFile("bench_dag.tpl", ios::binary | ios::trunc);
+        templateFile << reportTemplate;
+    }
+
+    auto buildFlow = [&]() {
+        Flow flow("dag");
+        for (size_t f = 0; f < files; ++f) {
+            flow.addStep(CSVFileInputStep("bench_dag_" + to_string(f)));
+            CalculusStep calculus(0);
+            calculus.setOperation("mean");
+            calculus.setColumnSource(2 * f + 1, "valoare");
+            flow.addStep(move(calculus));
+        }
+        OutputStep output("bench_dag_raport", 0, "Raport");
+        output.setTemplateFile("bench_dag.tpl");
+        flow.addStep(move(output));
+        flow.addStep(EndStep());
+        return flow;
+    };
+
+    NullBuffer nullBuffer;
+    ostream discard(&nullBuffer);
+    Flow sequential = buildFlow();
+    auto start = chrono::steady_clock::now();
+    sequential.execute(discard);
+    fileWriter().flush();
+    double sequentialSeconds = secondsSince(start);
+
+    Flow parallel = buildFlow();
+    ThreadPool &pool = sharedThreadPool();
+    start = chrono::steady_clock::now();
+    parallel.execute(discard, &pool);
+    fileWriter().flush();
+    double parallelSeconds = secondsSince(start);
+
+    StepGraph graph(parallel.getSteps());
+    cout << "Benchmark graf de dependente: " << parallel.getSteps().size() << " pasi, lant critic " << graph.criticalPath
+         << " pasi, " << files << " fisiere CSV x " << rows << " randuri" << endl;
+    cout << "Secvential: " << sequentialSeconds * 1000 << " ms" << endl;
+    cout << "Paralel (" << pool.size() << " fire): " << parallelSeconds * 1000 << " ms (x" << sequentialSeconds / parallelSeconds << ")" << endl;
+
+    for (size_t f = 0; f < files; ++f) {
+        remove(("bench_dag_" + to_string(f) + ".csv").c_str());
+    }
+    remove("bench_dag.tpl");
+    remove("bench_dag_raport.txt");
+    return 0;
+}
+
+// Un flow cu `count` pași în grupuri de câte 4 (două NumberInput, un Calculus pe ele și un
+// Calculus pe rezultatul primului): compară execuția completă cu modificarea unei singure intrări.
+int runIncrementalBenchmark(size_t count) {
+    Flow flow("incremental");
+    size_t groups = std::max<size_t>(count / 4, 1);
+    flow.reserveSteps(groups * 4);
+    for (size_t g = 0; g < groups; ++g) {
+        size_t first = g * 4 + 1;
+        NumberInputStep a("a");
+        a.setInput(static_cast<float>(g));
+        flow.addStep(move(a));
+        NumberInputStep b("b");
+        b.setInput(2);
+        flow.addStep(move(b));
+        CalculusStep sum(0);
+        sum.setOperation("+");
+        sum.setInputSteps({first, first + 1});
+        flow.addStep(move(sum));
+        CalculusStep product(0);
+        product.setOperation("*");
+        product.setInputSteps({first + 2, first});
+        flow.addStep(move(product));
+    }
+
+    NullBuffer nullBuffer;
+    ostream discard(&nullBuffer);
+    auto start = chrono::steady_clock::now();
+    flow.execute(discard);
+    double fullSeconds = secondsSince(start);
+
+    // Prima editare construiește graful de citiri; este măsurată separat
+    start = chrono::steady_clock::now();
+    flow.setNumberInput(0, 0, discard);
+    double firstEditSeconds = secondsSince(start);
+
+    const size_t edits = 1000;
+    size_t recomputed = 0;
+    mt19937 generator(5);
+    start = chrono::steady_clock::now();
+    for (size_t e = 0; e < edits; ++e) {
+        size_t group = generator() % groups;
+        recomputed += flow.setNumberInput(group * 4, static_cast<float>(e), discard);
+    }
+    double editSeconds = secondsSince(start) / edits;
+
+    size_t check = (groups - 1) * 4;
+    double input = flow.getSteps().as<NumberInputStep>(check).getNumberInput();
+    double expected = (input + 2) * input;
+    bool correct = flow.calculusResult(check + 3) == expected;
+
+    cout << "Benchmark recalculare incrementala: " << flow.getSteps().size() << " pasi" << endl;
+    cout << "Executie completa: " << fullSeconds * 1e6 << " us" << endl;
+    cout << "Prima modificare (cu construirea grafului): " << firstEditSeconds * 1e6 << " us" << endl;
+    cout << "Modificarea unei intrari: " << editSeconds * 1e6 << " us (" << static_cast<double>(recomputed) / edits
+         << " pasi recalculati in medie), x" << fullSeconds / editSeconds << endl;
+    return correct ? 0 : 1;
+}
+
+// Un flow cu `count` pași (NumberInput, TextInput cu 16 texte distincte și Calculus pe doi pași
+// numerici anteriori aleși aleator): compară citirea valorilor tuturor pașilor prin obiectele
+// pașilor cu citirea din tabelul de valori al flow-ului și raportează textele internate.
+int runValueTableBenchmark(size_t count) {
+    Flow flow("valori");
+    flow.reserveSteps(count);
+    mt19937 generator(11);
+    vector<size_t> numericSteps;
+    size_t textBytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t choice = generator() % 4;
+        if (choice == 0 || numericSteps.size() < 2) {
+            NumberInputStep step("n");
+            step.setInput(static_cast<float>(generator() % 1000));
+            flow.addStep(move(step));
+            numericSteps.push_back(i + 1);
+        } else if (choice == 1) {
+            TextInputStep step("t");
+            step.setInput("valoare text " + to_string(generator() % 16));
+            textBytes += step.getTextInput().size();
+            flow.addStep(move(step));
+        } else {
+            CalculusStep step(0);
+            step.setOperation(generator() % 2 == 0 ? "+" : "max");
+            step.setInputSteps({numericSteps[generator() % numericSteps.size()], numericSteps[generator() % numericSteps.size()]});
+            flow.addStep(move(step));
+            numericSteps.push_back(i + 1);
+        }
+    }
+
+    NullBuffer nullBuffer;
+    ostream discard(&nullBuffer);
+    auto start = chrono::steady_clock::now();
+    flow.recalculate(discard);
+    double recalculateSeconds = secondsSince(start);
+
+    const StepStore &steps = flow.getSteps();
+    const FlowValues &values = steps.getValues();
+    const size_t rounds = 20;
+    double stepSum = 0;
+    start = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < steps.size(); ++i) {
+            if (steps.kind(i) == StepKind::NumberInput) {
+                stepSum += steps.as<NumberInputStep>(i).getNumberInput();
+            } else if (steps.kind(i) == StepKind::Calculus) {
+                stepSum += flow.calculusResult(i, discard);
+            }
+        }
+    }
+    double stepSeconds = secondsSince(start);
+
+    double tableSum = 0;
+    start = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (values.kind(i) == ValueKind::Number) {
+                tableSum += values.number(i);
+            }
+        }
+    }
+    double tableSeconds = secondsSince(start);
+
+    double reads = static_cast<double>(rounds * steps.size());
+    cout << "Benchmark tabel de valori: " << steps.size() << " pasi, " << numericSteps.size() << " valori numerice" << endl;
+    cout << "Recalculare completa: " << recalculateSeconds * 1e9 / steps.size() << " ns/pas" << endl;
+    cout << "Citire prin pasi: " << stepSeconds * 1e9 / reads << " ns/pas" << endl;
+    cout << "Citire din tabel: " << tableSeconds * 1e9 / reads << " ns/pas, x" << stepSeconds / tableSeconds << endl;
+    cout << "Texte internate: " << values.distinctTexts() << " distincte (" << textBytes << " octeti in pasi)" << endl;
+    cout << "Rezultate identice: " << (stepSum == tableSum ? "da" : "nu") << endl;
+    return stepSum == tableSum ? 0 : 1;
+}
+
+// Serializarea a `count` pași: writeToFile în memorie, într-un fișier și într-o zonă fixă (MB/s),
+// apoi drumul dus-întors prin formatul de definiție și prin formatul binar. Fiecare format este
+// citit înapoi și rescris; rezultatul trebuie să fie identic cu primul.
+int runSerializationBenchmark(size_t count) {
+    vector<StepValue> steps;
+    steps.reserve(count);
+    generateBenchmarkSteps(count, [&](auto &&step) {
+        steps.emplace_back(move(step));
+    });
+    auto stepAt = [&](const vector<StepValue> &values, size_t i) -> const Step & {
+        return visit([](const Step &step) -> const Step & { return step; }, values[i]);
+    };
+    auto kindAt = [](const vector<StepValue> &values, size_t i) {
+        return static_cast<StepKind>(values[i].index());
+    };
+    auto megabytesPerSecond = [](size_t bytes, double seconds) {
+        return static_cast<double>(bytes) / 1e6 / seconds;
+    };
+
+    string text;
+    auto start = chrono::steady_clock::now();
+    {
+        StringSink sink(text);
+        TextWriter writer(sink);
+        for (size_t i = 0; i < steps.size(); ++i) {
+            stepAt(steps, i).writeToFile(writer);
+        }
+    }
+    double stringSeconds = secondsSince(start);
+
+    const string path = "bench_serializare.txt";
+    start = chrono::steady_clock::now();
+    bool fileWritten;
+    {
+        FileSink sink(path);
         {
-            this->title = t;
-            this->copy = c;
+            TextWriter writer(sink);
+            for (size_t i = 0; i < steps.size(); ++i) {
+                stepAt(steps, i).writeToFile(writer);
+            }
         }
-        string getStepName() override
-        {
-            return "Text step";
+        fileWritten = sink.close();
+    }
+    double fileSeconds = secondsSince(start);
+    remove(path.c_str());
+
+    vector<char> region(text.size());
+    start = chrono::steady_clock::now();
+    MemorySink memory(region.data(), region.size());
+    {
+        TextWriter writer(memory);
+        for (size_t i = 0; i < steps.size(); ++i) {
+            stepAt(steps, i).writeToFile(writer);
         }
-        void getStepInfo() override
-        {
-            cout << "Titlu: " << title << endl;
-            cout << "Copie: " << copy << endl;
+    }
+    double memorySeconds = secondsSince(start);
+    bool sameText = fileWritten && !memory.overflowed() && memory.size() == text.size() && memcmp(region.data(), text.data(), text.size()) == 0;
+
+    auto writeDefinitions = [&](const vector<StepValue> &values) {
+        string definitions;
+        StringSink sink(definitions);
+        TextWriter writer(sink);
+        for (size_t i = 0; i < values.size(); ++i) {
+            writeStepDefinition(writer, kindAt(values, i), stepAt(values, i));
         }
-        void writeToFile(ofstream &file) const
-        {
-            file << "TextStep" << endl;
-            file << "Title: " << title << endl;
-            file << "Copie: " << copy << endl;
+        writer.flush();
+        return definitions;
+    };
+    start = chrono::steady_clock::now();
+    string definitions = writeDefinitions(steps);
+    double definitionWriteSeconds = secondsSince(start);
+
+    vector<StepValue> parsed;
+    parsed.reserve(count);
+    start = chrono::steady_clock::now();
+    {
+        vector<string_view> fields;
+        string_view remaining = definitions;
+        while (!remaining.empty()) {
+            size_t end = remaining.find('\n');
+            parsed.push_back(parseStepDefinition(remaining.substr(0, end), fields));
+            remaining.remove_prefix(end == string_view::npos ? remaining.size() : end + 1);
         }
-};
+    }
+    double definitionParseSeconds = secondsSince(start);
+    bool sameDefinitions = parsed.size() == steps.size() && writeDefinitions(parsed) == definitions;
 
-class TextInputStep : public Step {
-private:
-    string description;
-    bool hasUserInput;  // Indică dacă input-ul a fost deja introdus
-    string text_input;  // Input-ul specific pasului, setat ulterior
+    auto writeBinary = [&](const vector<StepValue> &values) {
+        string encoded;
+        BinaryWriter out(encoded);
+        for (size_t i = 0; i < values.size(); ++i) {
+            out.write<uint8_t>(static_cast<uint8_t>(kindAt(values, i)));
+            stepAt(values, i).writeBinary(out);
+        }
+        return encoded;
+    };
+    start = chrono::steady_clock::now();
+    string encoded = writeBinary(steps);
+    double binaryWriteSeconds = secondsSince(start);
 
-public:
-    TextInputStep(const string &d) {
-        this->description = d;
-        this->hasUserInput = false;
+    vector<StepValue> decoded;
+    decoded.reserve(count);
+    start = chrono::steady_clock::now();
+    {
+        BinaryReader in(encoded.data(), encoded.size());
+        for (size_t i = 0; i < steps.size(); ++i) {
+            decoded.push_back(readStepBinary(in, FlowCatalog::formatVersion));
+        }
     }
+    double binaryReadSeconds = secondsSince(start);
+    bool sameBinary = writeBinary(decoded) == encoded;
+
+    cout << "Benchmark serializare: " << count << " pasi" << endl;
+    cout << "writeToFile in memorie (StringSink): " << megabytesPerSecond(text.size(), stringSeconds) << " MB/s, " << text.size() << " octeti" << endl;
+    cout << "writeToFile in fisier (FileSink):    " << megabytesPerSecond(text.size(), fileSeconds) << " MB/s" << endl;
+    cout << "writeToFile in zona fixa (MemorySink): " << megabytesPerSecond(text.size(), memorySeconds) << " MB/s" << endl;
+    cout << "Definitie text: scriere " << megabytesPerSecond(definitions.size(), definitionWriteSeconds) << " MB/s, citire "
+         << megabytesPerSecond(definitions.size(), definitionParseSeconds) << " MB/s, " << definitions.size() << " octeti" << endl;
+    cout << "Binar: scriere " << megabytesPerSecond(encoded.size(), binaryWriteSeconds) << " MB/s, citire "
+         << megabytesPerSecond(encoded.size(), binaryReadSeconds) << " MB/s, " << encoded.size() << " octeti" << endl;
+    bool identical = sameText && sameDefinitions && sameBinary;
+    cout << "Rezultate identice: " << (identical ? "da" : "nu") << endl;
+    return identical ? 0 : 1;
+}
 
-    string getStepName() override {
-        return "Text input step";
+// Aceeași expresie pe `rows` rânduri: cod scris de mână, evaluare rând cu rând a programului
+// compilat, evaluare pe blocuri și evaluare pe blocuri în paralel, pe pool-ul comun
+int runExpressionBenchmark(size_t rows) {
+    const string text = "(step1 + step2) / max(step3, 1) - abs(step1 * 0.5)";
+    CalculusExpression expression = CalculusExpression::compile(text);
+    vector<vector<float>> columns(expression.references().size(), vector<float>(rows));
+    mt19937 generator(13);
+    uniform_real_distribution<float> distribution(-100, 100);
+    for (vector<float> &column : columns) {
+        for (float &value : column) {
+            value = distribution(generator);
+        }
+    }
+    vector<const float *> columnData;
+    for (const vector<float> &column : columns) {
+        columnData.push_back(column.data());
     }
 
-    // Introduce descrierea pasului
-    void inputDescription() {
-        cout << "Introduceti descrierea: ";
-        cin.ignore();  // Ignorăm orice caracter rămas în buffer
-        getline(cin, description);
+    vector<float> expected(rows);
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < rows; ++r) {
+        double a = columns[0][r], b = columns[1][r], c = columns[2][r];
+        expected[r] = static_cast<float>((a + b) / std::max(c, 1.0) - fabs(a * 0.5));
     }
+    double nativeSeconds = secondsSince(start);
 
-    // Specifică input-ul pasului
-    void specifyInput() {
-        if (!hasUserInput) {
-            cout << "Introduceti input-ul pentru pasul '" << description << "': ";
-            cin.ignore();  // Ignorăm orice caracter rămas în buffer
-            getline(cin, text_input);
-            hasUserInput = true;
+    vector<float> scalar(rows);
+    vector<float> rowValues(columns.size());
+    bool divisionByZero = false;
+    start = chrono::steady_clock::now();
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            rowValues[i] = columns[i][r];
         }
+        scalar[r] = expression.evaluate(rowValues.data(), divisionByZero);
     }
+    double scalarSeconds = secondsSince(start);
 
-    string getTextInput() const {
-        return text_input;
+    vector<float> batch(rows);
+    start = chrono::steady_clock::now();
+    expression.evaluateBatch(columnData.data(), rows, batch.data());
+    double batchSeconds = secondsSince(start);
+
+    // Bucăți de rânduri evaluate independent; fiecare bucată are propriile pointeri în coloane
+    vector<float> parallel(rows);
+    const size_t chunkRows = 1 << 16;
+    size_t chunks = (rows + chunkRows - 1) / chunkRows;
+    start = chrono::steady_clock::now();
+    sharedThreadPool().parallelFor(chunks, [&](size_t chunk) {
+        size_t begin = chunk * chunkRows;
+        vector<const float *> chunkColumns(columnData.size());
+        for (size_t i = 0; i < columnData.size(); ++i) {
+            chunkColumns[i] = columnData[i] + begin;
+        }
+        expression.evaluateBatch(chunkColumns.data(), std::min(chunkRows, rows - begin), parallel.data() + begin);
+    });
+    double parallelSeconds = secondsSince(start);
+
+    bool consistent = scalar == expected && batch == expected && parallel == expected;
+    double millions = static_cast<double>(rows) / 1e6;
+    cout << "Benchmark expresie: " << text << ", " << rows << " randuri, " << expression.instructions().size()
+         << " instructiuni" << endl;
+    cout << "Cod scris de mana: " << millions / nativeSeconds << " M randuri/s" << endl;
+    cout << "Rand cu rand: " << millions / scalarSeconds << " M randuri/s" << endl;
+    cout << "Pe blocuri: " << millions / batchSeconds << " M randuri/s" << endl;
+    cout << "Pe blocuri, " << sharedThreadPool().size() << " fire: " << millions / parallelSeconds << " M randuri/s" << endl;
+    cout << "Rezultate identice: " << (consistent ? "da" : "nu") << endl;
+    return consistent ? 0 : 1;
+}
+
+// Parametrii suitei de benchmark-uri (tema --bench-suite)
+struct BenchmarkSuiteOptions {
+    size_t steps = 10000;         // Pașii flow-ului sintetic
+    size_t repeat = 15;           // Eșantioane măsurate pentru fiecare benchmark
+    size_t values = 4096;         // Valorile unui CalculusStep
+    size_t textBytes = 4 << 20;   // Dimensiunea fișierului text generat
+    size_t csvRows = 200000;      // Rândurile fișierului CSV generat
+    double mix[stepKindCount] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 0};  // Ponderile tipurilor de pași; End nu este generat
+    uint32_t seed = 42;
+    string format = "csv";        // csv sau json
+    string output;                // Fișierul rezultatelor; gol = consola
+    string filter;                // Rulează doar benchmark-urile al căror nume conține textul
+};
+
+// Ponderile tipurilor de pași, ex. "Title=1,Calculus=4,Output=0.5"; numele sunt cele din modul batch,
+// iar tipurile care nu apar primesc ponderea 0
+void parseStepMix(const string &spec, double *mix) {
+    fill(mix, mix + stepKindCount, 0.0);
+    istringstream entries(spec);
+    string entry;
+    while (getline(entries, entry, ',')) {
+        size_t separator = entry.find('=');
+        double weight = separator == string::npos ? 1 : stod(entry.substr(separator + 1));
+        StepKind kind;
+        if (!parseStepKindKeyword(trim(entry.substr(0, separator)), kind) || kind == StepKind::End || weight < 0) {
+            throw runtime_error("Tip de pas sau pondere invalida in --mix: " + entry);
+        }
+        mix[static_cast<size_t>(kind)] = weight;
+    }
+    if (accumulate(mix, mix + stepKindCount, 0.0) <= 0) {
+        throw runtime_error("--mix trebuie sa aiba cel putin o pondere pozitiva.");
     }
+}
 
-    void getStepInfo() override {
-        cout << "Descriere: " << description << endl;
-        if (hasUserInput) {
-            cout << "Input :" << text_input << endl;
+// Generează `count` pași cu tipurile alese aleator după ponderile din `mix` și îi trimite către `sink`.
+// Referințele indică mereu pași anteriori de tipul potrivit: Calculus citește doi pași NumberInput
+// (sau are valori proprii dacă nu există încă), Output raportează un pas anterior, iar Display
+// afișează primele linii ale unui pas cu fișier. Pașii cu fișiere folosesc fișierele date.
+template <typename Sink>
+void generateSyntheticSteps(size_t count, const double *mix, const string &textFile, const string &csvFile,
+                            uint32_t seed, Sink &&sink) {
+    static const char *const operations[] = {"+", "-", "*", "/", "min", "max", "count", "mean"};
+    mt19937 generator(seed);
+    discrete_distribution<size_t> kinds(mix, mix + stepKindCount);
+    vector<size_t> numberSteps;  // Numerele pașilor NumberInput generați
+    vector<size_t> fileSteps;    // Numerele pașilor TextFileInput, CSVFileInput și Output generați
+    for (size_t i = 0; i < count; ++i) {
+        size_t stepNumber = i + 1;
+        switch (static_cast<StepKind>(kinds(generator))) {
+            case StepKind::Title:
+                sink(TitleStep("Titlu " + to_string(stepNumber), "Subtitlu"));
+                break;
+            case StepKind::Text:
+                sink(TextStep("Titlu", "Copia pasului " + to_string(stepNumber)));
+                break;
+            case StepKind::TextInput: {
+                TextInputStep step("Descriere");
+                step.setInput("text " + to_string(stepNumber));
+                sink(move(step));
+                break;
+            }
+            case StepKind::NumberInput: {
+                NumberInputStep step("Valoare");
+                step.setInput(static_cast<float>(generator() % 1000) + 1);
+                numberSteps.push_back(stepNumber);
+                sink(move(step));
+                break;
+            }
+            case StepKind::Calculus: {
+                CalculusStep step(0);
+                step.setOperation(operations[generator() % size(operations)]);
+                if (numberSteps.empty()) {
+                    step.setInputs({1, 2, 3});
+                } else {
+                    step.setInputSteps({numberSteps[generator() % numberSteps.size()], numberSteps.back()});
+                }
+                sink(move(step));
+                break;
+            }
+            case StepKind::TextFileInput:
+                fileSteps.push_back(stepNumber);
+                sink(TextFileInputStep(textFile));
+                break;
+            case StepKind::CSVFileInput:
+                fileSteps.push_back(stepNumber);
+                sink(CSVFileInputStep(csvFile));
+                break;
+            case StepKind::Output:
+                fileSteps.push_back(stepNumber);
+                sink(OutputStep(textFile + "_raport" + to_string(generator() % 4), i > 0 ? generator() % i + 1 : 1, "Raport"));
+                break;
+            default: {
+                DisplayRange range;
+                range.mode = DisplayMode::Head;
+                range.count = 10;
+                sink(DisplayStep(fileSteps.empty() ? 1 : fileSteps[generator() % fileSteps.size()], range));
+                break;
+            }
         }
     }
+}
 
-    void writeToFile(ofstream &file) const
-    {   
-        file << "TextInputStep" << endl;
-        file << "Descriere: " << description << endl;
-        if (hasUserInput) {
-            file << "Input: " << text_input << endl;
-        }   
+// Eșantioanele unui benchmark, în nanosecunde pe element
+struct BenchmarkResult {
+    string name;
+    string unit;     // Elementul măsurat: pas, apel, fisier, octet...
+    size_t items;    // Elemente pe eșantion
+    vector<double> samples;
+
+    double percentile(double q) const {
+        vector<double> sorted = samples;
+        sort(sorted.begin(), sorted.end());
+        size_t rank = static_cast<size_t>(ceil(q * sorted.size()));
+        return sorted[rank > 0 ? rank - 1 : 0];
     }
 };
 
-class DisplayStep : public Step {
+// Suita de benchmark-uri pentru căile principale ale aplicației, pe un flow sintetic și pe fișiere
+// generate local. Fiecare benchmark este rulat de `repeat` ori; rezultatele (min, mediana, p99 și
+// media, în ns pe element) sunt scrise ca CSV sau JSON, pentru a fi comparate între versiuni.
+class BenchmarkSuite {
+public:
+    explicit BenchmarkSuite(const BenchmarkSuiteOptions &options) : options(options) {}
+
+    int run() {
+        generateFiles();
+        NullBuffer nullBuffer;
+        ostream discard(&nullBuffer);
+        streambuf *consoleBuffer = cout.rdbuf(&nullBuffer);  // Mesajele pașilor nu sunt afișate
+        try {
+            runFlowBenchmarks(discard);
+            runCalculusBenchmarks(discard);
+            runFileBenchmarks(discard);
+        } catch (...) {
+            cout.rdbuf(consoleBuffer);
+            removeFiles();
+            throw;
+        }
+        cout.rdbuf(consoleBuffer);
+        removeFiles();
+
+        if (options.output.empty()) {
+            writeResults(cout);
+            return 0;
+        }
+        ofstream file(options.output, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cerr << "Eroare la crearea fisierului " << options.output << endl;
+            return 1;
+        }
+        writeResults(file);
+        return file ? 0 : 1;
+    }
+
 private:
-    size_t stepNumber;
+    BenchmarkSuiteOptions options;
+    vector<BenchmarkResult> results;
+    const string textFile = "bench_suite_text";  // Fără extensie, ca în pași
+    const string csvFile = "bench_suite_csv";
+    const string flowCsvFile = "bench_suite_flow";  // CSV mic, încărcat de pașii flow-ului sintetic
 
-public:
-    DisplayStep(size_t stepNum) : stepNumber(stepNum) {}
+    bool selected(const string &name) const {
+        return options.filter.empty() || name.find(options.filter) != string::npos;
+    }
 
-    string getStepName() override {
-        return "Display Step";
+    // Rulează `body` de `repeat` ori; `prepare` este apelat înaintea fiecărui eșantion, fără a fi măsurat
+    template <typename Prepare, typename Body>
+    void measure(const string &name, const string &unit, size_t items, Prepare &&prepare, Body &&body) {
+        if (!selected(name)) {
+            return;
+        }
+        BenchmarkResult result{name, unit, std::max<size_t>(items, 1), {}};
+        for (size_t sample = 0; sample < options.repeat; ++sample) {
+            prepare();
+            auto start = chrono::steady_clock::now();
+            body();
+            result.samples.push_back(static_cast<double>(elapsedNanoseconds(start)) / result.items);
+        }
+        results.push_back(move(result));
     }
 
-    void specifyStepNumber() {
-        cout << "Introduceti numarul pasului pentru care doriti sa afisati continutul: ";
-        cin >> stepNumber;
+    template <typename Body>
+    void measure(const string &name, const string &unit, size_t items, Body &&body) {
+        measure(name, unit, items, [] {}, forward<Body>(body));
+    }
+
+    void generateFiles() {
+        mt19937 generator(options.seed);
+        string buffer;
+        {
+            ofstream text(textFile + ".txt", ios::binary | ios::trunc);
+            while (buffer.size() < options.textBytes) {
+                buffer += "Linia " + to_string(generator()) + " din fisierul generat pentru benchmark\n";
+            }
+            text.write(buffer.data(), static_cast<streamsize>(options.textBytes));
+        }
+        auto writeCsv = [&generator](const string &path, size_t rows) {
+            ofstream csv(path, ios::binary | ios::trunc);
+            string data = "id,valoare,text\n";
+            for (size_t row = 0; row < rows; ++row) {
+                data += to_string(row) + ',' + to_string(generator() % 100000 / 100.0) + ",\"text, cu separator\"\n";
+            }
+            csv.write(data.data(), static_cast<streamsize>(data.size()));
+        };
+        writeCsv(csvFile + ".csv", options.csvRows);
+        writeCsv(flowCsvFile + ".csv", 1000);
+    }
+
+    void removeFiles() {
+        fileWriter().flush();
+        for (const string &path : {textFile + ".txt", csvFile + ".csv", flowCsvFile + ".csv", textFile + "_creat.txt", csvFile + "_creat.csv",
+                                   textFile + "_iesire.txt"}) {
+            remove(path.c_str());
+        }
+        for (int k = 0; k < 4; ++k) {
+            remove((textFile + "_raport" + to_string(k) + ".txt").c_str());
+        }
+    }
+
+    vector<StepValue> syntheticSteps() const {
+        vector<StepValue> values;
+        values.reserve(options.steps);
+        generateSyntheticSteps(options.steps, options.mix, textFile, flowCsvFile, options.seed,
+                               [&values](auto &&step) { values.emplace_back(move(step)); });
+        return values;
+    }
+
+    Flow syntheticFlow() const {
+        Flow flow("bench_suite");
+        flow.reserveSteps(options.steps);
+        generateSyntheticSteps(options.steps, options.mix, textFile, flowCsvFile, options.seed,
+                               [&flow](auto &&step) { flow.addStep(move(step)); });
+        return flow;
+    }
+
+    void runFlowBenchmarks(ostream &discard) {
+        size_t steps = options.steps;
+        vector<StepValue> values;
+        unique_ptr<Flow> flow;
+        measure("flow_add_step", "pas", steps, [&] { values = syntheticSteps(); flow = make_unique<Flow>("bench_suite"); }, [&] {
+            flow->reserveSteps(values.size());
+            for (StepValue &value : values) {
+                visit([&flow](auto &step) { flow->addStep(move(step)); }, value);
+            }
+        });
+
+        Flow synthetic = syntheticFlow();
+        measure("flow_run", "pas", steps, [&] { synthetic.runFlow(discard); });
+        measure("flow_execute", "pas", steps, [&] { synthetic.execute(discard); });
+        measure("flow_execute_parallel", "pas", steps, [&] { synthetic.execute(discard, &sharedThreadPool()); });
+
+        const StepStore &store = synthetic.getSteps();
+        string text;
+        StringSink textSink(text);
+        measure("step_write_to_file", "pas", steps, [&] { text.clear(); }, [&] {
+            TextWriter writer(textSink);
+            for (size_t i = 0; i < store.size(); ++i) {
+                store[i].writeToFile(writer);
+            }
+        });
+        string encoded;
+        BinaryWriter binary(encoded);
+        measure("step_write_binary", "pas", steps, [&] { encoded.clear(); }, [&] {
+            for (size_t i = 0; i < store.size(); ++i) {
+                store[i].writeBinary(binary);
+            }
+        });
+        encoded.clear();
+        for (size_t i = 0; i < store.size(); ++i) {
+            binary.write<uint8_t>(static_cast<uint8_t>(store.kind(i)));
+            store[i].writeBinary(binary);
+        }
+        vector<StepValue> decoded;
+        measure("step_read_binary", "pas", steps, [&] { decoded.clear(); decoded.reserve(store.size()); }, [&] {
+            BinaryReader in(encoded.data(), encoded.size());
+            for (size_t i = 0; i < store.size(); ++i) {
+                decoded.push_back(readStepBinary(in, FlowCatalog::formatVersion));
+            }
+        });
+    }
+
+    void runCalculusBenchmarks(ostream &discard) {
+        vector<float> values(options.values);
+        mt19937 generator(options.seed);
+        uniform_real_distribution<float> distribution(0.5f, 1.5f);
+        for (float &value : values) {
+            value = distribution(generator);
+        }
+        const size_t calls = 100;
+        float sink = 0;
+        for (const char *operation : {"+", "-", "*", "/", "min", "max", "count", "mean"}) {
+            CalculusStep step(0);
+            step.setOperation(operation);
+            step.setInputs(values);
+            measure(string("calculus_") + operation, "valoare", calls * values.size(), [&] {
+                for (size_t call = 0; call < calls; ++call) {
+                    sink += step.performCalculation(discard);
+                }
+            });
+        }
+
+        // Expresia este evaluată pe valorile a trei pași, ca în flow-urile reale
+        CalculusStep expression(0);
+        expression.setOperation("(step1 + step2) / max(step3, 1)");
+        expression.setInputs({values[0], values[1], values[2]});
+        measure("calculus_expression", "apel", calls * 1000, [&] {
+            for (size_t call = 0; call < calls * 1000; ++call) {
+                sink += expression.performCalculation(discard);
+            }
+        });
+        discard << sink;
+    }
+
+    void runFileBenchmarks(ostream &discard) {
+        const size_t files = 20;
+        // Un fișier text existent nu este suprascris, deci fișierele sunt șterse înaintea fiecărui eșantion
+        TextFileInputStep textStep(textFile + "_creat");
+        textStep.setDescription(string(4096, 'x'));
+        measure("text_file_create", "fisier", 1, [&] { remove((textFile + "_creat.txt").c_str()); }, [&] {
+            textStep.createFile();
+            textStep.waitForFile();
+        });
+
+        CSVFileInputStep csvStep(csvFile + "_creat");
+        measure("csv_file_create", "fisier", 1, [&] { remove((csvFile + "_creat.csv").c_str()); }, [&] {
+            csvStep.createFile();
+            csvStep.waitForFile();
+        });
+
+        // Raportul include informațiile unui pas Text; timpul cuprinde și scrierea pe firele AsyncFileWriter
+        StepStore reportSteps;
+        reportSteps.push(TextStep("Titlu", string(4096, 'x')));
+        OutputStep output(textFile + "_iesire", 1, "Raport");
+        measure("output_file_create", "fisier", files, [&] {
+            for (size_t i = 0; i < files; ++i) {
+                output.createFile(reportSteps, discard);
+            }
+            fileWriter().flush();
+        });
+
+        StepStore displaySteps;
+        displaySteps.push(TextFileInputStep(textFile));
+        displaySteps.push(CSVFileInputStep(csvFile));
+        size_t csvBytes = static_cast<size_t>(ifstream(csvFile + ".csv", ios::binary | ios::ate).tellg());
+        measure("display_text", "octet", options.textBytes, [&] { DisplayStep(1).displayContent(displaySteps, discard); });
+        measure("display_csv", "octet", csvBytes, [&] { DisplayStep(2).displayContent(displaySteps, discard); });
+        DisplayRange tail;
+        tail.mode = DisplayMode::Tail;
+        tail.count = 100;
+        measure("display_text_tail", "apel", 1, [&] { DisplayStep(1, tail).displayContent(displaySteps, discard); });
+
+        CSVFileInputStep loadStep(csvFile);
+        measure("csv_load", "octet", csvBytes, [&] { loadStep.loadTable(discard); });
+
+        TextFileInputStep analysisStep(textFile);
+        analysisStep.setPattern("ERROR");
+        measure("text_analysis", "octet", options.textBytes, [&] { analysisStep.analyze(discard); });
     }
 
-    void getStepInfo() override {
-        cout << "Numarul pasului pentru afisare: " << stepNumber << endl;
+    void writeResults(ostream &out) const {
+        if (options.format == "json") {
+            out << "{\n  \"steps\": " << options.steps << ",\n  \"repeat\": " << options.repeat << ",\n  \"results\": [";
+            for (size_t i = 0; i < results.size(); ++i) {
+                const BenchmarkResult &result = results[i];
+                out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"unit\": \"" << result.unit
+                    << "\", \"items\": " << result.items << ", \"min_ns\": " << result.percentile(0)
+                    << ", \"median_ns\": " << result.percentile(0.5) << ", \"p99_ns\": " << result.percentile(0.99)
+                    << ", \"mean_ns\": " << accumulate(result.samples.begin(), result.samples.end(), 0.0) / result.samples.size() << "}";
+            }
+            out << "\n  ]\n}\n";
+            return;
+        }
+        out << "benchmark,unit,items,samples,min_ns,median_ns,p99_ns,mean_ns\n";
+        for (const BenchmarkResult &result : results) {
+            out << result.name << ',' << result.unit << ',' << result.items << ',' << result.samples.size() << ','
+                << result.percentile(0) << ',' << result.percentile(0.5) << ',' << result.percentile(0.99) << ','
+                << accumulate(result.samples.begin(), result.samples.end(), 0.0) / result.samples.size() << '\n';
+        }
     }
+};
 
-    void displayContent(const vector<Step *> &steps) const {
-        if (stepNumber >= 1 && stepNumber <= steps.size()) {
-            if (TextFileInputStep *textFileStep = dynamic_cast<TextFileInputStep *>(steps[stepNumber - 1])) {
-                displayFileContent(textFileStep->getFileName() + ".txt");
-            } else if (CSVFileInputStep *csvFileStep = dynamic_cast<CSVFileInputStep *>(steps[stepNumber - 1])) {
-                displayFileContent(csvFileStep->getFileName() + ".csv");
-            } else if (OutputStep *outputStep = dynamic_cast< OutputStep *>(steps[stepNumber - 1])) {
-                displayFileContent(outputStep->getFileName() + ".txt");
+// tema --bench-suite [--steps <n>] [--repeat <n>] [--values <n>] [--text-bytes <n>] [--csv-rows <n>]
+//                    [--mix <Tip=pondere,...>] [--seed <n>] [--format csv|json] [--output <fisier>] [--filter <text>]
+int runBenchmarkSuiteCommand(int argc, char *argv[], int first) {
+    BenchmarkSuiteOptions options;
+    try {
+        for (int i = first; i < argc; ++i) {
+            string option = argv[i];
+            if (i + 1 >= argc) {
+                throw runtime_error("Lipseste valoarea pentru " + option);
+            }
+            // Opțiunile numerice sunt citite ca celelalte --bench-*: un număr pozitiv sau eroare
+            size_t *count = option == "--steps"        ? &options.steps
+                            : option == "--repeat"     ? &options.repeat
+                            : option == "--values"     ? &options.values
+                            : option == "--text-bytes" ? &options.textBytes
+                            : option == "--csv-rows"   ? &options.csvRows
+                                                       : nullptr;
+            if (count != nullptr) {
+                if (!readPositiveArgument(argv, i, *count)) {
+                    return 1;
+                }
+                if (option == "--values" && options.values < 3) {
+                    throw runtime_error("--values trebuie sa fie cel putin 3 (expresia citeste trei valori).");
+                }
+                continue;
+            }
+            string value = argv[++i];
+            if (option == "--mix") {
+                parseStepMix(value, options.mix);
+            } else if (option == "--seed") {
+                if (!parseNumber(value, options.seed)) {
+                    throw runtime_error("Valoare invalida pentru --seed: " + value);
+                }
+            } else if (option == "--format" && (value == "csv" || value == "json")) {
+                options.format = value;
+            } else if (option == "--output") {
+                options.output = value;
+            } else if (option == "--filter") {
+                options.filter = value;
             } else {
-                cout << "Pasul specificat nu este de tipul TextFileInputStep sau CSVFileInputStep." << endl;
+                throw runtime_error("Optiune necunoscuta pentru --bench-suite: " + option + " " + value);
+            }
+        }
+        return BenchmarkSuite(options).run();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
+
+// Scrie statisticile de rulare în fișierul dat la --stats (nimic dacă lipsește)
+void exportAnalytics(const string &path) {
+    if (path.empty()) {
+        return;
+    }
+    if (!flowAnalytics().exportTo(path)) {
+        cerr << "Eroare la scrierea statisticilor in " << path << endl;
+    }
+}
+
+// Benchmark-urile care primesc un singur număr: tema --bench-<nume> <numar>
+struct BenchmarkCommand {
+    const char *option;
+    int (*run)(size_t);
+};
+
+const BenchmarkCommand benchmarkCommands[] = {
+    {"--bench-steps", runStepStorageBenchmark},
+    {"--bench-registry", runRegistryBenchmark},
+    {"--bench-concurrent", runConcurrentRegistryBenchmark},
+    {"--bench-search", runSearchBenchmark},
+    {"--bench-edit", runEditBenchmark},
+    {"--bench-journal", runJournalBenchmark},
+    {"--bench-files", runFileCreationBenchmark},
+    {"--bench-calculus", runCalculusBenchmark},
+    {"--bench-csv", runCsvBenchmark},
+    {"--bench-text", runTextBenchmark},
+    {"--bench-parallel", runParallelBenchmark},
+    {"--bench-dag", runDagBenchmark},
+    {"--bench-incremental", runIncrementalBenchmark},
+    {"--bench-values", runValueTableBenchmark},
+    {"--bench-expression", runExpressionBenchmark},
+    {"--bench-serialize", runSerializationBenchmark},
+};
+
+const BenchmarkCommand *findBenchmarkCommand(const char *option) {
+    for (const BenchmarkCommand &command : benchmarkCommands) {
+        if (strcmp(option, command.option) == 0) {
+            return &command;
+        }
+    }
+    return nullptr;
+}
+
+int main(int argc, char *argv[]) {
+    // Modul non-interactiv: tema --batch <fisier|-> [--quiet]
+    string batchSource;
+    string serveSocket;  // Modul server: tema --serve <socket>
+    string catalogPath = "flows.cat";
+    string statsPath;  // Statisticile de rulare sunt exportate aici la ieșire
+    uint64_t journalLimit = 64 << 20;  // Jurnalul este compactat în catalog peste această dimensiune
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchSource = argv[++i];
+        } else if (strcmp(argv[i], "--catalog") == 0 && i + 1 < argc) {
+            catalogPath = argv[++i];
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--journal-limit") == 0 && i + 1 < argc) {
+            double megabytes;
+            if (!readPositiveArgument(argv, i, megabytes)) {
+                return 1;
+            }
+            // Peste 2^44 MB limita nu mai încape în 64 de biți și este, practic, nelimitată
+            journalLimit = megabytes < 0x1p44 ? static_cast<uint64_t>(megabytes * (1 << 20)) : UINT64_MAX;
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            statsPath = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serveSocket = argv[++i];
+        } else if (strcmp(argv[i], "--client") == 0) {
+            return runClientCommand(argc, argv, i + 1);
+        } else if (strcmp(argv[i], "--load") == 0) {
+            return runLoadCommand(argc, argv, i + 1);
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            if (!readPositiveArgument(argv, i, sharedThreadPoolWorkers)) {
+                return 1;
+            }
+        } else if (const BenchmarkCommand *benchmark = findBenchmarkCommand(argv[i]); benchmark != nullptr && i + 1 < argc) {
+            size_t count;
+            if (!readPositiveArgument(argv, i, count)) {
+                return 1;
             }
+            return benchmark->run(count);
+        } else if (strcmp(argv[i], "--bench-suite") == 0) {
+            return runBenchmarkSuiteCommand(argc, argv, i + 1);
         } else {
-            cout << "Numarul pasului specificat nu exista in flow!" << endl;
+            cerr << "Argument necunoscut: " << argv[i] << endl;
+            printUsage(argv[0]);
+            return 1;
         }
     }
+    if (!batchSource.empty()) {
+        int result = runBatchCommand(batchSource, quiet);
+        fileWriter().flush();
+        exportAnalytics(statsPath);
+        return result;
+    }
+    if (!serveSocket.empty()) {
+        int result = runServer(serveSocket);
+        fileWriter().flush();
+        exportAnalytics(statsPath);
+        return result;
+    }
 
-    void displayFileContent(const string &fileName) const {
-    ifstream file(fileName);
-    if (file.is_open()) {
-        string line;
-        while (getline(file, line)) {
-            cout << line << endl;
+    // Flow-urile salvate rămân în catalogul mapat; `flows` conține doar flow-urile create în sesiune.
+    // Numerotarea din meniu: 1..catalog.size() pentru cele salvate, apoi cele din sesiune.
+    FlowCatalog catalog;
+    FlowRegistry flows;
+    bool canSaveCatalog = true;
+    try {
+        if (catalog.open(catalogPath)) {
+            cout << "Catalog incarcat: " << catalog.size() << " flow-uri salvate." << endl;
         }
-        file.close();
-    } else {
-        // Am adăugat un bloc try-catch pentru a gestiona excepția în caz de eroare la deschiderea fișierului
+    } catch (const exception &e) {
+        cerr << "Eroare la citirea catalogului '" << catalogPath << "': " << e.what() << endl;
+        cerr << "Catalogul nu va fi suprascris la iesire." << endl;
+        catalog.close();
+        canSaveCatalog = false;
+    }
+
+    // Modificările de după ultima salvare a catalogului sunt reluate din jurnal, apoi jurnalul
+    // rămâne deschis pentru modificările din această sesiune
+    const string journalPath = catalogPath + ".journal";
+    FlowJournal journal;
+    JournalFlowIds journalIds;
+    journalIds.reset(catalog.size());
+    bool upgradeJournal = false;
+    if (canSaveCatalog) {
+        NullBuffer nullBuffer;
+        ostream discard(&nullBuffer);
+        FlowJournal::ReplayStats replayed = FlowJournal::replay(journalPath, catalog.getGeneration(),
+                                                                [&](FlowJournal::RecordType type, BinaryReader &in, uint32_t version) {
+                                                                    applyJournalRecord(type, in, version, catalog, flows, journalIds, discard);
+                                                                });
+        if (replayed.records > 0 || replayed.tornTail) {
+            cout << "Jurnal reluat: " << replayed.records << " modificari in " << replayed.seconds * 1e3 << " ms" << endl;
+        }
+        if (replayed.tornTail) {
+            cout << "Ultima inregistrare din jurnal era incompleta si a fost ignorata." << endl;
+        }
+        if (replayed.failed > 0) {
+            cerr << replayed.failed << " inregistrari din jurnal nu au putut fi aplicate." << endl;
+        }
+        // Un jurnal dintr-o versiune mai veche nu primește înregistrări noi: este salvat în catalog
+        // imediat ce catalogul poate fi scris (mai jos), altfel este înlocuit cu unul gol
+        upgradeJournal = replayed.records > 0 && replayed.version != FlowJournal::formatVersion;
+        size_t keptBytes = replayed.version == FlowJournal::formatVersion || upgradeJournal ? replayed.bytes : 0;
+        if (!journal.open(journalPath, catalog.getGeneration(), keptBytes)) {
+            cerr << "Eroare la deschiderea jurnalului " << journalPath << "; modificarile nu vor fi jurnalizate." << endl;
+        }
+    }
+
+    // Toate flow-urile din meniu; construit la prima căutare, apoi actualizat la creare, editare și ștergere
+    MenuFlowIndex searchIndex(catalog, flows);
+
+    // Salvează toate flow-urile în catalog și golește jurnalul (compactare)
+    auto compactJournal = [&]() {
         try {
-            throw runtime_error("Eroare la deschiderea fisierului pentru afisare!");
+            uint32_t generation = catalog.save(catalogPath, flows);
+            catalog.open(catalogPath);
+            flows = FlowRegistry();
+            journalIds.reset(catalog.size());
+            searchIndex.reset();
+            if (!journal.reset(generation)) {
+                cerr << "Eroare la golirea jurnalului " << journalPath << endl;
+            }
+            cout << "Jurnalul a fost compactat in " << catalogPath << "; flow-urile au fost renumerotate." << endl;
         } catch (const exception &e) {
-            cerr << e.what() << endl;
+            cerr << "Eroare la compactarea jurnalului: " << e.what() << endl;
         }
-    }
-}
+    };
 
-    void writeToFile(ofstream &file) const {
-        file << "DisplayStep" << endl;
-        file << "Numarul pasului pentru afisare: " << stepNumber << endl;
+    if (upgradeJournal) {
+        compactJournal();
     }
-};
 
-int main() {
-    vector<Flow> flows;
+    // Scrie o modificare în jurnal și așteaptă să ajungă pe disc
+    auto journalChange = [&](FlowJournal::RecordType type, const string &data) {
+        if (!journal.isOpen()) {
+            return;
+        }
+        if (!journal.waitDurable(journal.append(type, data))) {
+            cerr << "Eroare la scrierea jurnalului " << journalPath << endl;
+        }
+        if (journal.size() > journalLimit) {
+            compactJournal();
+        }
+    };
+
     int choice;
 
     do {
@@ -658,15 +11386,30 @@ int main() {
         cout << "3. Editeaza un flow existent" << endl;
         cout << "4. Sterge un flow" << endl;
         cout << "5. Iesire din aplicatie" << endl;
+        cout << "6. Ruleaza un flow" << endl;
+        cout << "7. Statistici de rulare" << endl;
+        cout << "8. Cauta flow-uri" << endl;
         cout << "Alege o optiune: ";
         cin >> choice;
 
         switch (choice) {
             case 1:
-                if (!flows.empty()) {
+                if (catalog.liveCount() + flows.size() > 0) {
                     cout << "\nLista de flow-uri existente:" << endl;
-                    for (const Flow &flow : flows) {
-                        flow.displayFlowInfo();
+                    for (size_t i = 0; i < catalog.size(); ++i) {
+                        if (!catalog.isDeleted(i)) {
+                            cout << (i + 1) << ". ";
+                            try {
+                                catalog.displayFlowInfo(i);
+                            } catch (const exception &e) {
+                                // Înregistrările sunt verificate la citire (readRecord), nu la deschidere
+                                cout << "Inregistrare invalida in catalog: " << e.what() << endl;
+                            }
+                        }
+                    }
+                    for (size_t i = 0; i < flows.size(); ++i) {
+                        cout << (catalog.size() + i + 1) << ". ";
+                        flows.at(i).displayFlowInfo();
                     }
                 } else {
                     cout << "Nu exista flow-uri create." << endl;
@@ -682,147 +11425,301 @@ int main() {
 
                 Flow newFlow(flowName + " - " + creationTime);
 
-                vector<string> stepTypes = {"Title", "Text", "TextInput", "NumberInput", "Calculus", "TextFileInput", "CSVFileInput", "Output", "Display", "End"};
-
-                for (const string &stepType : stepTypes) {
+                for (const StepTypeInfo &stepType : stepTypeTable) {
                     while (true) {
-                        cout << "Doriti sa adaugati un step de tip " << stepType << " sau sa dati skip spre urmatorul step? (Introduceti da/skip): ";
+                        cout << "Doriti sa adaugati un step de tip " << stepType.keyword << " (" << stepType.description
+                             << ") sau sa dati skip spre urmatorul step? (Introduceti da/skip): ";
                         string userChoice;
                         cin >> userChoice;
 
                         if (userChoice == "da") {
-                            if (stepType == "Title") {
-                                string title, subtitle;
-                                cout << "Introduceti titlul: ";
-                                cin >> title;
-                                cout << "Introduceti subtitlul: ";
-                                cin >> subtitle;
-                                newFlow.addStep(new TitleStep(title, subtitle));
-                            } else if (stepType == "Text") {
-                                string title, copy;
-                                cout << "Introduceti titlul: ";
-                                cin >> title;
-                                cout << "Introduceti copia: ";
-                                cin >> copy;
-                                newFlow.addStep(new TextStep(title, copy));
-                            } else if (stepType == "TextInput") {
-                                string description;
-                                cout << "Introduceti descrierea: ";
-                                cin.ignore();
-                                getline(cin, description);
-                                TextInputStep *textInputStep = new TextInputStep(description);
-                                newFlow.addStep(textInputStep);
-                            } else if (stepType == "NumberInput") {
-                                NumberInputStep *numberInputStep = new NumberInputStep("");
-                                numberInputStep->inputDescription();
-                                newFlow.addStep(numberInputStep);
-                            } else if (stepType == "Calculus") {
-                                int numSteps;
-                                cout << "Introduceti numarul de pasi pentru CalculusStep: ";
-                                cin >> numSteps;
-                                CalculusStep *calculusStep = new CalculusStep(numSteps);
-                                newFlow.addStep(calculusStep);
-                            } else if (stepType == "TextFileInput") {
-                                string fileName;
-                                cout << "Introduceti numele fisierului pentru TextFileInputStep: ";
-                                cin >> fileName;
-                                TextFileInputStep *textFileInputStep = new TextFileInputStep(fileName);
-                                newFlow.addStep(textFileInputStep);
-                                textFileInputStep->createFile();
-                            } else if (stepType == "CSVFileInput") {
-                                string fileName;
-                                cout << "Introduceti numele fisierului pentru CSVFileInputStep: ";
-                                cin >> fileName;
-                                CSVFileInputStep *csvFileInputStep = new CSVFileInputStep(fileName);
-                                newFlow.addStep(csvFileInputStep);
-                                // După ce ai adăugat descrierea, poți să creezi și fișierul CSV
-                                csvFileInputStep->createFile();
-                            } else if (stepType == "Output") {
-                                string fileName;
-                                size_t stepNumber;
-                                string title;
-                                cout << "Introduceti numele fisierului pentru Output Step: ";
-                                cin >> fileName;
-                                cout << "Introduceti numarul step-ului din flow pentru care doriti informatiile: ";
-                                cin >> stepNumber;
-                                cout << "Introduceti titlul pentru prima linie din fisier: ";
-                                cin.ignore();
-                                getline(cin, title);
-
-                                OutputStep *outputStep = new OutputStep(fileName, stepNumber, title);
-                                newFlow.addStep(outputStep);
-                                // Specifică informațiile și creează fișierul text
-                                outputStep->createFile(newFlow.getSteps());
-                            } else if (stepType == "Display") {
-                                size_t stepNumber;
-                                cout << "Introduceti numarul pasului pentru Display Step: ";
-                                cin >> stepNumber;
-                                DisplayStep *displayStep = new DisplayStep(stepNumber);
-                                newFlow.addStep(displayStep);
-                                // Afiseaza informatiile despre pas si continutul fisierului
-                                displayStep->displayContent(newFlow.getSteps());
-                            }   if (stepType == "End") {
+                            switch (stepType.kind) {
+                                case StepKind::Title: {
+                                    string title, subtitle;
+                                    cout << "Introduceti titlul: ";
+                                    cin >> title;
+                                    cout << "Introduceti subtitlul: ";
+                                    cin >> subtitle;
+                                    newFlow.addStep(TitleStep(title, subtitle));
+                                    break;
+                                }
+                                case StepKind::Text: {
+                                    string title, copy;
+                                    cout << "Introduceti titlul: ";
+                                    cin >> title;
+                                    cout << "Introduceti copia: ";
+                                    cin >> copy;
+                                    newFlow.addStep(TextStep(title, copy));
+                                    break;
+                                }
+                                case StepKind::TextInput: {
+                                    string description;
+                                    cout << "Introduceti descrierea: ";
+                                    cin.ignore();
+                                    getline(cin, description);
+                                    newFlow.addStep(TextInputStep(description));
+                                    break;
+                                }
+                                case StepKind::NumberInput: {
+                                    NumberInputStep numberInputStep("");
+                                    numberInputStep.inputDescription();
+                                    newFlow.addStep(move(numberInputStep));
+                                    break;
+                                }
+                                case StepKind::Calculus: {
+                                    string source;
+                                    cout << "Sursa valorilor pentru CalculusStep (valori/pasi/csv/text/expresie): ";
+                                    cin >> source;
+                                    if (source == "expresie") {
+                                        CalculusStep calculusStep(0);
+                                        if (calculusStep.specifyExpression()) {
+                                            newFlow.addStep(move(calculusStep));
+                                            size_t position = newFlow.getSteps().size() - 1;
+                                            if (newFlow.calculateStep(position)) {
+                                                cout << "Rezultat: " << newFlow.calculusResult(position) << endl;
+                                            }
+                                        }
+                                    } else if (source == "pasi") {
+                                        CalculusStep calculusStep(0);
+                                        calculusStep.specifyOperation();
+                                        size_t inputCount;
+                                        cout << "Din cati pasi (NumberInput sau Calculus) se iau valorile? ";
+                                        cin >> inputCount;
+                                        vector<size_t> inputSteps(inputCount);
+                                        for (size_t i = 0; i < inputCount; ++i) {
+                                            cout << "Numarul step-ului " << (i + 1) << ": ";
+                                            cin >> inputSteps[i];
+                                        }
+                                        calculusStep.setInputSteps(inputSteps);
+                                        newFlow.addStep(move(calculusStep));
+                                        size_t position = newFlow.getSteps().size() - 1;
+                                        if (newFlow.calculateStep(position)) {
+                                            cout << "Rezultat: " << newFlow.calculusResult(position) << endl;
+                                        }
+                                    } else if (source == "csv" || source == "text") {
+                                        CalculusStep calculusStep(0);
+                                        calculusStep.specifyOperation();
+                                        calculusStep.specifyColumnSource();
+                                        newFlow.addStep(move(calculusStep));
+                                        size_t position = newFlow.getSteps().size() - 1;
+                                        if (newFlow.calculateStep(position)) {
+                                            cout << "Rezultat: " << newFlow.calculusResult(position) << endl;
+                                        }
+                                    } else {
+                                        int numSteps;
+                                        cout << "Introduceti numarul de pasi pentru CalculusStep: ";
+                                        cin >> numSteps;
+                                        newFlow.addStep(CalculusStep(numSteps));
+                                    }
+                                    break;
+                                }
+                                case StepKind::TextFileInput: {
+                                    string fileName;
+                                    cout << "Introduceti numele fisierului pentru TextFileInputStep: ";
+                                    cin >> fileName;
+                                    TextFileInputStep &textFileInputStep = newFlow.addStep(TextFileInputStep(fileName));
+                                    cin.ignore();
+                                    textFileInputStep.specifyPattern();
+                                    textFileInputStep.createFile();
+                                    textFileInputStep.analyze();
+                                    newFlow.publishValue(newFlow.getSteps().size() - 1);
+                                    break;
+                                }
+                                case StepKind::CSVFileInput: {
+                                    string fileName;
+                                    cout << "Introduceti numele fisierului pentru CSVFileInputStep: ";
+                                    cin >> fileName;
+                                    CSVFileInputStep &csvFileInputStep = newFlow.addStep(CSVFileInputStep(fileName));
+                                    // După ce ai adăugat descrierea, poți să creezi și fișierul CSV
+                                    csvFileInputStep.createFile();
+                                    csvFileInputStep.loadTable();
+                                    newFlow.publishValue(newFlow.getSteps().size() - 1);
+                                    break;
+                                }
+                                case StepKind::Output: {
+                                    string fileName;
+                                    size_t stepNumber;
+                                    string title;
+                                    cout << "Introduceti numele fisierului pentru Output Step: ";
+                                    cin >> fileName;
+                                    cout << "Introduceti numarul step-ului din flow pentru care doriti informatiile (0 pentru un sablon de raport): ";
+                                    cin >> stepNumber;
+                                    string templateFile;
+                                    if (stepNumber == 0) {
+                                        cout << "Introduceti fisierul sablonului de raport: ";
+                                        cin >> templateFile;
+                                    }
+                                    cout << "Introduceti titlul pentru prima linie din fisier: ";
+                                    cin.ignore();
+                                    getline(cin, title);
+
+                                    OutputStep outputStepValue(fileName, stepNumber, title);
+                                    if (!templateFile.empty()) {
+                                        outputStepValue.setTemplateFile(templateFile);
+                                    }
+                                    OutputStep &outputStep = newFlow.addStep(move(outputStepValue));
+                                    // Specifică informațiile și creează fișierul text
+                                    outputStep.createFile(newFlow.getSteps());
+                                    break;
+                                }
+                                case StepKind::Display: {
+                                    size_t stepNumber;
+                                    cout << "Introduceti numarul pasului pentru Display Step: ";
+                                    cin >> stepNumber;
+                                    DisplayStep displayStepValue(stepNumber);
+                                    displayStepValue.specifyRange();
+                                    DisplayStep &displayStep = newFlow.addStep(move(displayStepValue));
+                                    // Afiseaza informatiile despre pas si continutul fisierului
+                                    displayStep.displayContent(newFlow.getSteps());
+                                    break;
+                                }
+                                case StepKind::End: {
                                     string userChoice;
                                     while (true) {
                                         cout << "Introduceti 'da' pentru a adauga EndStep si pentru a termina de creat flow-ul: ";
                                         cin >> userChoice;
 
                                         if (userChoice == "da") {
-                                            EndStep *endStep = new EndStep();
-                                            newFlow.addStep(endStep);
+                                            newFlow.addStep(EndStep());
                                             break;  // Ieșim din buclă dacă utilizatorul a introdus "da"
                                         } else {
                                             cout << "Optiune invalida. 'da' este obligatoriu pentru a adauga EndStep." << endl;
                                         }
                                     }
-                                    break;  // Ieșim din buclă pentru a trece la următorul flow
+                                    break;
+                                }
+                                default: {
+                                    // Tipurile fără formular propriu se introduc în formatul din modul batch
+                                    string line;
+                                    cout << "Introduceti campurile pasului " << stepType.keyword << ", separate prin '|': ";
+                                    cin.ignore();
+                                    getline(cin, line);
+                                    try {
+                                        newFlow.addStep(buildStep(stepType.keyword, splitFields(line)));
+                                    } catch (const exception &e) {
+                                        cout << "Eroare: " << e.what() << endl;
+                                    }
+                                    break;
                                 }
-                            } else if (userChoice == "skip") {
-                                break;  // Ieșim din buclă pentru a trece la următorul tip de pas
-                            } else {
-                                cout << "Optiune invalida. Te rog sa reintroduci optiunea." << endl;
                             }
+                            if (stepType.kind == StepKind::End) {
+                                break;  // Ieșim din buclă pentru a trece la următorul flow
+                            }
+                        } else if (userChoice == "skip") {
+                            flowAnalytics().stepExecution(stepType.kind).skip();
+                            break;  // Ieșim din buclă pentru a trece la următorul tip de pas
+                        } else {
+                            cout << "Optiune invalida. Te rog sa reintroduci optiunea." << endl;
                         }
                     }
+                }
 
-                flows.push_back(newFlow);
+                FlowHandle handle = flows.insert(move(newFlow));
+                searchIndex.addSession(handle, *flows.find(handle));
+                journalIds.addSession(handle);
+                journalChange(FlowJournal::RecordType::CreateFlow, FlowJournal::encodeFlow(*flows.find(handle)));
 
                 cout << "Flow creat cu succes!" << endl;
                 break;
             }
             case 3:
-                if (!flows.empty()) {
-                    cout << "Alege un flow pentru editare (1-" << flows.size() << "): ";
-                    size_t flowIndex;
-                    cin >> flowIndex;
+                if (catalog.liveCount() + flows.size() > 0) {
+                    cout << "Alege un flow pentru editare (1-" << catalog.size() + flows.size() << " sau inceputul numelui): ";
+                    size_t flowIndex = readFlowChoice(searchIndex, catalog, flows);
 
-                    if (flowIndex >= 1 && flowIndex <= flows.size()) {
-                        cout << "Editare flow " << flows[flowIndex - 1].getFlowName() << endl;
+                    Flow *flow = nullptr;
+                    FlowHandle handle;
+                    if (flowIndex >= 1 && flowIndex <= catalog.size() && !catalog.isDeleted(flowIndex - 1)) {
+                        // Un flow salvat este mutat în sesiune; versiunea editată este salvată la ieșire
+                        try {
+                            handle = flows.insert(catalog.loadFlow(flowIndex - 1));
+                            catalog.markDeleted(flowIndex - 1);
+                            flow = flows.find(handle);
+                            searchIndex.removeSaved(flowIndex - 1);
+                            searchIndex.addSession(handle, *flow);
+                            journalIds.addSession(handle, flowIndex - 1);
+                            cout << "Flow-ul a fost mutat in sesiune cu numarul " << catalog.size() + flows.size() << "." << endl;
+                        } catch (const exception &e) {
+                            cerr << "Eroare la citirea flow-ului din catalog: " << e.what() << endl;
+                        }
+                    } else if (flowIndex > catalog.size() && flowIndex <= catalog.size() + flows.size()) {
+                        handle = flows.handleAt(flowIndex - catalog.size() - 1);
+                        flow = flows.find(handle);
                     } else {
                         cout << "Alegere invalida." << endl;
                     }
+
+                    string mode;
+                    if (flow != nullptr) {
+                        cout << "Editare flow " << flow->getFlowName() << endl;
+                        cout << "Editati valorile pasilor de intrare sau pasii flow-ului? (valori/pasi): ";
+                        cin >> mode;
+                    }
+                    if (flow != nullptr && mode == "pasi") {
+                        if (editFlowSteps(*flow)) {
+                            searchIndex.addSession(handle, *flow);
+                            journalChange(FlowJournal::RecordType::ReplaceFlow, FlowJournal::encodeFlow(*flow, journalIds.idOf(handle)));
+                        }
+                    } else if (flow != nullptr) {
+                        const StepStore &steps = flow->getSteps();
+                        for (size_t i = 0; i < steps.size(); ++i) {
+                            if (steps.kind(i) == StepKind::NumberInput) {
+                                cout << (i + 1) << ". " << steps.as<NumberInputStep>(i).getDescription() << " = " << steps.as<NumberInputStep>(i).getNumberInput() << endl;
+                            } else if (steps.kind(i) == StepKind::TextInput) {
+                                cout << (i + 1) << ". " << steps.as<TextInputStep>(i).getDescription() << " = " << steps.as<TextInputStep>(i).getTextInput() << endl;
+                            }
+                        }
+                        size_t stepNumber;
+                        cout << "Alege step-ul de intrare pentru modificare: ";
+                        cin >> stepNumber;
+                        try {
+                            size_t recomputed;
+                            if (stepNumber >= 1 && stepNumber <= steps.size() && steps.kind(stepNumber - 1) == StepKind::TextInput) {
+                                string value;
+                                cout << "Valoarea noua: ";
+                                cin >> ws;
+                                getline(cin, value);
+                                recomputed = flow->setTextInput(stepNumber - 1, value);
+                                journalChange(FlowJournal::RecordType::SetTextInput,
+                                              FlowJournal::encodeTextInput(journalIds.idOf(handle), stepNumber - 1, value));
+                            } else {
+                                float value;
+                                cout << "Valoarea noua: ";
+                                cin >> value;
+                                recomputed = flow->setNumberInput(stepNumber - 1, value);
+                                journalChange(FlowJournal::RecordType::SetNumberInput,
+                                              FlowJournal::encodeNumberInput(journalIds.idOf(handle), stepNumber - 1, value));
+                            }
+                            cout << "Pasi recalculati: " << recomputed << endl;
+                        } catch (const exception &e) {
+                            cout << e.what() << endl;
+                        }
+                    }
                 } else {
                     cout << "Nu exista flow-uri create." << endl;
                 }
                 break;
             case 4:
-                if (!flows.empty()) {
-                    cout << "Alege un flow pentru stergere (1-" << flows.size() << "): ";
-                    size_t flowIndex;
-                    cin >> flowIndex;
-
-                    if (flowIndex >= 1 && flowIndex <= flows.size()) {
-                        // Construim un nou vector care exclude flow-ul pe care dorim să-l ștergem
-                        vector<Flow> newFlows;
-                        for (size_t i = 0; i < flows.size(); ++i) {
-                            if (i != flowIndex - 1) {
-                                newFlows.push_back(flows[i]);
-                            }
-                        }
-                        // Schimbăm vectorul vechi cu cel nou
-                        flows = newFlows;
-                        
+                if (catalog.liveCount() + flows.size() > 0) {
+                    cout << "Alege un flow pentru stergere (1-" << catalog.size() + flows.size() << " sau inceputul numelui): ";
+                    size_t flowIndex = readFlowChoice(searchIndex, catalog, flows);
+
+                    if (flowIndex >= 1 && flowIndex <= catalog.size() && !catalog.isDeleted(flowIndex - 1)) {
+                        // Flow-ul salvat este doar marcat ca șters și va fi omis la salvare
+                        catalog.markDeleted(flowIndex - 1);
+                        searchIndex.removeSaved(flowIndex - 1);
+                        flowAnalytics().removeFlow(catalog.flowId(flowIndex - 1));
+                        cout << "Flow sters cu succes!" << endl;
+                        journalChange(FlowJournal::RecordType::DeleteFlow, FlowJournal::encodeDelete(flowIndex - 1));
+                    } else if (flowIndex > catalog.size() && flowIndex <= catalog.size() + flows.size()) {
+                        FlowHandle handle = flows.handleAt(flowIndex - catalog.size() - 1);
+                        uint64_t id = journalIds.idOf(handle);
+                        searchIndex.removeSession(handle);
+                        journalIds.removeSession(handle);
+                        flowAnalytics().removeFlow(flows.find(handle)->getId());
+                        flows.erase(handle);
                         cout << "Flow sters cu succes!" << endl;
+                        journalChange(FlowJournal::RecordType::DeleteFlow, FlowJournal::encodeDelete(id));
                     } else {
                         cout << "Alegere invalida." << endl;
                     }
@@ -831,16 +11728,126 @@ int main() {
                 }
                 break;
             case 5:
-                for (Flow &flow : flows) {
-                    flow.runFlow();
+                // Sunt rulate flow-urile create în sesiune; cele salvate rulează la cerere (opțiunea 6)
+                {
+                    vector<const Flow *> sessionFlows;
+                    for (const Flow &flow : flows) {
+                        sessionFlows.push_back(&flow);
+                    }
+                    runFlowsParallel(sessionFlows, sharedThreadPool(), cout);
+                }
+                if (canSaveCatalog && (!flows.empty() || catalog.hasDeletions())) {
+                    try {
+                        uint32_t generation = catalog.save(catalogPath, flows);
+                        cout << "Flow-urile au fost salvate in " << catalogPath << endl;
+                        // Catalogul conține acum toate modificările din jurnal
+                        if (journal.isOpen() && !journal.reset(generation)) {
+                            cerr << "Eroare la golirea jurnalului " << journalPath << endl;
+                        }
+                    } catch (const exception &e) {
+                        cerr << e.what() << endl;
+                    }
                 }
                 cout << "Iesire din aplicatie. La revedere!" << endl;
                 break;
+            case 6:
+                if (catalog.liveCount() + flows.size() > 0) {
+                    cout << "Alege un flow pentru rulare (1-" << catalog.size() + flows.size() << " sau inceputul numelui): ";
+                    size_t flowIndex = readFlowChoice(searchIndex, catalog, flows);
+
+                    if (flowIndex >= 1 && flowIndex <= catalog.size() && !catalog.isDeleted(flowIndex - 1)) {
+                        try {
+                            Flow flow = catalog.loadFlow(flowIndex - 1);
+                            flow.execute(cout, &sharedThreadPool());
+                        } catch (const exception &e) {
+                            cerr << "Eroare la citirea flow-ului din catalog: " << e.what() << endl;
+                        }
+                    } else if (flowIndex > catalog.size() && flowIndex <= catalog.size() + flows.size()) {
+                        flows.at(flowIndex - catalog.size() - 1).runFlow();
+                    } else {
+                        cout << "Alegere invalida." << endl;
+                    }
+                } else {
+                    cout << "Nu exista flow-uri create." << endl;
+                }
+                break;
+            case 7: {
+                flowAnalytics().writeReport(cout);
+                cout << "Exportati statisticile? (json/csv/nu): ";
+                string format;
+                cin >> format;
+                if (format == "json" || format == "csv") {
+                    string path;
+                    cout << "Numele fisierului: ";
+                    cin >> path;
+                    string extension = "." + format;
+                    if (path.size() < extension.size() || path.compare(path.size() - extension.size(), extension.size(), extension) != 0) {
+                        path += extension;
+                    }
+                    if (flowAnalytics().exportTo(path)) {
+                        cout << "Statisticile au fost scrise in " << path << endl;
+                    } else {
+                        cerr << "Eroare la scrierea fisierului " << path << endl;
+                    }
+                }
+                break;
+            }
+            case 8: {
+                // Condițiile lipsă se dau ca "-"
+                FlowQuery query;
+                string prefix, from, to, kinds;
+                cout << "Inceputul numelui (- pentru oricare): ";
+                cin >> prefix;
+                cout << "Creat incepand cu data AAAA-LL-ZZ (- pentru oricand): ";
+                cin >> from;
+                cout << "Creat pana la data AAAA-LL-ZZ inclusiv (- pentru oricand): ";
+                cin >> to;
+                cout << "Tipuri de pasi continute, separate prin virgula, ex. CSVFileInput,Calculus (- pentru oricare): ";
+                cin >> kinds;
+                if (prefix != "-") {
+                    query.prefix = prefix;
+                }
+                if (from != "-" && (query.from = parseDateTime(from)) == noTimestamp) {
+                    cout << "Data invalida: " << from << endl;
+                    break;
+                }
+                if (to != "-") {
+                    if ((query.to = parseDateTime(to)) == noTimestamp) {
+                        cout << "Data invalida: " << to << endl;
+                        break;
+                    }
+                    query.to += 86399;  // Până la sfârșitul zilei
+                }
+                bool validKinds = true;
+                istringstream kindNames(kinds == "-" ? string() : kinds);
+                string kindName;
+                while (getline(kindNames, kindName, ',')) {
+                    StepKind kind;
+                    if (!parseStepKindKeyword(kindName, kind)) {
+                        cout << "Tip de pas necunoscut: " << kindName << endl;
+                        validKinds = false;
+                        break;
+                    }
+                    query.requiredKinds |= 1u << static_cast<uint8_t>(kind);
+                }
+                if (!validKinds) {
+                    break;
+                }
+
+                FlowIndex &index = searchIndex.get();
+                auto start = chrono::steady_clock::now();
+                vector<FlowIndex::Location> results = index.search(query);
+                double seconds = secondsSince(start);
+                cout << results.size() << " flow-uri gasite din " << index.size() << " (" << seconds * 1e6 << " us)" << endl;
+                displayFlowSearchResults(move(results), catalog, flows, 50);
+                break;
+            }
             default:
                 cout << "Optiune invalida. Te rog sa reintroduci optiunea." << endl;
                 break;
         }
     } while (choice != 5);
 
+    exportAnalytics(statsPath);
     return 0;
 }
\ No newline at end of file